@@ -1,9 +1,17 @@
 import copy
 import pprint
+import threading
 from typing import Optional, List, Dict, Final, Tuple
 
+from app import native
 from app.move import Move
 
+# Position mirrored into the native engine, when it is available, for the
+# move and attack queries. Each query sets it up anew, so one per thread is
+# enough; a shared one could be set up by another thread mid-query, since
+# ctypes releases the GIL during the call.
+_NATIVE_BOARDS = threading.local()
+
 
 class Board:
     """A class representing a chess board with Unicode piece representations.
@@ -94,6 +102,52 @@ class Board:
                 f"halfmove={self.halfmove_clock} "
                 f"fullmove={self.fullmove_number}>")
 
+    def fen(self) -> str:
+        """Generate the FEN of the current position.
+
+        Returns:
+            str: Forsyth-Edwards Notation of the board state.
+        """
+        ranks: List[str] = []
+        for row in self.board:
+            rank, empty = '', 0
+            for cell in row:
+                if cell == '.':
+                    empty += 1
+                    continue
+                if empty:
+                    rank += str(empty)
+                    empty = 0
+                rank += cell
+            ranks.append(rank + (str(empty) if empty else ''))
+
+        castling = ''.join(c for c in 'KQkq' if self.castling.get(c, False))
+        en_passant = '-'
+        if self.en_passant:
+            row, col = self.en_passant
+            en_passant = f'{chr(ord("a") + col)}{8 - row}'
+        return (f'{"/".join(ranks)} {"w" if self.white_turn else "b"} '
+                f'{castling or "-"} {en_passant} '
+                f'{self.halfmove_clock} {self.fullmove_number}')
+
+    def _native(self) -> Optional[native.NativeBoard]:
+        """Set up the position in the native engine.
+
+        Returns:
+            Optional[native.NativeBoard]: The native board, or None if the
+                engine is unavailable or rejects the position, in which case
+                the pure Python implementation is used.
+        """
+        if not native.available():
+            return None
+        engine: Optional[native.NativeBoard] = getattr(_NATIVE_BOARDS,
+                                                       'board', None)
+        if engine is None:
+            engine = _NATIVE_BOARDS.board = native.NativeBoard()
+        if not engine.set_fen(self.fen()):
+            return None
+        return engine
+
     def get(self, rank: int, file: str) -> str:
         """Get piece at specified position using chess coordinates.
 
@@ -228,6 +282,11 @@ class Board:
         if piece == '.':
             return moves  # no piece at this position
 
+        if engine := self._native():
+            return [native.position_of(square) for square in
+                    engine.piece_moves(native.square_of(pos),
+                                       attack_moves_only, validate_pin)]
+
         # Determine side: white pieces are uppercase, black are lowercase.
         is_white = piece.isupper()
 
@@ -437,6 +496,9 @@ class Board:
 
     def is_under_attack(self, pos: Tuple[int, int],
                         white_is_attacking: bool) -> bool:
+        if engine := self._native():
+            return engine.is_attacked(native.square_of(pos),
+                                      white_is_attacking)
         attacking_moves = self.get_all_valid_moves(attack_moves_only=True,
                                                    validate_pins=False)
         for _, v in attacking_moves.items():
@@ -446,6 +508,8 @@ class Board:
         return False
 
     def in_check(self, white: bool) -> bool:
+        if engine := self._native():
+            return engine.in_check(white)
         piece = "K" if white else "k"
         return self.is_under_attack(self.find(piece)[0], not white)
 
@@ -0,0 +1,364 @@
+"""Bindings to the native engine through its C interface.
+
+The shared library is located through the ENGINE_LIBRARY environment
+variable, then in the engine's build directories, then on the system library
+path. When it cannot be found, `available()` is False and the app keeps to
+its pure Python implementation.
+
+Squares are numbered a1 = 0, ..., h8 = 63 and moves are the engine's 16-bit
+encoding; see engine/include/engine/engine_api.h. Batch functions take any
+object supporting the buffer protocol (bytes, bytearray, array.array, NumPy
+arrays) and return NumPy arrays when NumPy is installed, array.array
+otherwise, so a whole batch costs a single call into the engine.
+"""
+import array
+import ctypes
+import ctypes.util
+import glob
+import os
+import sys
+from typing import Final, Iterable, List, Optional, Tuple
+
+try:
+    import numpy
+except ImportError:  # pragma: no cover - NumPy is optional
+    numpy = None
+
+API_VERSION: Final[int] = 1
+PACKED_SIZE: Final[int] = 32
+MAX_MOVES: Final[int] = 256
+FEN_BUFFER_SIZE: Final[int] = 96
+
+_ENGINE_DIR: Final[str] = os.path.join(
+    os.path.dirname(os.path.dirname(os.path.abspath(__file__))), 'engine')
+
+
+class SearchResult(ctypes.Structure):
+    """Mirror of EngineSearchResult."""
+    _fields_ = [
+        ('best_move', ctypes.c_uint16),
+        ('ponder_move', ctypes.c_uint16),
+        ('score', ctypes.c_int32),
+        ('depth', ctypes.c_int32),
+        ('nodes', ctypes.c_uint64),
+    ]
+
+
+def _library_names() -> List[str]:
+    if sys.platform == 'win32':
+        return ['engine.dll', 'libengine.dll']
+    if sys.platform == 'darwin':
+        return ['libengine.dylib']
+    return ['libengine.so']
+
+
+def _candidates() -> Iterable[str]:
+    if os.environ.get('ENGINE_LIBRARY'):
+        yield os.environ['ENGINE_LIBRARY']
+    for name in _library_names():
+        yield from sorted(glob.glob(os.path.join(_ENGINE_DIR, '*build*', name)))
+        yield from sorted(
+            glob.glob(os.path.join(_ENGINE_DIR, '*build*', '*', name)))
+    found = ctypes.util.find_library('engine')
+    if found:
+        yield found
+
+
+def _declare(lib: ctypes.CDLL) -> None:
+    """Declares the signatures of engine_api.h."""
+    c_board = ctypes.c_void_p
+    c_search = ctypes.c_void_p
+    c_buffer = ctypes.c_void_p
+    signatures = {
+        'engine_api_version': (ctypes.c_int, []),
+        'engine_board_new': (c_board, []),
+        'engine_board_free': (None, [c_board]),
+        'engine_board_set_fen': (ctypes.c_int, [c_board, ctypes.c_char_p]),
+        'engine_board_fen': (
+            ctypes.c_size_t, [c_board, ctypes.c_char_p, ctypes.c_size_t]),
+        'engine_board_pack': (None, [c_board, c_buffer]),
+        'engine_board_unpack': (ctypes.c_int, [c_board, c_buffer]),
+        'engine_board_piece': (ctypes.c_int, [c_board, ctypes.c_int]),
+        'engine_board_white_to_move': (ctypes.c_int, [c_board]),
+        'engine_board_make_move': (ctypes.c_int, [c_board, ctypes.c_uint16]),
+        'engine_board_unmake_move': (ctypes.c_int, [c_board]),
+        'engine_board_legal_moves': (
+            ctypes.c_size_t, [c_board, c_buffer, ctypes.c_size_t]),
+        'engine_board_piece_moves': (
+            ctypes.c_size_t,
+            [c_board, ctypes.c_int, ctypes.c_int, ctypes.c_int, c_buffer,
+             ctypes.c_size_t]),
+        'engine_board_attacked': (ctypes.c_uint64, [c_board, ctypes.c_int]),
+        'engine_board_is_attacked': (
+            ctypes.c_int, [c_board, ctypes.c_int, ctypes.c_int]),
+        'engine_board_in_check': (ctypes.c_int, [c_board, ctypes.c_int]),
+        'engine_move_name': (None, [ctypes.c_uint16, ctypes.c_char_p]),
+        'engine_search_new': (c_search, [ctypes.c_size_t]),
+        'engine_search_free': (None, [c_search]),
+        'engine_search_run': (
+            ctypes.c_int,
+            [c_search, c_board, ctypes.c_int, ctypes.c_uint64,
+             ctypes.c_int64, ctypes.POINTER(SearchResult)]),
+        'engine_search_clear': (None, [c_search]),
+        'engine_batch_pack_fens': (
+            ctypes.c_size_t, [ctypes.c_char_p, c_buffer, ctypes.c_size_t]),
+        'engine_batch_legal_moves': (
+            None, [c_buffer, ctypes.c_size_t, c_buffer, c_buffer]),
+        'engine_batch_in_check': (None, [c_buffer, ctypes.c_size_t, c_buffer]),
+        'engine_batch_attacked': (None, [c_buffer, ctypes.c_size_t, c_buffer]),
+        'engine_batch_evaluate': (
+            None, [c_buffer, ctypes.c_size_t, c_buffer]),
+        'engine_batch_perft': (
+            None, [c_buffer, ctypes.c_size_t, ctypes.c_int, c_buffer]),
+    }
+    for name, (restype, argtypes) in signatures.items():
+        function = getattr(lib, name)
+        function.restype = restype
+        function.argtypes = argtypes
+
+
+def _load() -> Optional[ctypes.CDLL]:
+    for path in _candidates():
+        try:
+            lib = ctypes.CDLL(path)
+            _declare(lib)
+        except (OSError, AttributeError):
+            continue
+        if lib.engine_api_version() == API_VERSION:
+            return lib
+    return None
+
+
+_lib: Optional[ctypes.CDLL] = _load()
+
+
+def available() -> bool:
+    """Whether the native engine was loaded."""
+    return _lib is not None
+
+
+def _engine() -> ctypes.CDLL:
+    if _lib is None:
+        raise RuntimeError('The native engine library was not found; set '
+                           'ENGINE_LIBRARY to the path of libengine.')
+    return _lib
+
+
+def square_of(pos: Tuple[int, int]) -> int:
+    """Square index of a (row, col) position, where row 0 is the 8th rank."""
+    return (7 - pos[0]) * 8 + pos[1]
+
+
+def position_of(square: int) -> Tuple[int, int]:
+    """(row, col) position of a square index."""
+    return 7 - square // 8, square % 8
+
+
+def move_name(move: int) -> str:
+    """Long algebraic notation of a move, such as 'e2e4' or 'e7e8q'."""
+    buffer = ctypes.create_string_buffer(6)
+    _engine().engine_move_name(move, buffer)
+    return buffer.value.decode()
+
+
+# ------------------------------- Buffers -------------------------------
+
+def _input(buffer) -> Tuple[ctypes.Array, int]:
+    """A ctypes view of a buffer's bytes and its length, copied only when
+    the buffer is read-only."""
+    view = memoryview(buffer).cast('B')
+    if view.readonly:
+        return (ctypes.c_uint8 * view.nbytes).from_buffer_copy(view), view.nbytes
+    return (ctypes.c_uint8 * view.nbytes).from_buffer(view), view.nbytes
+
+
+def _output(typecode: str, size: int) -> array.array:
+    return array.array(typecode, bytes(size * array.array(typecode).itemsize))
+
+
+def _address(values: array.array) -> int:
+    return values.buffer_info()[0]
+
+
+def _result(values: array.array, shape: Optional[Tuple[int, ...]] = None):
+    """Hands an output buffer to the caller, as a NumPy array if possible."""
+    if numpy is None:
+        return values
+    result = numpy.frombuffer(values, dtype=values.typecode)
+    return result.reshape(shape) if shape else result
+
+
+def _positions(packed) -> Tuple[ctypes.Array, int]:
+    data, size = _input(packed)
+    if size % PACKED_SIZE:
+        raise ValueError(f'Packed positions take {PACKED_SIZE} bytes each; '
+                         f'got {size} bytes.')
+    return data, size // PACKED_SIZE
+
+
+# -------------------------------- Board --------------------------------
+
+class NativeBoard:
+    """A position held by the native engine."""
+
+    def __init__(self, fen: Optional[str] = None) -> None:
+        self._lib = _engine()
+        self._handle = self._lib.engine_board_new()
+        if not self._handle:
+            raise MemoryError('Failed to allocate a native board.')
+        if fen is not None:
+            self.set_fen(fen)
+
+    def __del__(self) -> None:
+        if getattr(self, '_handle', None):
+            self._lib.engine_board_free(self._handle)
+            self._handle = None
+
+    def set_fen(self, fen: str) -> bool:
+        """Sets up a position; returns False (and sets up the start
+        position) if the FEN does not parse."""
+        return bool(self._lib.engine_board_set_fen(self._handle, fen.encode()))
+
+    def fen(self) -> str:
+        buffer = ctypes.create_string_buffer(FEN_BUFFER_SIZE)
+        self._lib.engine_board_fen(self._handle, buffer, FEN_BUFFER_SIZE)
+        return buffer.value.decode()
+
+    def pack(self) -> bytes:
+        packed = (ctypes.c_uint8 * PACKED_SIZE)()
+        self._lib.engine_board_pack(self._handle, packed)
+        return bytes(packed)
+
+    def unpack(self, packed) -> bool:
+        data, size = _input(packed)
+        if size != PACKED_SIZE:
+            raise ValueError(f'A packed position takes {PACKED_SIZE} bytes.')
+        return bool(self._lib.engine_board_unpack(self._handle, data))
+
+    def piece(self, square: int) -> int:
+        """4-bit piece code: type in bits 0-2, bit 3 set for white."""
+        return self._lib.engine_board_piece(self._handle, square)
+
+    @property
+    def white_to_move(self) -> bool:
+        return bool(self._lib.engine_board_white_to_move(self._handle))
+
+    def make_move(self, move: int) -> bool:
+        """Plays a move; returns False if it is not legal."""
+        return bool(self._lib.engine_board_make_move(self._handle, move))
+
+    def unmake_move(self) -> bool:
+        return bool(self._lib.engine_board_unmake_move(self._handle))
+
+    def legal_moves(self):
+        moves = _output('H', MAX_MOVES)
+        count = self._lib.engine_board_legal_moves(self._handle,
+                                                   _address(moves), MAX_MOVES)
+        return _result(moves[:count])
+
+    def piece_moves(self, square: int, attack_moves_only: bool = False,
+                    validate_pin: bool = True) -> List[int]:
+        """Destination squares of the piece on a square, with the semantics
+        of Board.get_valid_moves()."""
+        squares = (ctypes.c_uint8 * 64)()
+        count = self._lib.engine_board_piece_moves(
+            self._handle, square, attack_moves_only, validate_pin, squares,
+            64)
+        return list(squares[:count])
+
+    def attacked(self, by_white: bool) -> int:
+        """Bitboard of the squares a side attacks."""
+        return self._lib.engine_board_attacked(self._handle, by_white)
+
+    def is_attacked(self, square: int, by_white: bool) -> bool:
+        return bool(
+            self._lib.engine_board_is_attacked(self._handle, square, by_white))
+
+    def in_check(self, white: bool) -> bool:
+        return bool(self._lib.engine_board_in_check(self._handle, white))
+
+
+# -------------------------------- Search --------------------------------
+
+class NativeSearch:
+    """A native searcher with its own transposition table."""
+
+    def __init__(self, hash_mb: int = 16) -> None:
+        self._lib = _engine()
+        self._handle = self._lib.engine_search_new(hash_mb)
+        if not self._handle:
+            raise MemoryError('Failed to allocate a native search.')
+
+    def __del__(self) -> None:
+        if getattr(self, '_handle', None):
+            self._lib.engine_search_free(self._handle)
+            self._handle = None
+
+    def run(self, board: NativeBoard, depth: int = 0, nodes: int = 0,
+            movetime_ms: int = 0) -> SearchResult:
+        """Searches until the first non-zero limit is reached."""
+        result = SearchResult()
+        self._lib.engine_search_run(self._handle, board._handle, depth, nodes,
+                                    movetime_ms, ctypes.byref(result))
+        return result
+
+    def clear(self) -> None:
+        self._lib.engine_search_clear(self._handle)
+
+
+# -------------------------------- Batch --------------------------------
+
+def pack_fens(fens: Iterable[str]) -> bytearray:
+    """Packs FENs into consecutive 32-byte positions."""
+    fens = list(fens)
+    packed = bytearray(len(fens) * PACKED_SIZE)
+    data, _ = _input(packed)
+    count = _engine().engine_batch_pack_fens(
+        '\n'.join(fens).encode(), data, len(fens))
+    if count != len(fens):
+        raise ValueError(f'Invalid FEN: {fens[count]!r}')
+    return packed
+
+
+def legal_moves(packed):
+    """Legal moves of each packed position, as a (count, MAX_MOVES) move
+    array and the per-position move counts."""
+    data, count = _positions(packed)
+    moves = _output('H', count * MAX_MOVES)
+    counts = _output('H', count)
+    _engine().engine_batch_legal_moves(data, count, _address(moves),
+                                       _address(counts))
+    return _result(moves, (count, MAX_MOVES)), _result(counts)
+
+
+def in_check(packed):
+    """Whether the side to move is in check, per packed position."""
+    data, count = _positions(packed)
+    checks = _output('B', count)
+    _engine().engine_batch_in_check(data, count, _address(checks))
+    return _result(checks)
+
+
+def attacked(packed):
+    """Bitboards attacked by white and by black, as (count, 2) entries."""
+    data, count = _positions(packed)
+    squares = _output('Q', count * 2)
+    _engine().engine_batch_attacked(data, count, _address(squares))
+    return _result(squares, (count, 2))
+
+
+def evaluate(packed):
+    """Static evaluation in centipawns of each packed position, from the
+    side to move's point of view."""
+    data, count = _positions(packed)
+    scores = _output('i', count)
+    _engine().engine_batch_evaluate(data, count, _address(scores))
+    return _result(scores)
+
+
+def perft(packed, depth: int):
+    """Perft node count of each packed position."""
+    data, count = _positions(packed)
+    nodes = _output('Q', count)
+    _engine().engine_batch_perft(data, count, depth, _address(nodes))
+    return _result(nodes)
@@ -0,0 +1,175 @@
+#ifndef ENGINE_API_H
+#define ENGINE_API_H
+
+/*
+ * Stable C interface to the engine, for bindings such as app/native.py.
+ *
+ * Squares are numbered a1 = 0, b1 = 1, ..., h8 = 63. Moves are the 16-bit
+ * packed form of the C++ Move: source square in bits 0-5, destination in
+ * bits 6-11, promotion piece in bits 12-13 (knight, bishop, rook, queen) and
+ * flag in bits 14-15 (normal, promotion, en passant, castling).
+ *
+ * Batch calls take an array of 32-byte packed positions (see
+ * chess/packed_position.h) and write into caller-provided arrays, so that a
+ * whole batch costs one call and no allocation. No function throws; errors
+ * are reported through return values.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define ENGINE_API __declspec(dllexport)
+#else
+#define ENGINE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a signature or a struct layout changes. */
+#define ENGINE_API_VERSION 1
+
+/* Bytes per packed position in batch calls. */
+#define ENGINE_PACKED_SIZE 32
+
+/* Moves per position in legal move batches; above the maximum of 218. */
+#define ENGINE_MAX_MOVES 256
+
+ENGINE_API int engine_api_version(void);
+
+/* ------------------------------- Boards ------------------------------- */
+
+typedef struct EngineBoard EngineBoard;
+
+/* A board in the start position, or NULL if out of memory. */
+ENGINE_API EngineBoard *engine_board_new(void);
+
+ENGINE_API void engine_board_free(EngineBoard *board);
+
+/* Returns 1 if the FEN was parsed and describes a legal position: one king
+ * per side, no pawn on the 1st or 8th rank, the side not to move not in
+ * check and a possible en passant square. After a failure the position is
+ * the start position. */
+ENGINE_API int engine_board_set_fen(EngineBoard *board, const char *fen);
+
+/* Writes the FEN with a terminating null and returns its length, or 0 if
+ * `size` is too small (96 bytes always suffice). */
+ENGINE_API size_t engine_board_fen(const EngineBoard *board, char *buffer,
+                                   size_t size);
+
+/* Writes the 32-byte packed form of the position. */
+ENGINE_API void engine_board_pack(const EngineBoard *board, uint8_t *packed);
+
+/* Returns 1 if the packed position was well-formed and legal, with the
+ * checks of engine_board_set_fen(). After a failure the position is the
+ * start position. */
+ENGINE_API int engine_board_unpack(EngineBoard *board, const uint8_t *packed);
+
+/* Piece on a square as a 4-bit code: type in bits 0-2 (0 empty, then pawn,
+ * knight, bishop, rook, queen, king) and bit 3 set for white. */
+ENGINE_API int engine_board_piece(const EngineBoard *board, int square);
+
+ENGINE_API int engine_board_white_to_move(const EngineBoard *board);
+
+/* Plays a move if it is legal and returns 1, otherwise returns 0. */
+ENGINE_API int engine_board_make_move(EngineBoard *board, uint16_t move);
+
+/* Takes back the last move played with engine_board_make_move(). Returns 0
+ * if there is none. */
+ENGINE_API int engine_board_unmake_move(EngineBoard *board);
+
+/* Writes up to `capacity` legal moves and returns the total number. */
+ENGINE_API size_t engine_board_legal_moves(const EngineBoard *board,
+                                           uint16_t *moves, size_t capacity);
+
+/* The move-destination query of the original board API, for one piece:
+ * writes up to `capacity` destination squares and returns the total. */
+ENGINE_API size_t engine_board_piece_moves(EngineBoard *board, int square,
+                                           int attack_moves_only,
+                                           int validate_pin, uint8_t *squares,
+                                           size_t capacity);
+
+/* Bitboard of the squares the given side attacks. */
+ENGINE_API uint64_t engine_board_attacked(const EngineBoard *board,
+                                          int by_white);
+
+ENGINE_API int engine_board_is_attacked(const EngineBoard *board, int square,
+                                        int by_white);
+
+/* Whether the given side's king is in check. */
+ENGINE_API int engine_board_in_check(const EngineBoard *board, int white);
+
+/* Writes the move in long algebraic notation ("e2e4", "e7e8q") with a
+ * terminating null; `buffer` must hold 6 bytes. */
+ENGINE_API void engine_move_name(uint16_t move, char *buffer);
+
+/* ------------------------------- Search ------------------------------- */
+
+typedef struct EngineSearch EngineSearch;
+
+typedef struct EngineSearchResult {
+    uint16_t best_move;
+    uint16_t ponder_move;
+    int32_t score;
+    int32_t depth;
+    uint64_t nodes;
+} EngineSearchResult;
+
+/* A searcher with its own transposition table, or NULL on failure. */
+ENGINE_API EngineSearch *engine_search_new(size_t hash_mb);
+
+ENGINE_API void engine_search_free(EngineSearch *search);
+
+/* Searches a position until the first limit is reached; zero limits are
+ * ignored, and without any the search runs to its maximum depth. Returns 0
+ * if the position has no legal move, 1 otherwise. */
+ENGINE_API int engine_search_run(EngineSearch *search,
+                                 const EngineBoard *board, int depth,
+                                 uint64_t nodes, int64_t movetime_ms,
+                                 EngineSearchResult *result);
+
+/* Forgets everything learned so far, e.g. before a new game. */
+ENGINE_API void engine_search_clear(EngineSearch *search);
+
+/* -------------------------------- Batch -------------------------------- */
+
+/* Parses newline-separated FENs into packed positions, writing at most
+ * `capacity` of them. Returns the number written; parsing stops at the
+ * first FEN that engine_board_set_fen() would reject. */
+ENGINE_API size_t engine_batch_pack_fens(const char *fens, uint8_t *packed,
+                                         size_t capacity);
+
+/* Legal moves of each position: `moves` holds count * ENGINE_MAX_MOVES
+ * entries, position i's moves starting at i * ENGINE_MAX_MOVES, and
+ * `counts[i]` receives their number. Positions engine_board_unpack() would
+ * reject get no moves. */
+ENGINE_API void engine_batch_legal_moves(const uint8_t *packed, size_t count,
+                                         uint16_t *moves, uint16_t *counts);
+
+/* Whether the side to move is in check, per position. */
+ENGINE_API void engine_batch_in_check(const uint8_t *packed, size_t count,
+                                      uint8_t *in_check);
+
+/* Squares attacked by white and by black, two entries per position. */
+ENGINE_API void engine_batch_attacked(const uint8_t *packed, size_t count,
+                                      uint64_t *attacked);
+
+/* Static evaluation in centipawns of each position, from the side to move's
+ * point of view; malformed positions score 0. The positions are transposed
+ * into a per-thread buffer and evaluated many at a time in vector
+ * registers. */
+ENGINE_API void engine_batch_evaluate(const uint8_t *packed, size_t count,
+                                      int32_t *scores);
+
+/* Perft node count of each position to the given depth; 0 for positions
+ * engine_board_unpack() would reject. */
+ENGINE_API void engine_batch_perft(const uint8_t *packed, size_t count,
+                                   int depth, uint64_t *nodes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //ENGINE_API_H
@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include "engine/engine_api.h"
+#include "chess/board.h"
+#include "chess/packed_position.h"
+#include "chess/perft.h"
+#include "chess/tt.h"
+#include "eval/batch.h"
+#include "search/search.h"
+
+static_assert(ENGINE_PACKED_SIZE == sizeof(PackedPosition));
+static_assert(ENGINE_MAX_MOVES == MoveList::CAPACITY);
+
+struct EngineBoard {
+    Board board{};
+};
+
+struct EngineSearch {
+    explicit EngineSearch(const std::size_t &hash_mb) : tt{hash_mb} {}
+
+    TranspositionTable tt;
+    Search search{tt};
+};
+
+namespace {
+    PackedPosition packed_at(const uint8_t *packed, const std::size_t &i) {
+        PackedPosition position;
+        std::memcpy(position.bytes.data(), packed + i * ENGINE_PACKED_SIZE,
+                    ENGINE_PACKED_SIZE);
+        return position;
+    }
+
+    bool is_square(const int &square) {
+        return 0 <= square && square < NUM_SQUARES;
+    }
+
+    // Whether move generation can run on the position: the side not to move
+    // must not be in check, or its king could be captured. set_fen() and
+    // unpack() refuse such positions already; it is checked again because
+    // a crash here takes the host process with it.
+    bool playable(const Board &board) {
+        return !board.attackers_to(board.king_square(!board.is_white_turn()),
+                                   board.is_white_turn());
+    }
+
+    // set_fen() and unpack() for positions from callers, accepting only
+    // playable ones.
+    bool set_up(Board &board, const std::string_view &fen) {
+        return board.set_fen(fen) && playable(board);
+    }
+
+    bool set_up(Board &board, const PackedPosition &packed) {
+        return board.unpack(packed) && playable(board);
+    }
+}
+
+extern "C" {
+int engine_api_version() {
+    return ENGINE_API_VERSION;
+}
+
+// ------------------------------- Boards -------------------------------
+
+EngineBoard *engine_board_new() {
+    return new(std::nothrow) EngineBoard{};
+}
+
+void engine_board_free(EngineBoard *board) {
+    delete board;
+}
+
+int engine_board_set_fen(EngineBoard *board, const char *fen) {
+    if (set_up(board->board, fen)) {
+        return 1;
+    }
+    board->board = Board{};
+    return 0;
+}
+
+size_t engine_board_fen(const EngineBoard *board, char *buffer,
+                        const size_t size) {
+    std::array<char, MAX_FEN_LENGTH> fen;
+    const std::size_t length{board->board.write_fen(fen)};
+    if (length + 1 > size) {
+        return 0;
+    }
+    std::copy_n(fen.data(), length, buffer);
+    buffer[length] = '\0';
+    return length;
+}
+
+void engine_board_pack(const EngineBoard *board, uint8_t *packed) {
+    const PackedPosition position{board->board.pack()};
+    std::memcpy(packed, position.bytes.data(), ENGINE_PACKED_SIZE);
+}
+
+int engine_board_unpack(EngineBoard *board, const uint8_t *packed) {
+    if (set_up(board->board, packed_at(packed, 0))) {
+        return 1;
+    }
+    board->board = Board{};
+    return 0;
+}
+
+int engine_board_piece(const EngineBoard *board, const int square) {
+    return is_square(square) ? board->board.piece_on(square).code() : 0;
+}
+
+int engine_board_white_to_move(const EngineBoard *board) {
+    return board->board.is_white_turn() ? 1 : 0;
+}
+
+int engine_board_make_move(EngineBoard *board, const uint16_t move) {
+    if (!board->board.is_legal(Move::from_raw(move))) {
+        return 0;
+    }
+    board->board.make_move(Move::from_raw(move));
+    return 1;
+}
+
+int engine_board_unmake_move(EngineBoard *board) {
+    if (board->board.history().empty()) {
+        return 0;
+    }
+    board->board.unmake_move();
+    return 1;
+}
+
+size_t engine_board_legal_moves(const EngineBoard *board, uint16_t *moves,
+                                const size_t capacity) {
+    MoveList list;
+    board->board.generate_moves(list);
+    for (std::size_t i = 0; i < std::min(list.size(), capacity); ++i) {
+        moves[i] = list[i].raw();
+    }
+    return list.size();
+}
+
+size_t engine_board_piece_moves(EngineBoard *board, const int square,
+                                const int attack_moves_only,
+                                const int validate_pin, uint8_t *squares,
+                                const size_t capacity) {
+    if (!is_square(square)) {
+        return 0;
+    }
+    const auto targets{
+        board->board.get_valid_moves_raw(position_of(square),
+                                         attack_moves_only != 0,
+                                         validate_pin != 0)
+    };
+    for (std::size_t i = 0; i < std::min(targets.size(), capacity); ++i) {
+        squares[i] = static_cast<uint8_t>(square_of(targets[i]));
+    }
+    return targets.size();
+}
+
+uint64_t engine_board_attacked(const EngineBoard *board, const int by_white) {
+    return board->board.attacked_squares(~EMPTY_BB, by_white != 0);
+}
+
+int engine_board_is_attacked(const EngineBoard *board, const int square,
+                             const int by_white) {
+    return is_square(square) &&
+           board->board.is_under_attack(Square{square}, by_white != 0);
+}
+
+int engine_board_in_check(const EngineBoard *board, const int white) {
+    return board->board.in_check(white != 0) ? 1 : 0;
+}
+
+void engine_move_name(const uint16_t move, char *buffer) {
+    const std::string name{Move::from_raw(move).to_string()};
+    std::copy(name.begin(), name.end(), buffer);
+    buffer[name.size()] = '\0';
+}
+
+// ------------------------------- Search -------------------------------
+
+EngineSearch *engine_search_new(const size_t hash_mb) {
+    try {
+        return new EngineSearch{std::max<std::size_t>(hash_mb, 1)};
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void engine_search_free(EngineSearch *search) {
+    delete search;
+}
+
+int engine_search_run(EngineSearch *search, const EngineBoard *board,
+                      const int depth, const uint64_t nodes,
+                      const int64_t movetime_ms, EngineSearchResult *result) {
+    Board position{board->board};
+    SearchLimits limits{};
+    limits.depth = depth;
+    limits.nodes = nodes;
+    limits.movetime_ms = movetime_ms;
+
+    const SearchResult found{search->search.run(position, limits)};
+    *result = EngineSearchResult{
+        found.best_move.raw(), found.ponder_move.raw(), found.score,
+        found.depth, found.nodes
+    };
+    return found.best_move.is_none() ? 0 : 1;
+}
+
+void engine_search_clear(EngineSearch *search) {
+    search->tt.clear();
+    search->search.clear();
+}
+
+// -------------------------------- Batch --------------------------------
+
+size_t engine_batch_pack_fens(const char *fens, uint8_t *packed,
+                              const size_t capacity) {
+    Board board{};
+    std::string_view rest{fens};
+    std::size_t count{0};
+    while (!rest.empty() && count < capacity) {
+        const std::size_t end{std::min(rest.find('\n'), rest.size())};
+        const std::string_view fen{rest.substr(0, end)};
+        rest.remove_prefix(std::min(end + 1, rest.size()));
+        if (fen.empty()) {
+            continue;
+        }
+        if (!set_up(board, fen)) {
+            break;
+        }
+        const PackedPosition position{board.pack()};
+        std::memcpy(packed + count++ * ENGINE_PACKED_SIZE,
+                    position.bytes.data(), ENGINE_PACKED_SIZE);
+    }
+    return count;
+}
+
+void engine_batch_legal_moves(const uint8_t *packed, const size_t count,
+                              uint16_t *moves, uint16_t *counts) {
+    Board board{};
+    MoveList list;
+    for (std::size_t i = 0; i < count; ++i) {
+        counts[i] = 0;
+        if (!set_up(board, packed_at(packed, i))) {
+            continue;
+        }
+        board.generate_moves(list);
+        uint16_t *out{moves + i * ENGINE_MAX_MOVES};
+        for (const Move &move: list) {
+            *out++ = move.raw();
+        }
+        counts[i] = static_cast<uint16_t>(list.size());
+    }
+}
+
+void engine_batch_in_check(const uint8_t *packed, const size_t count,
+                           uint8_t *in_check) {
+    Board board{};
+    for (std::size_t i = 0; i < count; ++i) {
+        in_check[i] = set_up(board, packed_at(packed, i)) &&
+                      board.checkers() != EMPTY_BB;
+    }
+}
+
+void engine_batch_attacked(const uint8_t *packed, const size_t count,
+                           uint64_t *attacked) {
+    Board board{};
+    for (std::size_t i = 0; i < count; ++i) {
+        const bool valid{set_up(board, packed_at(packed, i))};
+        attacked[2 * i] = valid ? board.attacked_squares(~EMPTY_BB, true) : 0;
+        attacked[2 * i + 1] =
+                valid ? board.attacked_squares(~EMPTY_BB, false) : 0;
+    }
+}
+
+void engine_batch_evaluate(const uint8_t *packed, const size_t count,
+                           int32_t *scores) {
+    // Chunks of this size keep the planes in cache, which is faster than
+    // transposing the whole batch at once.
+    constexpr std::size_t CHUNK{1024};
+    thread_local PositionBatch batch;
+    for (std::size_t i = 0; i < count; i += CHUNK) {
+        const std::size_t size{std::min(CHUNK, count - i)};
+        batch.assign(packed + i * ENGINE_PACKED_SIZE, size);
+        evaluate_batch(batch, {scores + i, size});
+    }
+}
+
+void engine_batch_perft(const uint8_t *packed, const size_t count,
+                        const int depth, uint64_t *nodes) {
+    Board board{};
+    for (std::size_t i = 0; i < count; ++i) {
+        nodes[i] = set_up(board, packed_at(packed, i)) ? perft(board, depth) : 0;
+    }
+}
+}
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+#include "chess/tt.h"
+#include "game.h"
+#include "pgn.h"
+#include "search/parallel_search.h"
+
+namespace {
+    // Neither side can mate with at most a single minor piece on the board.
+    bool insufficient_material(const Board &board) {
+        if (board.pieces(PieceType::PAWN) | board.pieces(PieceType::ROOK) |
+            board.pieces(PieceType::QUEEN)) {
+            return false;
+        }
+        return popcount(board.pieces(PieceType::KNIGHT) |
+                        board.pieces(PieceType::BISHOP)) <= 1;
+    }
+
+    int64_t parse_ms(const std::string &seconds) {
+        return std::llround(std::stod(seconds) * 1000);
+    }
+}
+
+TimeControl TimeControl::parse(const std::string &text) {
+    TimeControl tc{};
+    if (text == "-") {
+        return tc;
+    }
+    try {
+        std::string rest{text};
+        if (const auto slash{rest.find('/')}; slash != std::string::npos) {
+            tc.moves_per_period = std::stoi(rest.substr(0, slash));
+            rest = rest.substr(slash + 1);
+        }
+        if (const auto plus{rest.find('+')}; plus != std::string::npos) {
+            tc.increment_ms = parse_ms(rest.substr(plus + 1));
+            rest = rest.substr(0, plus);
+        }
+        tc.base_ms = parse_ms(rest);
+    } catch (const std::logic_error &) {
+        const std::string error_msg{"Invalid time control: " + text};
+        throw std::invalid_argument(error_msg);
+    }
+    if (tc.base_ms <= 0 || tc.increment_ms < 0 || tc.moves_per_period < 0) {
+        const std::string error_msg{"Invalid time control: " + text};
+        throw std::invalid_argument(error_msg);
+    }
+    return tc;
+}
+
+bool TimeControl::has_clock() const {
+    return base_ms > 0;
+}
+
+std::string TimeControl::to_string() const {
+    if (!has_clock()) {
+        return "-";
+    }
+    std::ostringstream out{};
+    if (moves_per_period > 0) {
+        out << moves_per_period << '/';
+    }
+    out << static_cast<double>(base_ms) / 1000;
+    if (increment_ms > 0) {
+        out << '+' << static_cast<double>(increment_ms) / 1000;
+    }
+    return out.str();
+}
+
+GameRecord play_game(const int &round, const std::string &opening_fen,
+                     const EngineConfig &white, const EngineConfig &black,
+                     const TimeControl &time_control, const int &max_plies,
+                     const syzygy::Tablebases *tablebases,
+                     const nnue::Network *network) {
+    for (const EngineConfig *engine: {&white, &black}) {
+        if (!time_control.has_clock() && engine->depth == 0 &&
+            engine->nodes == 0) {
+            const std::string error_msg{
+                "Engine " + engine->name + " has no clock, depth or node limit"
+            };
+            throw std::invalid_argument(error_msg);
+        }
+    }
+
+    const stats::Snapshot stats_before{stats::thread_snapshot()};
+    GameRecord record{
+        round, opening_fen, white.name, black.name, time_control
+    };
+    Board board{opening_fen};
+
+    // Indexed by color_index().
+    const std::array<const EngineConfig *, NUM_COLORS> engines{&white, &black};
+    std::array<std::unique_ptr<TranspositionTable>, NUM_COLORS> tables{};
+    std::array<std::unique_ptr<ParallelSearch>, NUM_COLORS> searches{};
+    for (int side = 0; side < NUM_COLORS; ++side) {
+        tables[side] = std::make_unique<TranspositionTable>(engines[side]->hash_mb);
+        searches[side] = std::make_unique<ParallelSearch>(
+            *tables[side], engines[side]->threads);
+        if (engines[side]->syzygy) {
+            searches[side]->set_tablebases(tablebases);
+        }
+        if (engines[side]->nnue) {
+            searches[side]->set_network(network);
+        }
+    }
+
+    // Clocks are kept in microseconds so that rounding does not accumulate
+    // over a game.
+    const int64_t base_us{time_control.base_ms * 1000};
+    const int64_t increment_us{time_control.increment_ms * 1000};
+    std::array<int64_t, NUM_COLORS> clock_us{base_us, base_us};
+    std::array<int, NUM_COLORS> moves_made{};
+    // The reply each side is pondering on, if it is.
+    std::array<Move, NUM_COLORS> ponder_moves{Move::none(), Move::none()};
+
+    auto limits_of = [&](const int &side) {
+        SearchLimits limits{};
+        limits.depth = engines[side]->depth;
+        limits.nodes = engines[side]->nodes;
+        if (time_control.has_clock()) {
+            limits.time_ms = {clock_us[0] / 1000, clock_us[1] / 1000};
+            limits.increment_ms = {time_control.increment_ms,
+                                   time_control.increment_ms};
+            if (time_control.moves_per_period > 0) {
+                limits.moves_to_go = time_control.moves_per_period -
+                                     moves_made[side] %
+                                     time_control.moves_per_period;
+            }
+        }
+        return limits;
+    };
+
+    for (int ply = 0;; ++ply) {
+        MoveList moves;
+        board.generate_moves(moves);
+        if (moves.empty()) {
+            if (board.checkers()) {
+                record.result = board.is_white_turn()
+                                    ? GameResult::BLACK_WINS
+                                    : GameResult::WHITE_WINS;
+                record.termination = "checkmate";
+            } else {
+                record.result = GameResult::DRAW;
+                record.termination = "stalemate";
+            }
+            break;
+        }
+        if (board.halfmove_clock() >= 100) {
+            record.termination = "fifty-move rule";
+            break;
+        }
+        if (board.is_repetition()) {
+            record.termination = "threefold repetition";
+            break;
+        }
+        if (insufficient_material(board)) {
+            record.termination = "insufficient material";
+            break;
+        }
+        if (ply >= max_plies) {
+            record.termination = "adjudication: move limit";
+            break;
+        }
+        // Outcomes that the fifty-move rule spoils are drawn.
+        if (tablebases && tablebases->covers(board)) {
+            if (const std::optional<syzygy::Wdl> wdl{tablebases->probe_wdl(board)}) {
+                if (*wdl == syzygy::Wdl::WIN || *wdl == syzygy::Wdl::LOSS) {
+                    record.result = (*wdl == syzygy::Wdl::WIN) == board.is_white_turn()
+                                        ? GameResult::WHITE_WINS
+                                        : GameResult::BLACK_WINS;
+                }
+                record.termination = "adjudication: tablebase";
+                break;
+            }
+        }
+
+        const int side{color_index(board.is_white_turn())};
+        auto start{std::chrono::steady_clock::now()};
+        // On a miss the ponder search is dropped, and the clock only starts
+        // with the search of the actual position.
+        bool ponder_hit{false};
+        if (!ponder_moves[side].is_none()) {
+            ponder_hit = ponder_moves[side] == record.moves.back();
+            if (ponder_hit) {
+                searches[side]->ponderhit();
+            } else {
+                searches[side]->stop();
+                static_cast<void>(searches[side]->wait());
+                start = std::chrono::steady_clock::now();
+            }
+            ponder_moves[side] = Move::none();
+        }
+        const SearchResult result{
+            ponder_hit
+                ? searches[side]->wait()
+                : searches[side]->run(board, limits_of(side))
+        };
+        const int64_t elapsed_us{
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count()
+        };
+
+        if (time_control.has_clock()) {
+            clock_us[side] -= elapsed_us;
+            if (clock_us[side] < 0) {
+                record.result = board.is_white_turn()
+                                    ? GameResult::BLACK_WINS
+                                    : GameResult::WHITE_WINS;
+                record.termination = "time forfeit";
+                break;
+            }
+            clock_us[side] += increment_us;
+            if (time_control.moves_per_period > 0 &&
+                (moves_made[side] + 1) % time_control.moves_per_period == 0) {
+                clock_us[side] += base_us;
+            }
+        }
+        ++moves_made[side];
+
+        record.san.push_back(to_san(board, result.best_move));
+        record.moves.push_back(result.best_move);
+        board.make_move(result.best_move);
+
+        if (engines[side]->ponder && !result.ponder_move.is_none()) {
+            Board expected{board};
+            expected.make_move(result.ponder_move);
+            SearchLimits limits{limits_of(side)};
+            limits.ponder = true;
+            searches[side]->start(expected, limits);
+            ponder_moves[side] = result.ponder_move;
+        }
+    }
+
+    record.stats = stats::thread_snapshot() - stats_before;
+    for (const auto &search: searches) {
+        search->stop();
+        static_cast<void>(search->wait());
+        record.stats = record.stats + search->thread_stats();
+    }
+    return record;
+}
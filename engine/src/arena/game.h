@@ -0,0 +1,88 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chess/board.h"
+#include "chess/move.h"
+#include "nnue/network.h"
+#include "tb/syzygy.h"
+#include "util/stats.h"
+
+// Clock settings of one game. All zero means no clock, in which case the
+// engines must have a depth or node limit.
+struct TimeControl {
+    int64_t base_ms{0};
+    int64_t increment_ms{0};
+    // Moves per period after which the base time is added again; zero for
+    // sudden death.
+    int moves_per_period{0};
+
+    // Parses the PGN form "[moves/]seconds[+increment]", e.g. "10+0.1" or
+    // "40/60". "-" means no clock.
+    static TimeControl parse(const std::string &text);
+
+    [[nodiscard]] bool has_clock() const;
+
+    // The PGN TimeControl tag value.
+    [[nodiscard]] std::string to_string() const;
+};
+
+// A player of the arena: the library's search with its own settings.
+struct EngineConfig {
+    std::string name{};
+    std::size_t hash_mb{16};
+    int threads{1};
+    // Per-move search limits on top of the clock, zero for none.
+    int depth{0};
+    uint64_t nodes{0};
+    // Whether the search probes the arena's tablebases, if it has any.
+    bool syzygy{true};
+    // Whether the search evaluates with the arena's network, if it has one.
+    bool nnue{true};
+    // Whether the engine searches the reply it expects while the opponent
+    // thinks, on threads of its own next to the opponent's.
+    bool ponder{false};
+};
+
+enum class GameResult {
+    WHITE_WINS,
+    BLACK_WINS,
+    DRAW
+};
+
+struct GameRecord {
+    int round{0};
+    std::string opening_fen{};
+    std::string white{};
+    std::string black{};
+    TimeControl time_control{};
+    std::vector<Move> moves{};
+    // The same moves in standard algebraic notation, for the PGN.
+    std::vector<std::string> san{};
+    GameResult result{GameResult::DRAW};
+    std::string termination{};
+    // Engine counters of every thread the game ran on: the calling thread,
+    // and the helper and ponder threads of both sides.
+    stats::Snapshot stats{};
+};
+
+// Plays one game from the given position. Each side searches on its own
+// transposition table, kept with its history and principal variation for
+// the whole game; clocks are measured in wall time around every search, so
+// a side that overruns its clock loses on time. A pondering side whose
+// expected reply is played goes on with its ponder search, and is charged
+// from the reply on. With
+// tablebases, a game is adjudicated as soon as they cover the position.
+// Tablebases and network are shared by every engine that enables them.
+GameRecord play_game(const int &round, const std::string &opening_fen,
+                     const EngineConfig &white, const EngineConfig &black,
+                     const TimeControl &time_control,
+                     const int &max_plies = 600,
+                     const syzygy::Tablebases *tablebases = nullptr,
+                     const nnue::Network *network = nullptr);
+
+#endif //GAME_H
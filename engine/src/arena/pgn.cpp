@@ -0,0 +1,189 @@
+#include <chrono>
+#include <ctime>
+#include <sstream>
+
+#include "pgn.h"
+
+namespace {
+    constexpr auto START_FEN{
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+    };
+    // Export format keeps movetext lines within 80 characters.
+    constexpr std::size_t MAX_LINE{79};
+
+    char piece_letter(const PieceType &type) {
+        switch (type) {
+            case PieceType::KNIGHT:
+                return 'N';
+            case PieceType::BISHOP:
+                return 'B';
+            case PieceType::ROOK:
+                return 'R';
+            case PieceType::QUEEN:
+                return 'Q';
+            case PieceType::KING:
+                return 'K';
+            default:
+                return '?';
+        }
+    }
+
+    std::string square_name(const int sq) {
+        return {
+            static_cast<char>('a' + file_of(sq)),
+            static_cast<char>('1' + rank_of(sq))
+        };
+    }
+
+    // The PGN Termination tag only distinguishes a few standard values; the
+    // detailed reason goes into a comment after the last move.
+    std::string termination_tag(const std::string &termination) {
+        if (termination == "time forfeit") {
+            return termination;
+        }
+        if (termination.starts_with("adjudication")) {
+            return "adjudication";
+        }
+        return "normal";
+    }
+
+    std::string current_date() {
+        const std::time_t now{
+            std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())
+        };
+        std::tm date{};
+        gmtime_r(&now, &date);
+        char buffer[11];
+        std::strftime(buffer, sizeof(buffer), "%Y.%m.%d", &date);
+        return buffer;
+    }
+}
+
+std::string to_san(Board &board, const Move &move) {
+    std::string san{};
+    const Piece piece{board.piece_on(move.from())};
+
+    if (move.flag() == MoveFlag::CASTLING) {
+        san = file_of(move.to()) > file_of(move.from()) ? "O-O" : "O-O-O";
+    } else {
+        const bool capture{
+            move.flag() == MoveFlag::EN_PASSANT ||
+            !board.piece_on(move.to()).is_empty()
+        };
+
+        if (piece.type == PieceType::PAWN) {
+            if (capture) {
+                san += static_cast<char>('a' + file_of(move.from()));
+            }
+        } else {
+            san += piece_letter(piece.type);
+
+            // Disambiguate by file, then rank, then both, against other
+            // pieces of the same type that can reach the same square.
+            MoveList moves;
+            board.generate_moves(moves);
+            bool ambiguous{false}, same_file{false}, same_rank{false};
+            for (const Move &other: moves) {
+                if (other.to() != move.to() || other.from() == move.from() ||
+                    board.piece_on(other.from()).type != piece.type) {
+                    continue;
+                }
+                ambiguous = true;
+                same_file |= file_of(other.from()) == file_of(move.from());
+                same_rank |= rank_of(other.from()) == rank_of(move.from());
+            }
+            if (ambiguous) {
+                if (!same_file) {
+                    san += static_cast<char>('a' + file_of(move.from()));
+                } else if (!same_rank) {
+                    san += static_cast<char>('1' + rank_of(move.from()));
+                } else {
+                    san += square_name(move.from());
+                }
+            }
+        }
+
+        if (capture) {
+            san += 'x';
+        }
+        san += square_name(move.to());
+        if (move.flag() == MoveFlag::PROMOTION) {
+            san += '=';
+            san += piece_letter(move.promotion());
+        }
+    }
+
+    board.make_move(move);
+    if (board.checkers()) {
+        MoveList replies;
+        board.generate_moves(replies);
+        san += replies.empty() ? '#' : '+';
+    }
+    board.unmake_move();
+    return san;
+}
+
+std::string result_string(const GameResult &result) {
+    switch (result) {
+        case GameResult::WHITE_WINS:
+            return "1-0";
+        case GameResult::BLACK_WINS:
+            return "0-1";
+        default:
+            return "1/2-1/2";
+    }
+}
+
+std::string to_pgn(const GameRecord &record, const std::string &event) {
+    const std::string result{result_string(record.result)};
+    const bool custom_start{record.opening_fen != START_FEN};
+    const Board start{record.opening_fen};
+    const bool white_first{start.is_white_turn()};
+
+    std::ostringstream out{};
+    out << "[Event \"" << event << "\"]\n"
+            << "[Site \"?\"]\n"
+            << "[Date \"" << current_date() << "\"]\n"
+            << "[Round \"" << record.round << "\"]\n"
+            << "[White \"" << record.white << "\"]\n"
+            << "[Black \"" << record.black << "\"]\n"
+            << "[Result \"" << result << "\"]\n";
+    if (custom_start) {
+        out << "[SetUp \"1\"]\n"
+                << "[FEN \"" << record.opening_fen << "\"]\n";
+    }
+    out << "[TimeControl \"" << record.time_control.to_string() << "\"]\n"
+            << "[PlyCount \"" << record.san.size() << "\"]\n"
+            << "[Termination \"" << termination_tag(record.termination)
+            << "\"]\n\n";
+
+    // Movetext, wrapped between tokens.
+    std::string line{};
+    auto append = [&out, &line](const std::string &token) {
+        if (!line.empty() && line.size() + 1 + token.size() > MAX_LINE) {
+            out << line << '\n';
+            line.clear();
+        }
+        if (!line.empty()) {
+            line += ' ';
+        }
+        line += token;
+    };
+
+    for (std::size_t i = 0; i < record.san.size(); ++i) {
+        const std::size_t ply{i + (white_first ? 0 : 1)};
+        const std::size_t number{
+            ply / 2 + static_cast<std::size_t>(start.fullmove_number())
+        };
+        if (ply % 2 == 0) {
+            append(std::to_string(number) + ".");
+        } else if (i == 0) {
+            append(std::to_string(number) + "...");
+        }
+        append(record.san[i]);
+    }
+    append("{" + record.termination + "}");
+    append(result);
+    out << line << "\n\n";
+    return out.str();
+}
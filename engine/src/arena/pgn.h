@@ -0,0 +1,20 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <string>
+
+#include "chess/board.h"
+#include "chess/move.h"
+#include "game.h"
+
+// Standard algebraic notation of a legal move in the given position, e.g.
+// "Nbd7", "exd6", "e8=Q+" or "O-O-O#". The board is returned unchanged.
+std::string to_san(Board &board, const Move &move);
+
+// "1-0", "0-1" or "1/2-1/2".
+std::string result_string(const GameResult &result);
+
+// One complete PGN game, terminated by a blank line.
+std::string to_pgn(const GameRecord &record, const std::string &event);
+
+#endif //PGN_H
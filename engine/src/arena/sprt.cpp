@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "sprt.h"
+
+namespace {
+    // Expected score for a logistic Elo difference, and its inverse.
+    double expected_score(const double &elo) {
+        return 1 / (1 + std::pow(10, -elo / 400));
+    }
+
+    double elo_of(const double &score) {
+        const double clamped{std::clamp(score, 1e-6, 1 - 1e-6)};
+        return 400 * std::log10(clamped / (1 - clamped));
+    }
+
+    // Mean score per game and its per-game variance.
+    struct Moments {
+        double mean;
+        double variance;
+    };
+
+    Moments moments(const MatchScore &score) {
+        const double n{static_cast<double>(score.games())};
+        const double w{score.wins / n}, d{score.draws / n}, l{score.losses / n};
+        const double mean{w + d / 2};
+        const double variance{
+            w * (1 - mean) * (1 - mean) + d * (0.5 - mean) * (0.5 - mean) +
+            l * mean * mean
+        };
+        return {mean, variance};
+    }
+}
+
+uint64_t MatchScore::games() const {
+    return wins + draws + losses;
+}
+
+EloEstimate estimate_elo(const MatchScore &score) {
+    EloEstimate estimate{};
+    if (score.games() == 0) {
+        return estimate;
+    }
+
+    const auto [mean, variance]{moments(score)};
+    const double deviation{std::sqrt(variance / score.games())};
+    estimate.elo = elo_of(mean);
+    estimate.error = (elo_of(mean + 1.959964 * deviation) -
+                      elo_of(mean - 1.959964 * deviation)) / 2;
+    if (score.wins + score.losses > 0) {
+        const double decisive{static_cast<double>(score.wins + score.losses)};
+        estimate.los = 0.5 * (1 + std::erf(
+                                  (static_cast<double>(score.wins) -
+                                   static_cast<double>(score.losses)) /
+                                  std::sqrt(2 * decisive)));
+    }
+    return estimate;
+}
+
+Sprt::Sprt(const double &elo0, const double &elo1, const double &alpha,
+           const double &beta)
+    : elo0{elo0}, elo1{elo1},
+      lower{std::log(beta / (1 - alpha))},
+      upper{std::log((1 - beta) / alpha)} {
+    if (!(elo0 < elo1) || alpha <= 0 || alpha >= 1 || beta <= 0 || beta >= 1) {
+        throw std::invalid_argument("SPRT needs elo0 < elo1 and 0 < alpha, beta < 1");
+    }
+}
+
+double Sprt::llr(const MatchScore &score) const {
+    if (score.wins == 0 || score.losses == 0) {
+        // The variance estimate is degenerate until both results occurred.
+        return 0;
+    }
+    const auto [mean, variance]{moments(score)};
+    const double s0{expected_score(elo0)}, s1{expected_score(elo1)};
+    return static_cast<double>(score.games()) * (s1 - s0) *
+           (2 * mean - s0 - s1) / (2 * variance);
+}
+
+double Sprt::lower_bound() const {
+    return lower;
+}
+
+double Sprt::upper_bound() const {
+    return upper;
+}
+
+SprtDecision Sprt::decide(const MatchScore &score) const {
+    const double ratio{llr(score)};
+    if (ratio <= lower) {
+        return SprtDecision::ACCEPT_H0;
+    }
+    if (ratio >= upper) {
+        return SprtDecision::ACCEPT_H1;
+    }
+    return SprtDecision::CONTINUE;
+}
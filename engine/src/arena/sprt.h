@@ -0,0 +1,56 @@
+#ifndef SPRT_H
+#define SPRT_H
+
+#include <cstdint>
+
+// Results of a match from the point of view of the first engine.
+struct MatchScore {
+    uint64_t wins{0};
+    uint64_t draws{0};
+    uint64_t losses{0};
+
+    [[nodiscard]] uint64_t games() const;
+};
+
+struct EloEstimate {
+    double elo{0};
+    // Half-width of the 95% confidence interval.
+    double error{0};
+    // Likelihood of superiority: the probability that the first engine is
+    // the stronger one.
+    double los{0.5};
+};
+
+// Logistic Elo difference with its confidence interval.
+EloEstimate estimate_elo(const MatchScore &score);
+
+enum class SprtDecision {
+    CONTINUE,
+    ACCEPT_H0,
+    ACCEPT_H1
+};
+
+// Sequential probability ratio test of H0: elo = elo0 against H1:
+// elo = elo1, using the normal approximation of the trinomial
+// (win/draw/loss) log-likelihood ratio.
+class Sprt {
+public:
+    Sprt(const double &elo0, const double &elo1, const double &alpha = 0.05,
+         const double &beta = 0.05);
+
+    [[nodiscard]] double llr(const MatchScore &score) const;
+
+    [[nodiscard]] double lower_bound() const;
+
+    [[nodiscard]] double upper_bound() const;
+
+    [[nodiscard]] SprtDecision decide(const MatchScore &score) const;
+
+private:
+    double elo0;
+    double elo1;
+    double lower;
+    double upper;
+};
+
+#endif //SPRT_H
@@ -0,0 +1,106 @@
+#include <stdexcept>
+#include <utility>
+
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(const std::size_t &threads) {
+    if (threads == 0) {
+        throw std::invalid_argument("Thread pool needs at least one thread");
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this, i](const std::stop_token &stop) {
+            worker_loop(stop, i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    for (std::jthread &worker: workers) {
+        worker.request_stop();
+    }
+    wake.notify_all();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard lock{idle_mutex};
+        ++pending;
+    }
+    Queue &queue{*queues[next_queue++ % queues.size()]};
+    {
+        std::lock_guard lock{queue.mutex};
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard lock{wake_mutex};
+        ++queued;
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock{idle_mutex};
+    idle.wait(lock, [this] { return pending == 0; });
+}
+
+std::size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::worker_loop(const std::stop_token &stop,
+                             const std::size_t &index) {
+    while (!stop.stop_requested()) {
+        {
+            // Claim a task before looking for it, so that an idle worker
+            // never spins on queues another worker is about to empty.
+            std::unique_lock lock{wake_mutex};
+            if (!wake.wait(lock, stop, [this] { return queued > 0; })) {
+                return;
+            }
+            --queued;
+        }
+
+        std::function<void()> task{};
+        while (!try_pop(index, task) && !try_steal(index, task)) {
+            // Other workers take tasks while this one scans the queues, but
+            // one is always left for every claim.
+            std::this_thread::yield();
+        }
+        task();
+
+        std::lock_guard lock{idle_mutex};
+        if (--pending == 0) {
+            idle.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::try_pop(const std::size_t &index,
+                         std::function<void()> &task) {
+    Queue &queue{*queues[index]};
+    std::lock_guard lock{queue.mutex};
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::try_steal(const std::size_t &index,
+                           std::function<void()> &task) {
+    for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+        Queue &queue{*queues[(index + offset) % queues.size()]};
+        std::lock_guard lock{queue.mutex};
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,68 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing pool. Every worker owns a task queue; submitted
+// tasks are spread over the queues round-robin, a worker runs its own tasks
+// newest first and, once its queue is empty, steals the oldest task of
+// another worker. Tasks must not throw.
+class ThreadPool {
+public:
+    explicit ThreadPool(const std::size_t &threads);
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Stops the workers once their current task is done. Queued tasks that
+    // have not started are dropped.
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished.
+    void wait();
+
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    struct Queue {
+        std::mutex mutex{};
+        std::deque<std::function<void()> > tasks{};
+    };
+
+    void worker_loop(const std::stop_token &stop, const std::size_t &index);
+
+    bool try_pop(const std::size_t &index, std::function<void()> &task);
+
+    bool try_steal(const std::size_t &index, std::function<void()> &task);
+
+    std::vector<std::unique_ptr<Queue> > queues{};
+    std::atomic<std::size_t> next_queue{0};
+
+    // Tasks submitted but not yet taken by a worker, guarded by wake_mutex.
+    std::size_t queued{0};
+    std::mutex wake_mutex{};
+    std::condition_variable_any wake{};
+
+    // Tasks submitted but not yet finished.
+    std::size_t pending{0};
+    std::mutex idle_mutex{};
+    std::condition_variable idle{};
+
+    // Declared last so that the workers are joined before anything they use
+    // is destroyed.
+    std::vector<std::jthread> workers{};
+};
+
+#endif //THREAD_POOL_H
@@ -0,0 +1,505 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "arena/game.h"
+#include "arena/pgn.h"
+#include "arena/sprt.h"
+#include "arena/thread_pool.h"
+#include "book/polyglot.h"
+#include "chess/board.h"
+#include "nnue/network.h"
+#include "tb/syzygy.h"
+#include "util/stats.h"
+
+namespace {
+    constexpr auto START_FEN{
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+    };
+
+    struct SprtOptions {
+        double elo0{0};
+        double elo1{5};
+        double alpha{0.05};
+        double beta{0.05};
+    };
+
+    struct Options {
+        std::vector<EngineConfig> engines{};
+        std::vector<std::string> openings{};
+        int games{100};
+        int concurrency{0};
+        int max_plies{600};
+        TimeControl time_control{TimeControl::parse("10+0.1")};
+        std::string book_path{};
+        int book_depth{16};
+        uint64_t seed{1};
+        std::string syzygy_path{};
+        std::string nnue_path{};
+        std::string pgn_path{};
+        std::string stats_path{};
+        std::string event{"chess-arena"};
+        std::optional<SprtOptions> sprt{};
+    };
+
+    void print_usage() {
+        std::cout
+                << "Usage: engine_arena --engine <spec> --engine <spec> [options]\n"
+                << "  --engine <spec>      name=<name>[,depth=N][,nodes=N][,hash=MB][,threads=N]\n"
+                << "                       [,syzygy=0|1][,nnue=0|1][,ponder=0|1]\n"
+                << "  --games <N>          number of games (default: 100)\n"
+                << "  --concurrency <N>    games played at once (default: cores / engine threads)\n"
+                << "  --tc <tc>            time control [moves/]seconds[+increment], or - for none\n"
+                << "                       (default: 10+0.1)\n"
+                << "  --openings <path>    FEN or EPD file, one position per line; each opening\n"
+                << "                       is played twice with colors reversed\n"
+                << "  --book <path>        Polyglot book played from each opening\n"
+                << "  --book-depth <N>     maximum book plies (default: 16)\n"
+                << "  --seed <N>           seed for book move selection (default: 1)\n"
+                << "  --syzygy <paths>     Syzygy tablebase directories, separated by ':'; engines\n"
+                << "                       probe them and covered positions are adjudicated;\n"
+                << "                       needs a build with ENGINE_SYZYGY\n"
+                << "  --nnue <path>        network file engines evaluate with\n"
+                << "  --pgn <path>         append finished games to a PGN file\n"
+                << "  --event <name>       PGN Event tag (default: chess-arena)\n"
+                << "  --stats <path>       write search statistics per game and in total as\n"
+                << "                       JSON; needs a build with ENGINE_STATS\n"
+                << "  --max-plies <N>      adjudicate longer games as draws (default: 600)\n"
+                << "  --sprt <e0,e1[,a,b]> stop once the SPRT of elo0 against elo1 decides\n";
+    }
+
+    std::vector<std::string> split(const std::string &text, const char &separator) {
+        std::vector<std::string> parts{};
+        std::istringstream in{text};
+        for (std::string part; std::getline(in, part, separator);) {
+            parts.push_back(part);
+        }
+        return parts;
+    }
+
+    EngineConfig parse_engine(const std::string &spec) {
+        EngineConfig engine{};
+        for (const std::string &field: split(spec, ',')) {
+            const auto equals{field.find('=')};
+            if (equals == std::string::npos) {
+                throw std::invalid_argument("Invalid engine option " + field);
+            }
+            const std::string key{field.substr(0, equals)};
+            const std::string value{field.substr(equals + 1)};
+            if (key == "name") {
+                engine.name = value;
+            } else if (key == "depth") {
+                engine.depth = std::stoi(value);
+            } else if (key == "nodes") {
+                engine.nodes = std::stoull(value);
+            } else if (key == "hash") {
+                engine.hash_mb = std::stoul(value);
+            } else if (key == "threads") {
+                engine.threads = std::max(1, std::stoi(value));
+            } else if (key == "syzygy") {
+                engine.syzygy = std::stoi(value) != 0;
+            } else if (key == "nnue") {
+                engine.nnue = std::stoi(value) != 0;
+            } else if (key == "ponder") {
+                engine.ponder = std::stoi(value) != 0;
+            } else {
+                throw std::invalid_argument("Unknown engine option " + key);
+            }
+        }
+        if (engine.name.empty()) {
+            throw std::invalid_argument("Engine needs a name: " + spec);
+        }
+        return engine;
+    }
+
+    // Reads FEN lines, or EPD lines whose operations follow the first four
+    // fields. Blank lines and lines starting with '#' are skipped.
+    std::vector<std::string> read_openings(const std::string &path) {
+        std::ifstream file{path};
+        if (!file) {
+            throw std::invalid_argument("Cannot open openings file " + path);
+        }
+        std::vector<std::string> openings{};
+        for (std::string line; std::getline(file, line);) {
+            std::istringstream in{line};
+            std::vector<std::string> fields{};
+            for (std::string field; fields.size() < 6 && in >> field;) {
+                fields.push_back(field);
+            }
+            if (fields.size() < 4 || fields[0].starts_with('#')) {
+                continue;
+            }
+            const bool fen{
+                fields.size() == 6 &&
+                std::all_of(fields[4].begin(), fields[4].end(), ::isdigit) &&
+                std::all_of(fields[5].begin(), fields[5].end(), ::isdigit)
+            };
+            std::string opening{
+                fields[0] + ' ' + fields[1] + ' ' + fields[2] + ' ' + fields[3]
+            };
+            opening += fen ? ' ' + fields[4] + ' ' + fields[5] : " 0 1";
+            Board{opening};
+            openings.push_back(opening);
+        }
+        if (openings.empty()) {
+            throw std::invalid_argument("No positions in " + path);
+        }
+        return openings;
+    }
+
+    Options parse_options(const int argc, char **argv) {
+        Options options{};
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg{argv[i]};
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--engine") {
+                options.engines.push_back(parse_engine(value()));
+            } else if (arg == "--games") {
+                options.games = std::max(1, std::stoi(value()));
+            } else if (arg == "--concurrency") {
+                options.concurrency = std::max(1, std::stoi(value()));
+            } else if (arg == "--tc") {
+                options.time_control = TimeControl::parse(value());
+            } else if (arg == "--openings") {
+                options.openings = read_openings(value());
+            } else if (arg == "--book") {
+                options.book_path = value();
+            } else if (arg == "--book-depth") {
+                options.book_depth = std::max(0, std::stoi(value()));
+            } else if (arg == "--seed") {
+                options.seed = std::stoull(value());
+            } else if (arg == "--syzygy") {
+                options.syzygy_path = value();
+            } else if (arg == "--nnue") {
+                options.nnue_path = value();
+            } else if (arg == "--pgn") {
+                options.pgn_path = value();
+            } else if (arg == "--stats") {
+                options.stats_path = value();
+            } else if (arg == "--event") {
+                options.event = value();
+            } else if (arg == "--max-plies") {
+                options.max_plies = std::max(1, std::stoi(value()));
+            } else if (arg == "--sprt") {
+                const std::vector<std::string> fields{split(value(), ',')};
+                if (fields.size() != 2 && fields.size() != 4) {
+                    throw std::invalid_argument("--sprt takes elo0,elo1[,alpha,beta]");
+                }
+                SprtOptions sprt{std::stod(fields[0]), std::stod(fields[1])};
+                if (fields.size() == 4) {
+                    sprt.alpha = std::stod(fields[2]);
+                    sprt.beta = std::stod(fields[3]);
+                }
+                options.sprt = sprt;
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+        if (options.engines.size() != 2) {
+            throw std::invalid_argument("Exactly two engines are required");
+        }
+        if (options.openings.empty()) {
+            options.openings.emplace_back(START_FEN);
+        }
+        if (options.concurrency == 0) {
+            // Leave every engine thread a core of its own, so that no game's
+            // clock is charged for time spent waiting to be scheduled. A
+            // pondering engine searches while its opponent does.
+            const int cores{
+                static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))
+            };
+            const EngineConfig &first{options.engines[0]};
+            const EngineConfig &second{options.engines[1]};
+            const int threads{
+                first.ponder || second.ponder
+                    ? first.threads + second.threads
+                    : std::max(first.threads, second.threads)
+            };
+            options.concurrency = std::max(1, cores / threads);
+        }
+        return options;
+    }
+
+    // splitmix64 step, so that every game pair gets an independent stream.
+    uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ x >> 30) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ x >> 27) * 0x94D049BB133111EBULL;
+        return x ^ x >> 31;
+    }
+
+    // Follows the book from the opening for up to `depth` plies. Both games
+    // of a pair use the same seed, so they start from the same position.
+    std::string book_opening(const PolyglotBook &book, const std::string &fen,
+                             const int &depth, uint64_t seed) {
+        Board board{fen};
+        for (int ply = 0; ply < depth; ++ply) {
+            seed = mix(seed);
+            const Move move{book.pick(board, seed)};
+            if (move.is_none()) {
+                break;
+            }
+            board.make_move(move);
+        }
+        return board.fen();
+    }
+
+    // A JSON string literal of free text, such as an engine name or the
+    // message of a game that threw.
+    std::string json_string(const std::string &text) {
+        constexpr std::string_view HEX_DIGITS{"0123456789abcdef"};
+        std::string quoted{"\""};
+        for (const char c: text) {
+            switch (c) {
+                case '"':
+                    quoted += "\\\"";
+                    break;
+                case '\\':
+                    quoted += "\\\\";
+                    break;
+                case '\n':
+                    quoted += "\\n";
+                    break;
+                case '\r':
+                    quoted += "\\r";
+                    break;
+                case '\t':
+                    quoted += "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        quoted += "\\u00";
+                        quoted += HEX_DIGITS[c >> 4];
+                        quoted += HEX_DIGITS[c & 0xF];
+                    } else {
+                        quoted += c;
+                    }
+            }
+        }
+        return quoted + '"';
+    }
+
+    void print_summary(const std::string &name, const MatchScore &score,
+                       const std::optional<Sprt> &sprt) {
+        const EloEstimate elo{estimate_elo(score)};
+        std::cout << std::fixed << std::setprecision(1)
+                << "Score of " << name << ": " << score.wins << " - "
+                << score.losses << " - " << score.draws << "  [" << score.games()
+                << " games]  Elo " << elo.elo << " +/- " << elo.error
+                << "  LOS " << elo.los * 100 << '%';
+        if (sprt) {
+            std::cout << std::setprecision(2) << "  LLR " << sprt->llr(score)
+                    << " (" << sprt->lower_bound() << ", " << sprt->upper_bound()
+                    << ')';
+        }
+        std::cout << '\n';
+    }
+}
+
+int main(const int argc, char **argv) {
+    Options options{};
+    std::optional<Sprt> sprt{};
+    try {
+        options = parse_options(argc, argv);
+        if (options.sprt) {
+            sprt.emplace(options.sprt->elo0, options.sprt->elo1,
+                         options.sprt->alpha, options.sprt->beta);
+        }
+        for (const EngineConfig &engine: options.engines) {
+            if (!options.time_control.has_clock() && engine.depth == 0 &&
+                engine.nodes == 0) {
+                throw std::invalid_argument(
+                    "Engine " + engine.name + " needs a clock, depth or node limit");
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    PolyglotBook book{};
+    if (!options.book_path.empty()) {
+        try {
+            book = PolyglotBook{options.book_path};
+        } catch (const std::invalid_argument &e) {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!options.syzygy_path.empty() && !syzygy::ENABLED) {
+        std::cerr << "Built without ENGINE_SYZYGY; tablebases are not probed\n";
+    }
+    // Shared by every game; tables are mapped on first use.
+    const syzygy::Tablebases tablebases{options.syzygy_path};
+    if (!options.syzygy_path.empty()) {
+        std::cout << "Found " << tablebases.size() << " tablebases, up to "
+                << tablebases.max_pieces() << " pieces\n";
+    }
+
+    std::optional<nnue::Network> network{};
+    if (!options.nnue_path.empty()) {
+        try {
+            network.emplace(options.nnue_path);
+        } catch (const std::invalid_argument &e) {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ofstream pgn{};
+    if (!options.pgn_path.empty()) {
+        pgn.open(options.pgn_path, std::ios::app);
+        if (!pgn) {
+            std::cerr << "Cannot open " << options.pgn_path << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!options.stats_path.empty() && !stats::ENABLED) {
+        std::cerr << "Built without ENGINE_STATS; statistics will be zero\n";
+    }
+
+    const EngineConfig &first{options.engines[0]};
+    const EngineConfig &second{options.engines[1]};
+    std::mutex output_mutex{};
+    std::vector<std::string> game_stats{};
+    const stats::Snapshot stats_before{stats::snapshot()};
+    MatchScore score{};
+    int aborted{0};
+    std::atomic<bool> finished{false};
+
+    std::cout << first.name << " vs " << second.name << ", " << options.games
+            << " games at " << options.time_control.to_string() << ", "
+            << options.concurrency << " concurrent\n";
+
+    {
+        ThreadPool pool{static_cast<std::size_t>(options.concurrency)};
+        for (int game = 0; game < options.games; ++game) {
+            pool.submit([&, game] {
+                // Games queued after an SPRT decision are not played.
+                if (finished) {
+                    return;
+                }
+                const bool swapped{game % 2 == 1};
+                const EngineConfig &white{swapped ? second : first};
+                const EngineConfig &black{swapped ? first : second};
+
+                // Pool tasks must not throw: a game that fails, such as on
+                // an opening the board rejects, is reported and left out of
+                // the score.
+                GameRecord record{};
+                try {
+                    // Each opening is played twice, once with either color.
+                    std::string opening{
+                        options.openings[game / 2 % options.openings.size()]
+                    };
+                    if (book.size() > 0) {
+                        opening = book_opening(book, opening, options.book_depth,
+                                               options.seed ^ mix(game / 2));
+                    }
+                    record = play_game(game + 1, opening, white, black,
+                                       options.time_control, options.max_plies,
+                                       tablebases.size() > 0 ? &tablebases : nullptr,
+                                       network ? &*network : nullptr);
+                } catch (const std::exception &e) {
+                    std::lock_guard lock{output_mutex};
+                    ++aborted;
+                    std::cout << "Game " << game + 1 << ": " << white.name << " vs "
+                            << black.name << " aborted {" << e.what() << "}\n";
+                    if (!options.stats_path.empty()) {
+                        game_stats.push_back(
+                            "{\"round\": " + std::to_string(game + 1) +
+                            ", \"white\": " + json_string(white.name) +
+                            ", \"black\": " + json_string(black.name) +
+                            ", \"error\": " + json_string(e.what()) + '}');
+                    }
+                    return;
+                }
+
+                std::lock_guard lock{output_mutex};
+                if (!options.stats_path.empty()) {
+                    game_stats.push_back(
+                        "{\"round\": " + std::to_string(record.round) +
+                        ", \"white\": " + json_string(record.white) +
+                        ", \"black\": " + json_string(record.black) +
+                        ", \"stats\": " + stats::to_json(record.stats) + '}');
+                }
+                if (record.result == GameResult::DRAW) {
+                    ++score.draws;
+                } else if ((record.result == GameResult::WHITE_WINS) != swapped) {
+                    ++score.wins;
+                } else {
+                    ++score.losses;
+                }
+                if (pgn.is_open()) {
+                    pgn << to_pgn(record, options.event) << std::flush;
+                }
+                std::cout << "Game " << record.round << ": " << record.white
+                        << " vs " << record.black << " "
+                        << result_string(record.result) << " {"
+                        << record.termination << "}\n";
+                print_summary(first.name, score, sprt);
+
+                if (sprt && sprt->decide(score) != SprtDecision::CONTINUE) {
+                    finished = true;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    if (!options.stats_path.empty()) {
+        std::ofstream out{options.stats_path};
+        if (!out) {
+            std::cerr << "Cannot open " << options.stats_path << '\n';
+            return EXIT_FAILURE;
+        }
+        out << "{\"games\": [";
+        for (std::size_t i = 0; i < game_stats.size(); ++i) {
+            out << (i > 0 ? ",\n  " : "\n  ") << game_stats[i];
+        }
+        out << "\n], \"total\": " << stats::to_json(stats::snapshot() - stats_before)
+                << "}\n";
+    }
+
+    std::cout << "Finished.\n";
+    print_summary(first.name, score, sprt);
+    if (sprt) {
+        switch (sprt->decide(score)) {
+            case SprtDecision::ACCEPT_H0:
+                std::cout << "SPRT: H0 accepted\n";
+                break;
+            case SprtDecision::ACCEPT_H1:
+                std::cout << "SPRT: H1 accepted\n";
+                break;
+            default:
+                std::cout << "SPRT: inconclusive\n";
+                break;
+        }
+    }
+    if (aborted > 0) {
+        std::cerr << "Aborted " << aborted << " of " << options.games << " games\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
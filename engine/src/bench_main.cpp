@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "chess/board.h"
+#include "chess/tt.h"
+#include "search/parallel_search.h"
+
+namespace {
+    // The search benchmark's positions and the perft suite's, so that every
+    // piece type, castling, en passant and promotions are exercised.
+    constexpr std::array<const char *, 10> POSITIONS{
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 8",
+        "2r3k1/pp3ppp/4p3/3pP3/3P1P2/1P3K2/P5PP/2R5 w - - 0 30",
+        "r2q1rk1/pb1nbppp/1p2pn2/2pp4/3P4/1P1BPN2/PBPN1PPP/R2Q1RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "6k1/1p3pp1/p1b1p2p/q3P3/2pP4/2P2N1P/P4PP1/3Q2K1 w - - 0 25",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+    };
+
+    // Timed runs per benchmark; the median is reported.
+    constexpr int SAMPLES{5};
+
+    struct Options {
+        std::string filter{};
+        int min_time_ms{100};
+        int depth{8};
+        std::string json_path{};
+    };
+
+    void print_usage() {
+        std::cout
+                << "Usage: engine_bench [options]\n"
+                << "  --filter <text>    run only benchmarks whose name contains the text\n"
+                << "  --min-time <ms>    minimum duration of each timed run (default: 100)\n"
+                << "  --depth <N>        depth of the signature search, 0 to skip (default: 8)\n"
+                << "  --json <path>      also write the results as JSON, '-' for stdout\n";
+    }
+
+    Options parse_options(const int argc, char **argv) {
+        Options options{};
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg{argv[i]};
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--filter") {
+                options.filter = value();
+            } else if (arg == "--min-time") {
+                options.min_time_ms = std::max(1, std::stoi(value()));
+            } else if (arg == "--depth") {
+                options.depth = std::max(0, std::stoi(value()));
+            } else if (arg == "--json") {
+                options.json_path = value();
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+        return options;
+    }
+
+    // Results are folded into this so that the compiler cannot drop the
+    // calls being measured.
+    volatile uint64_t sink{0};
+
+    struct Benchmark {
+        std::string name;
+        // One pass over the corpus; returns the number of operations made.
+        std::function<uint64_t()> pass;
+    };
+
+    struct Result {
+        std::string name;
+        double ns_per_op;
+        uint64_t ops;
+    };
+
+    struct Signature {
+        int depth;
+        uint64_t nodes;
+        double seconds;
+    };
+
+    // Repeats passes until they last at least `min_time_ms`, then takes the
+    // median ns/op of SAMPLES such runs.
+    Result measure(const Benchmark &benchmark, const int &min_time_ms) {
+        using clock = std::chrono::steady_clock;
+        const auto min_time{std::chrono::milliseconds{min_time_ms}};
+
+        uint64_t passes{1};
+        while (true) {
+            const auto start{clock::now()};
+            for (uint64_t i = 0; i < passes; ++i) {
+                static_cast<void>(benchmark.pass());
+            }
+            const auto elapsed{clock::now() - start};
+            if (elapsed >= min_time / 4) {
+                const double scale{
+                    std::chrono::duration<double>(min_time).count() /
+                    std::chrono::duration<double>(elapsed).count()
+                };
+                passes = std::max<uint64_t>(
+                    1, static_cast<uint64_t>(passes * scale) + 1);
+                break;
+            }
+            passes *= 2;
+        }
+
+        std::array<double, SAMPLES> samples{};
+        uint64_t ops{0};
+        for (double &sample: samples) {
+            ops = 0;
+            const auto start{clock::now()};
+            for (uint64_t i = 0; i < passes; ++i) {
+                ops += benchmark.pass();
+            }
+            const double ns{
+                std::chrono::duration<double, std::nano>(clock::now() - start).count()
+            };
+            sample = ns / std::max<uint64_t>(ops, 1);
+        }
+        std::ranges::sort(samples);
+        return {benchmark.name, samples[SAMPLES / 2], ops};
+    }
+
+    // Squares of every piece of one type, of either color, per position.
+    std::vector<std::vector<std::pair<int, int> > > pieces_of(
+        const std::vector<Board> &boards, const PieceType &type) {
+        std::vector<std::vector<std::pair<int, int> > > squares(boards.size());
+        for (std::size_t b = 0; b < boards.size(); ++b) {
+            for (int row = 0; row < BOARD_SIZE; ++row) {
+                for (int col = 0; col < BOARD_SIZE; ++col) {
+                    if (boards[b].get_piece({row, col}).type == type) {
+                        squares[b].emplace_back(row, col);
+                    }
+                }
+            }
+        }
+        return squares;
+    }
+
+    struct QuietMove {
+        Board *board;
+        std::pair<int, int> from;
+        std::pair<int, int> to;
+    };
+
+    // A move of the side to move onto an empty square per position, so that
+    // moving the piece back restores the position.
+    std::vector<QuietMove> quiet_moves(std::vector<Board> &boards) {
+        std::vector<QuietMove> moves{};
+        for (Board &board: boards) {
+            for (const auto &[from, entry]: board.get_all_valid_moves_raw(false, true)) {
+                const auto quiet{
+                    std::ranges::find_if(entry.second, [&](const auto &to) {
+                        return board.get_piece(to).is_empty();
+                    })
+                };
+                if (entry.first.isWhite == board.is_white_turn() &&
+                    quiet != entry.second.end()) {
+                    moves.push_back({&board, from, *quiet});
+                    break;
+                }
+            }
+        }
+        return moves;
+    }
+
+    std::vector<Benchmark> make_benchmarks(std::vector<Board> &boards) {
+        std::vector<Benchmark> benchmarks{};
+
+        constexpr std::array<std::pair<PieceType, const char *>, 6> TYPES{
+            {
+                {PieceType::PAWN, "pawn"}, {PieceType::KNIGHT, "knight"},
+                {PieceType::BISHOP, "bishop"}, {PieceType::ROOK, "rook"},
+                {PieceType::QUEEN, "queen"}, {PieceType::KING, "king"}
+            }
+        };
+        for (const auto &[type, type_name]: TYPES) {
+            benchmarks.push_back({
+                std::string{"get_valid_moves_raw/"} + type_name,
+                [&boards, squares = pieces_of(boards, type)] {
+                    uint64_t ops{0};
+                    for (std::size_t b = 0; b < boards.size(); ++b) {
+                        for (const auto &pos: squares[b]) {
+                            sink = sink + boards[b].get_valid_moves_raw(
+                                       pos, false, true).size();
+                            ++ops;
+                        }
+                    }
+                    return ops;
+                }
+            });
+        }
+
+        benchmarks.push_back({
+            "get_all_valid_moves_raw", [&boards] {
+                for (Board &board: boards) {
+                    sink = sink + board.get_all_valid_moves_raw(false, true).size();
+                }
+                return static_cast<uint64_t>(boards.size());
+            }
+        });
+
+        benchmarks.push_back({
+            "is_under_attack", [&boards] {
+                uint64_t ops{0};
+                for (const Board &board: boards) {
+                    for (int row = 0; row < BOARD_SIZE; ++row) {
+                        for (int col = 0; col < BOARD_SIZE; ++col) {
+                            const std::pair<int, int> pos{row, col};
+                            sink = sink + board.is_under_attack(pos, true) +
+                                   board.is_under_attack(pos, false);
+                            ops += 2;
+                        }
+                    }
+                }
+                return ops;
+            }
+        });
+
+        benchmarks.push_back({
+            "in_check", [&boards] {
+                for (const Board &board: boards) {
+                    sink = sink + board.in_check(true) + board.in_check(false);
+                }
+                return static_cast<uint64_t>(2 * boards.size());
+            }
+        });
+
+        benchmarks.push_back({
+            "make_move_raw", [moves = quiet_moves(boards)] {
+                for (const auto &[board, from, to]: moves) {
+                    board->make_move_raw(from, to);
+                    board->make_move_raw(to, from);
+                }
+                return static_cast<uint64_t>(2 * moves.size());
+            }
+        });
+
+        benchmarks.push_back({
+            "fen_round_trip", [&boards] {
+                for (Board &board: boards) {
+                    sink = sink + board.set_fen(board.fen());
+                }
+                return static_cast<uint64_t>(boards.size());
+            }
+        });
+
+        benchmarks.push_back({
+            "to_string", [&boards] {
+                for (const Board &board: boards) {
+                    sink = sink + board.to_string().size();
+                }
+                return static_cast<uint64_t>(boards.size());
+            }
+        });
+        return benchmarks;
+    }
+
+    // Total nodes of a single-threaded fixed-depth search of every position
+    // from a cold table. It changes only when the search itself does, so a
+    // commit that should not change the search can be checked against it.
+    // The positions are set up afresh, whatever the benchmarks did to theirs.
+    Signature signature(const int &depth) {
+        TranspositionTable tt{16};
+        ParallelSearch search{tt, 1};
+        SearchLimits limits{};
+        limits.depth = depth;
+
+        Signature signature{depth, 0, 0};
+        for (const char *fen: POSITIONS) {
+            const Board board{fen};
+            tt.clear();
+            search.clear();
+            const auto start{std::chrono::steady_clock::now()};
+            signature.nodes += search.run(board, limits).nodes;
+            signature.seconds += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+        return signature;
+    }
+
+    std::string to_json(const std::vector<Result> &results,
+                        const Signature *signature) {
+        std::ostringstream out{};
+        out << std::fixed << std::setprecision(3) << "{\"positions\": "
+                << POSITIONS.size();
+        if (signature != nullptr) {
+            out << ", \"signature\": {\"depth\": " << signature->depth
+                    << ", \"nodes\": " << signature->nodes
+                    << ", \"ms\": " << signature->seconds * 1e3 << ", \"nps\": "
+                    << static_cast<uint64_t>(
+                        signature->nodes / std::max(signature->seconds, 1e-9))
+                    << '}';
+        }
+        out << ", \"benchmarks\": [";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            out << (i > 0 ? ", " : "") << "{\"name\": \"" << results[i].name
+                    << "\", \"ns_per_op\": " << results[i].ns_per_op
+                    << ", \"ops\": " << results[i].ops << '}';
+        }
+        out << "]}";
+        return out.str();
+    }
+}
+
+int main(const int argc, char **argv) {
+    Options options{};
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Board> boards{};
+    for (const char *fen: POSITIONS) {
+        boards.emplace_back(fen);
+    }
+
+    std::vector<Result> results{};
+    std::cout << POSITIONS.size() << " positions, median of " << SAMPLES
+            << " runs of at least " << options.min_time_ms << " ms\n"
+            << std::left << std::setw(30) << "benchmark" << std::right
+            << std::setw(12) << "ns/op" << std::setw(14) << "ops" << '\n';
+    for (const Benchmark &benchmark: make_benchmarks(boards)) {
+        if (benchmark.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        results.push_back(measure(benchmark, options.min_time_ms));
+        const Result &result{results.back()};
+        std::cout << std::fixed << std::setprecision(1) << std::left
+                << std::setw(30) << result.name << std::right
+                << std::setw(12) << result.ns_per_op
+                << std::setw(14) << result.ops << '\n';
+    }
+
+    Signature bench{};
+    if (options.depth > 0) {
+        bench = signature(options.depth);
+        std::cout << "bench: " << bench.nodes << " nodes at depth " << bench.depth
+                << ", " << static_cast<uint64_t>(
+                    bench.nodes / std::max(bench.seconds, 1e-9)) << " nps\n";
+    }
+
+    if (!options.json_path.empty()) {
+        const std::string json{
+            to_json(results, options.depth > 0 ? &bench : nullptr)
+        };
+        if (options.json_path == "-") {
+            std::cout << json << '\n';
+        } else {
+            std::ofstream file{options.json_path};
+            file << json << '\n';
+            if (!file) {
+                std::cerr << "Could not write " << options.json_path << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
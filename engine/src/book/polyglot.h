@@ -0,0 +1,69 @@
+#ifndef POLYGLOT_H
+#define POLYGLOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "chess/board.h"
+#include "chess/move.h"
+#include "util/mapped_file.h"
+
+// One 16-byte record of a Polyglot book, as stored big-endian on disk.
+struct PolyglotEntry {
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+    uint32_t learn;
+};
+
+struct BookMove {
+    Move move;
+    uint16_t weight;
+};
+
+// Opening book in the Polyglot .bin format: entries sorted by position key,
+// probed by binary search over the memory-mapped file. Positions are keyed
+// by polyglot_key(), so books made by other tools match.
+class PolyglotBook {
+public:
+    PolyglotBook() = default;
+
+    // Throws std::invalid_argument if the file cannot be mapped or is not a
+    // whole number of entries.
+    explicit PolyglotBook(const std::string &path);
+
+    [[nodiscard]] std::size_t size() const;
+
+    // Writes the legal book moves of the position into `moves` and returns
+    // how many there are, up to moves.size(). Does not allocate.
+    std::size_t probe(const Board &board, std::span<BookMove> moves) const;
+
+    // Picks a book move with probability proportional to its weight, using
+    // `random` as the source of randomness. Returns Move::none() if the
+    // position is not in the book.
+    [[nodiscard]] Move pick(const Board &board, const uint64_t &random) const;
+
+private:
+    [[nodiscard]] PolyglotEntry entry(const std::size_t &index) const;
+
+    MappedFile file{};
+    std::size_t count{0};
+};
+
+// The Polyglot key of the position, from the format's own Random64 table.
+// Unrelated to Board::key().
+[[nodiscard]] uint64_t polyglot_key(const Board &board);
+
+// Polyglot encoding of a move, with castling written as the king taking its
+// own rook.
+uint16_t to_polyglot_move(const Move &move);
+
+// Sorts the entries by key, merging the weights of duplicate moves, and
+// writes them as a Polyglot book. Throws std::invalid_argument if the file
+// cannot be written.
+void write_book(const std::string &path, std::vector<PolyglotEntry> entries);
+
+#endif //POLYGLOT_H
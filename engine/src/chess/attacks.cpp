@@ -0,0 +1,166 @@
+#include <array>
+#include <span>
+
+#include "attacks.h"
+
+std::array<Magic, NUM_SQUARES> attack_tables::ROOK_MAGICS{};
+std::array<Magic, NUM_SQUARES> attack_tables::BISHOP_MAGICS{};
+std::array<std::array<Bitboard, NUM_SQUARES>, NUM_SQUARES>
+attack_tables::BETWEEN{};
+std::array<std::array<Bitboard, NUM_SQUARES>, NUM_SQUARES>
+attack_tables::LINE{};
+
+namespace {
+    // Total number of attack sets over all squares for each slider type.
+    constexpr std::size_t ROOK_TABLE_SIZE{0x19000};
+    constexpr std::size_t BISHOP_TABLE_SIZE{0x1480};
+
+    std::array<Bitboard, ROOK_TABLE_SIZE> rook_table{};
+    std::array<Bitboard, BISHOP_TABLE_SIZE> bishop_table{};
+
+    constexpr std::array<std::pair<int, int>, 4> ROOK_DIRECTIONS{
+        {{-1, 0}, {1, 0}, {0, -1}, {0, 1}}
+    };
+    constexpr std::array<std::pair<int, int>, 4> BISHOP_DIRECTIONS{
+        {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}}
+    };
+
+    // Reference slider attacks, walking each ray until it leaves the board or
+    // hits an occupied square. Only used to build the lookup tables.
+    Bitboard sliding_attacks(const std::array<std::pair<int, int>, 4> &directions,
+                             const int sq, const Bitboard occupied) {
+        Bitboard attacks{EMPTY_BB};
+        for (const auto &[dr, df]: directions) {
+            int r{rank_of(sq) + dr}, f{file_of(sq) + df};
+            while (0 <= r && r < 8 && 0 <= f && f < 8) {
+                const Bitboard bb{square_bb(r * 8 + f)};
+                attacks |= bb;
+                if (occupied & bb) {
+                    break;
+                }
+                r += dr;
+                f += df;
+            }
+        }
+        return attacks;
+    }
+
+    // xorshift64* generator; fixed seeds keep the magic search reproducible.
+    class Prng {
+    public:
+        explicit Prng(const uint64_t seed) : state{seed} {}
+
+        uint64_t next() {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 2685821657736338717ULL;
+        }
+
+        // Candidates with few set bits make good magics far more often.
+        uint64_t sparse() {
+            return next() & next() & next();
+        }
+
+    private:
+        uint64_t state;
+    };
+
+    void init_magics(const std::array<std::pair<int, int>, 4> &directions,
+                     const std::span<Bitboard> table,
+                     std::array<Magic, NUM_SQUARES> &magics) {
+        std::array<Bitboard, 4096> occupancy{};
+        std::array<Bitboard, 4096> reference{};
+        std::size_t offset{0};
+#ifndef __BMI2__
+        // Seeds per rank that find magics quickly.
+        constexpr std::array<uint64_t, 8> seeds{
+            728, 10316, 55013, 32803, 12281, 15100, 16645, 255
+        };
+        std::array<int, 4096> epoch{};
+        int attempt{0};
+#endif
+
+        for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+            // Edge squares never block a ray that ends on them, so they are
+            // left out of the mask unless the slider itself is on that edge.
+            const Bitboard edges{
+                ((RANK_1_BB | RANK_8_BB) & ~rank_bb(rank_of(sq))) |
+                ((FILE_A_BB | FILE_H_BB) & ~file_bb(file_of(sq)))
+            };
+
+            Magic &m{magics[sq]};
+            m.mask = sliding_attacks(directions, sq, EMPTY_BB) & ~edges;
+            m.shift = static_cast<unsigned>(NUM_SQUARES - popcount(m.mask));
+            Bitboard *attacks{table.data() + offset};
+            m.attacks = attacks;
+
+            // Enumerate every subset of the mask (Carry-Rippler trick).
+            int size{0};
+            Bitboard b{EMPTY_BB};
+            do {
+                occupancy[size] = b;
+                reference[size] = sliding_attacks(directions, sq, b);
+#ifdef __BMI2__
+                attacks[_pext_u64(b, m.mask)] = reference[size];
+#endif
+                ++size;
+                b = (b - m.mask) & m.mask;
+            } while (b);
+            offset += static_cast<std::size_t>(size);
+
+#ifndef __BMI2__
+            // Try random candidates until one maps every occupancy subset to
+            // an index holding the correct attack set. Collisions between
+            // subsets with identical attacks are harmless.
+            Prng prng{seeds[rank_of(sq)]};
+            for (int i = 0; i < size;) {
+                do {
+                    m.magic = prng.sparse();
+                } while (popcount((m.magic * m.mask) >> 56) < 6);
+
+                ++attempt;
+                for (i = 0; i < size; ++i) {
+                    const unsigned idx{m.index(occupancy[i])};
+                    if (epoch[idx] < attempt) {
+                        epoch[idx] = attempt;
+                        attacks[idx] = reference[i];
+                    } else if (attacks[idx] != reference[i]) {
+                        break;
+                    }
+                }
+            }
+#endif
+        }
+    }
+
+    // Line and between sets for every pair of aligned squares, derived from
+    // the finished slider tables.
+    void init_lines() {
+        for (int a = 0; a < NUM_SQUARES; ++a) {
+            for (int b = 0; b < NUM_SQUARES; ++b) {
+                for (const auto attacks: {bishop_attacks, rook_attacks}) {
+                    if (attacks(a, EMPTY_BB) & square_bb(b)) {
+                        attack_tables::LINE[a][b] =
+                                (attacks(a, EMPTY_BB) & attacks(b, EMPTY_BB)) |
+                                square_bb(a) | square_bb(b);
+                        attack_tables::BETWEEN[a][b] =
+                                attacks(a, square_bb(b)) &
+                                attacks(b, square_bb(a));
+                    }
+                }
+            }
+        }
+    }
+
+    // Builds the slider tables when the library is loaded, so lookups never
+    // need an initialization check.
+    const struct SliderTableInit {
+        SliderTableInit() {
+            init_magics(ROOK_DIRECTIONS, rook_table, attack_tables::ROOK_MAGICS);
+            init_magics(BISHOP_DIRECTIONS, bishop_table,
+                        attack_tables::BISHOP_MAGICS);
+            init_lines();
+        }
+    } slider_table_init{};
+}
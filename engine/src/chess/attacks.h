@@ -0,0 +1,141 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include <array>
+#include <cstdint>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#include "bitboard.h"
+#include "piece.h"
+
+// ------------------------- Leaper Attack Tables -------------------------
+
+namespace attack_tables {
+    // Attacks of a piece on `sq` that jumps by the given (rank, file) offsets,
+    // ignoring offsets that leave the board.
+    template<std::size_t N>
+    constexpr std::array<Bitboard, NUM_SQUARES> leaper(
+        const std::array<std::pair<int, int>, N> &offsets) {
+        std::array<Bitboard, NUM_SQUARES> table{};
+        for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+            for (const auto &[dr, df]: offsets) {
+                const int r{rank_of(sq) + dr}, f{file_of(sq) + df};
+                if (0 <= r && r < 8 && 0 <= f && f < 8) {
+                    table[sq] |= square_bb(r * 8 + f);
+                }
+            }
+        }
+        return table;
+    }
+
+    inline constexpr std::array<Bitboard, NUM_SQUARES> KNIGHT{
+        leaper(std::array<std::pair<int, int>, 8>{
+            {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}}
+        })
+    };
+
+    inline constexpr std::array<Bitboard, NUM_SQUARES> KING{
+        leaper(std::array<std::pair<int, int>, 8>{
+            {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}}
+        })
+    };
+
+    // Indexed by color_index(): white pawns capture towards the 8th rank.
+    inline constexpr std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLORS> PAWN{
+        {
+            leaper(std::array<std::pair<int, int>, 2>{{{1, -1}, {1, 1}}}),
+            leaper(std::array<std::pair<int, int>, 2>{{{-1, -1}, {-1, 1}}})
+        }
+    };
+}
+
+constexpr Bitboard knight_attacks(const int sq) {
+    return attack_tables::KNIGHT[sq];
+}
+
+constexpr Bitboard king_attacks(const int sq) {
+    return attack_tables::KING[sq];
+}
+
+// Squares attacked by a pawn of the given color standing on `sq`.
+constexpr Bitboard pawn_attacks(const bool white, const int sq) {
+    return attack_tables::PAWN[white ? 0 : 1][sq];
+}
+
+// ------------------------- Slider Attack Tables -------------------------
+
+// Lookup entry for one square of one slider type. With BMI2 the relevant
+// occupancy bits are gathered by PEXT; otherwise they are hashed into a
+// dense index with a multiply and shift ("fancy" magic bitboards).
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    const Bitboard *attacks;
+    unsigned shift;
+
+    [[nodiscard]] unsigned index(const Bitboard occupied) const {
+#ifdef __BMI2__
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+namespace attack_tables {
+    // Filled in once when the library is loaded (see attacks.cpp).
+    extern std::array<Magic, NUM_SQUARES> ROOK_MAGICS;
+    extern std::array<Magic, NUM_SQUARES> BISHOP_MAGICS;
+    extern std::array<std::array<Bitboard, NUM_SQUARES>, NUM_SQUARES> BETWEEN;
+    extern std::array<std::array<Bitboard, NUM_SQUARES>, NUM_SQUARES> LINE;
+}
+
+inline Bitboard rook_attacks(const int sq, const Bitboard occupied) {
+    const Magic &m{attack_tables::ROOK_MAGICS[sq]};
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard bishop_attacks(const int sq, const Bitboard occupied) {
+    const Magic &m{attack_tables::BISHOP_MAGICS[sq]};
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queen_attacks(const int sq, const Bitboard occupied) {
+    return rook_attacks(sq, occupied) | bishop_attacks(sq, occupied);
+}
+
+// Squares strictly between two squares on a common rank, file or diagonal;
+// empty if the squares are not aligned.
+inline Bitboard between_bb(const int a, const int b) {
+    return attack_tables::BETWEEN[a][b];
+}
+
+// The whole rank, file or diagonal through two aligned squares; empty if the
+// squares are not aligned.
+inline Bitboard line_bb(const int a, const int b) {
+    return attack_tables::LINE[a][b];
+}
+
+// Squares attacked by a knight, bishop, rook, queen or king on `sq`.
+inline Bitboard piece_attacks(const PieceType type, const int sq,
+                              const Bitboard occupied) {
+    switch (type) {
+        case PieceType::KNIGHT:
+            return knight_attacks(sq);
+        case PieceType::BISHOP:
+            return bishop_attacks(sq, occupied);
+        case PieceType::ROOK:
+            return rook_attacks(sq, occupied);
+        case PieceType::QUEEN:
+            return queen_attacks(sq, occupied);
+        case PieceType::KING:
+            return king_attacks(sq);
+        default:
+            return EMPTY_BB;
+    }
+}
+
+#endif //ATTACKS_H
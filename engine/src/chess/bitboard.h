@@ -0,0 +1,81 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+// A set of squares, one bit per square. Squares are numbered little-endian
+// rank-file: a1 = 0, b1 = 1, ..., h1 = 7, a2 = 8, ..., h8 = 63.
+using Bitboard = uint64_t;
+
+constexpr int NUM_SQUARES{64};
+// Marks an absent square, e.g. when no en passant capture is possible.
+constexpr int NO_SQUARE{64};
+constexpr int NUM_COLORS{2};
+constexpr int NUM_PIECE_BBS{12};
+
+constexpr Bitboard EMPTY_BB{0};
+
+constexpr Bitboard RANK_1_BB{0xFFULL};
+constexpr Bitboard RANK_2_BB{RANK_1_BB << 8};
+constexpr Bitboard RANK_3_BB{RANK_1_BB << 16};
+constexpr Bitboard RANK_6_BB{RANK_1_BB << 40};
+constexpr Bitboard RANK_7_BB{RANK_1_BB << 48};
+constexpr Bitboard RANK_8_BB{RANK_1_BB << 56};
+constexpr Bitboard FILE_A_BB{0x0101010101010101ULL};
+constexpr Bitboard FILE_H_BB{FILE_A_BB << 7};
+
+// Converts a (row, col) board position, where row 0 is the 8th rank, into a
+// square index.
+constexpr int square_of(const std::pair<int, int> &pos) {
+    return (7 - pos.first) * 8 + pos.second;
+}
+
+// Converts a square index back into a (row, col) board position.
+constexpr std::pair<int, int> position_of(const int sq) {
+    return {7 - (sq >> 3), sq & 7};
+}
+
+constexpr int rank_of(const int sq) {
+    return sq >> 3;
+}
+
+constexpr int file_of(const int sq) {
+    return sq & 7;
+}
+
+constexpr Bitboard square_bb(const int sq) {
+    return Bitboard{1} << sq;
+}
+
+constexpr Bitboard rank_bb(const int rank) {
+    return RANK_1_BB << (8 * rank);
+}
+
+constexpr Bitboard file_bb(const int file) {
+    return FILE_A_BB << file;
+}
+
+// Shifts every square one rank towards the opponent of the given color.
+constexpr Bitboard push_bb(const Bitboard b, const bool white) {
+    return white ? b << 8 : b >> 8;
+}
+
+constexpr int popcount(const Bitboard b) {
+    return std::popcount(b);
+}
+
+// Index of the least significant set bit. Undefined for an empty set.
+constexpr int lsb(const Bitboard b) {
+    return std::countr_zero(b);
+}
+
+// Removes the least significant set bit and returns its index.
+constexpr int pop_lsb(Bitboard &b) {
+    const int sq{lsb(b)};
+    b &= b - 1;
+    return sq;
+}
+
+#endif //BITBOARD_H
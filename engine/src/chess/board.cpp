@@ -1,133 +1,471 @@
 #include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
 #include <vector>
-#include <ranges>
 
+#include "attacks.h"
 #include "board.h"
+#include "util/stats.h"
+#include "zobrist.h"
+
+namespace {
+    // Castling rights that survive a move from or to each square: moving the
+    // king or a rook, or capturing a rook, gives up the matching rights.
+    constexpr std::array<uint8_t, NUM_SQUARES> CASTLING_MASK{
+        [] {
+            std::array<uint8_t, NUM_SQUARES> mask{};
+            mask.fill(ALL_CASTLING);
+            mask[0] = ALL_CASTLING & ~WHITE_QUEEN_SIDE;
+            mask[4] = ALL_CASTLING & ~(WHITE_KING_SIDE | WHITE_QUEEN_SIDE);
+            mask[7] = ALL_CASTLING & ~WHITE_KING_SIDE;
+            mask[56] = ALL_CASTLING & ~BLACK_QUEEN_SIDE;
+            mask[60] = ALL_CASTLING & ~(BLACK_KING_SIDE | BLACK_QUEEN_SIDE);
+            mask[63] = ALL_CASTLING & ~BLACK_KING_SIDE;
+            return mask;
+        }()
+    };
+
+    constexpr Piece NO_PIECE{PieceType::EMPTY, false};
+
+    // Checks a (row, col) position from the public API once, so that the
+    // rest of the call can work on a square.
+    Square checked_square(const std::pair<int, int> &pos) {
+        if (!Square::is_valid(pos)) {
+            const std::string error_msg{
+                "Invalid row or column specified (board size: " +
+                std::to_string(BOARD_SIZE) + "x" + std::to_string(BOARD_SIZE) +
+                ")"
+            };
+            throw std::out_of_range(error_msg);
+        }
+        return Square::from_position(pos);
+    }
+
+    // FEN letters of the black pieces, indexed by piece type minus one.
+    constexpr std::string_view PIECE_CHARS{"pnbrqk"};
+
+    // Pieces of render()'s Unicode diagram. Squares are the piece glyph and
+    // a space.
+    constexpr std::string_view UNICODE_TOP{"  ┌─────────────────┐\n"};
+    constexpr std::string_view UNICODE_RANK{" │ "};
+    constexpr std::string_view UNICODE_ROW_END{"│\n"};
+    constexpr std::string_view UNICODE_BOTTOM{
+        "  └─────────────────┘\n    a b c d e f g h "
+    };
+    static_assert(UNICODE_TOP.size() +
+                  BOARD_SIZE * (1 + UNICODE_RANK.size() + BOARD_SIZE * 4 +
+                                UNICODE_ROW_END.size()) +
+                  UNICODE_BOTTOM.size() <= MAX_RENDER_LENGTH);
+    static_assert(MAX_FEN_LENGTH <= MAX_RENDER_LENGTH);
+
+    // render()'s ASCII diagram has a fixed width, so it is a template in
+    // which only the squares are filled in.
+    constexpr std::string_view ASCII_BORDER{"  +-----------------+\n"};
+    constexpr std::string_view ASCII_FILES{"    a b c d e f g h "};
+    constexpr std::size_t ASCII_ROW_LENGTH{22};
+    constexpr std::size_t ASCII_FIRST_SQUARE{ASCII_BORDER.size() + 4};
+    constexpr std::array<char, ASCII_BORDER.size() * 2 +
+                               BOARD_SIZE * ASCII_ROW_LENGTH +
+                               ASCII_FILES.size()> ASCII_TEMPLATE{
+        [] {
+            std::array<char, ASCII_BORDER.size() * 2 +
+                             BOARD_SIZE * ASCII_ROW_LENGTH +
+                             ASCII_FILES.size()> diagram{};
+            auto out{diagram.begin()};
+            auto write = [&out](const std::string_view text) {
+                for (const char c: text) {
+                    *out++ = c;
+                }
+            };
+            write(ASCII_BORDER);
+            for (int row = 0; row < BOARD_SIZE; ++row) {
+                *out++ = static_cast<char>('8' - row);
+                write(" | . . . . . . . . |\n");
+            }
+            write(ASCII_BORDER);
+            write(ASCII_FILES);
+            return diagram;
+        }()
+    };
+
+    // FEN letters indexed by Piece::code(), '.' for empty squares.
+    constexpr std::array<char, NUM_PIECE_CODES> ASCII_GLYPHS{
+        '.', 'p', 'n', 'b', 'r', 'q', 'k', '?',
+        '.', 'P', 'N', 'B', 'R', 'Q', 'K', '?'
+    };
+
+    constexpr std::array<std::pair<uint8_t, char>, 4> CASTLING_CHARS{
+        {
+            {WHITE_KING_SIDE, 'K'}, {WHITE_QUEEN_SIDE, 'Q'},
+            {BLACK_KING_SIDE, 'k'}, {BLACK_QUEEN_SIDE, 'q'}
+        }
+    };
+
+    // Parses a whole field as a non-negative decimal number.
+    bool parse_number(const std::string_view field, int &value) {
+        int parsed{};
+        const auto [end, error]{
+            std::from_chars(field.data(), field.data() + field.size(), parsed)
+        };
+        if (error != std::errc{} || end != field.data() + field.size() ||
+            parsed < 0) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+}
 
 Board::Board() {
     // Initialize to be empty
-    for (std::array<Piece, BOARD_SIZE> &row: board) {
-        std::ranges::fill(row, Piece{PieceType::EMPTY, true});
-    }
-
-    // Initialize black pieces
-    board[0][0] = board[0][7] = Piece{PieceType::ROOK, false};
-    board[0][1] = board[0][6] = Piece{PieceType::KNIGHT, false};
-    board[0][2] = board[0][5] = Piece{PieceType::BISHOP, false};
-    board[0][3] = Piece{PieceType::QUEEN, false};
-    board[0][4] = Piece{PieceType::KING, false};
-    std::ranges::fill(board[1], Piece{PieceType::PAWN, false});
-
-    // Initialize white pieces
-    board[7][0] = board[7][7] = Piece{PieceType::ROOK, true};
-    board[7][1] = board[7][6] = Piece{PieceType::KNIGHT, true};
-    board[7][2] = board[7][5] = Piece{PieceType::BISHOP, true};
-    board[7][3] = Piece{PieceType::QUEEN, true};
-    board[7][4] = Piece{PieceType::KING, true};
-    std::ranges::fill(board[6], Piece{PieceType::PAWN, true});
+    mailbox.fill(Piece{PieceType::EMPTY, true}.code());
+
+    // Initialize white and black pieces, file by file
+    constexpr std::array<PieceType, BOARD_SIZE> back_rank{
+        PieceType::ROOK, PieceType::KNIGHT, PieceType::BISHOP,
+        PieceType::QUEEN, PieceType::KING, PieceType::BISHOP,
+        PieceType::KNIGHT, PieceType::ROOK
+    };
+    for (int file = 0; file < BOARD_SIZE; ++file) {
+        place_piece(square_of({7, file}), Piece{back_rank[file], true});
+        place_piece(square_of({6, file}), Piece{PieceType::PAWN, true});
+        place_piece(square_of({1, file}), Piece{PieceType::PAWN, false});
+        place_piece(square_of({0, file}), Piece{back_rank[file], false});
+    }
 
     // Initialize control variables
-    white_king_side_castle = white_queen_side_castle =
-                             black_king_side_castle =
-                             black_queen_side_castle = true;
+    castling = ALL_CASTLING;
     white_turn = true;
+    undo_stack.reserve(256);
+    hash = compute_key();
 }
 
-Piece Board::get_piece(const std::pair<int, int> &pos) const {
-    if (pos.first >= 0 && pos.first < BOARD_SIZE && pos.second >= 0 && pos.
-        second < BOARD_SIZE) {
-        return board[pos.first][pos.second];
+Board::Board(const std::string &fen) {
+    undo_stack.reserve(256);
+    if (!set_fen(fen)) {
+        const std::string error_msg{"Invalid FEN specified: " + fen};
+        throw std::invalid_argument(error_msg);
     }
-    const std::string error_msg{
-        "Invalid row or column specified (board size: " +
-        std::to_string(BOARD_SIZE) + "x" + std::to_string(BOARD_SIZE) + ")"
-    };
-    throw std::out_of_range(error_msg);
 }
 
-void Board::set_piece(const std::pair<int, int> &pos, const Piece &piece) {
-    if (pos.first >= 0 && pos.first < BOARD_SIZE && pos.second >= 0 && pos.
-        second < BOARD_SIZE) {
-        board[pos.first][pos.second] = piece;
-    } else {
-        const std::string error_msg{
-            "Invalid row or column specified (board size: " +
-            std::to_string(BOARD_SIZE) + "x" + std::to_string(BOARD_SIZE) + ")"
+bool Board::set_fen(const std::string_view fen) {
+    clear();
+
+    std::size_t pos{0};
+    auto next_field = [&fen, &pos]() -> std::string_view {
+        while (pos < fen.size() && fen[pos] == ' ') {
+            ++pos;
+        }
+        const std::size_t begin{pos};
+        while (pos < fen.size() && fen[pos] != ' ') {
+            ++pos;
+        }
+        return fen.substr(begin, pos - begin);
+    };
+    const std::string_view placement{next_field()};
+    const std::string_view side{next_field()};
+    const std::string_view castling_field{next_field()};
+    const std::string_view en_passant_field{next_field()};
+    const std::string_view halfmove_field{next_field()};
+    const std::string_view fullmove_field{next_field()};
+
+    if (placement.empty() || (side != "w" && side != "b") ||
+        castling_field.empty() || en_passant_field.empty()) {
+        return false;
+    }
+
+    // Piece placement, from the 8th rank down and from the a file across.
+    int row{0}, col{0};
+    for (const char c: placement) {
+        if (c == '/') {
+            if (col != BOARD_SIZE) {
+                return false;
+            }
+            ++row;
+            col = 0;
+        } else if ('1' <= c && c <= '8') {
+            col += c - '0';
+        } else {
+            const auto type{PIECE_CHARS.find(static_cast<char>(c | 0x20))};
+            if (type == std::string_view::npos || row >= BOARD_SIZE ||
+                col >= BOARD_SIZE) {
+                return false;
+            }
+            place_piece(square_of({row, col}), Piece{
+                            static_cast<PieceType>(type + 1), c < 'a'
+                        });
+            ++col;
+        }
+    }
+    if (row != BOARD_SIZE - 1 || col != BOARD_SIZE ||
+        popcount(pieces(Piece{PieceType::KING, true})) != 1 ||
+        popcount(pieces(Piece{PieceType::KING, false})) != 1) {
+        return false;
+    }
+
+    white_turn = side == "w";
+    if (!valid_placement()) {
+        return false;
+    }
+
+    for (const char c: castling_field) {
+        switch (c) {
+            case 'K':
+                castling |= WHITE_KING_SIDE;
+                break;
+            case 'Q':
+                castling |= WHITE_QUEEN_SIDE;
+                break;
+            case 'k':
+                castling |= BLACK_KING_SIDE;
+                break;
+            case 'q':
+                castling |= BLACK_QUEEN_SIDE;
+                break;
+            case '-':
+                if (castling_field.size() != 1) {
+                    return false;
+                }
+                break;
+            default:
+                return false;
+        }
+    }
+
+    if (en_passant_field != "-") {
+        const std::optional<Square> square{
+            Square::from_algebraic(en_passant_field)
         };
-        throw std::out_of_range(error_msg);
+        if (!square || !valid_en_passant(*square)) {
+            return false;
+        }
+        en_passant = *square;
+        // Only kept when a capture is possible, as in make_move.
+        if (!(pawn_attacks(!white_turn, en_passant) &
+              pieces(Piece{PieceType::PAWN, white_turn}))) {
+            en_passant = NO_SQUARE;
+        }
     }
-}
 
-std::string Board::to_string() const {
-    std::string result{"  ┌"};
+    if (!halfmove_field.empty() && !parse_number(halfmove_field, halfmove)) {
+        return false;
+    }
+    // Some sources write a fullmove number of 0; it is read as 1.
+    if (!fullmove_field.empty()) {
+        if (!parse_number(fullmove_field, fullmove)) {
+            return false;
+        }
+        fullmove = std::max(fullmove, 1);
+    }
+
+    hash = compute_key();
+    return true;
+}
 
-    for (int i = 0; i < BOARD_SIZE * 2 + 1; ++i) {
-        result += "─";
+std::size_t Board::write_fen(const std::span<char> buffer) const {
+    if (buffer.size() < MAX_FEN_LENGTH) {
+        return 0;
     }
-    result += "┐\n";
+    char *out{buffer.data()};
 
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        for (int j = 0; j < BOARD_SIZE; ++j) {
-            if (j == 0) {
-                result += std::to_string(8 - i) + " │ ";
+    for (int row = 0; row < BOARD_SIZE; ++row) {
+        int empty{0};
+        for (int col = 0; col < BOARD_SIZE; ++col) {
+            const Piece piece{piece_on(square_of({row, col}))};
+            if (piece.is_empty()) {
+                ++empty;
+                continue;
             }
-            result += board[i][j].to_string() + " ";
-            if (j == BOARD_SIZE - 1) {
-                result += "│";
+            if (empty > 0) {
+                *out++ = static_cast<char>('0' + empty);
+                empty = 0;
             }
+            const char c{PIECE_CHARS[static_cast<int>(piece.type) - 1]};
+            *out++ = piece.isWhite ? static_cast<char>(c & ~0x20) : c;
+        }
+        if (empty > 0) {
+            *out++ = static_cast<char>('0' + empty);
         }
-        result += "\n";
+        if (row != BOARD_SIZE - 1) {
+            *out++ = '/';
+        }
+    }
+
+    *out++ = ' ';
+    *out++ = white_turn ? 'w' : 'b';
+    *out++ = ' ';
+    if (castling == 0) {
+        *out++ = '-';
+    }
+    for (const auto &[right, c]: CASTLING_CHARS) {
+        if (castling & right) {
+            *out++ = c;
+        }
+    }
+    *out++ = ' ';
+    if (en_passant == NO_SQUARE) {
+        *out++ = '-';
+    } else {
+        *out++ = static_cast<char>('a' + file_of(en_passant));
+        *out++ = static_cast<char>('1' + rank_of(en_passant));
+    }
+    *out++ = ' ';
+    out = std::to_chars(out, buffer.data() + buffer.size(), halfmove).ptr;
+    *out++ = ' ';
+    out = std::to_chars(out, buffer.data() + buffer.size(), fullmove).ptr;
+
+    return static_cast<std::size_t>(out - buffer.data());
+}
+
+std::string Board::fen() const {
+    std::array<char, MAX_FEN_LENGTH> buffer;
+    return {buffer.data(), write_fen(buffer)};
+}
+
+PackedPosition Board::pack() const {
+    PackedPosition packed{};
+    std::array<uint8_t, 32> &bytes{packed.bytes};
+
+    Bitboard occupied{occupied_bb};
+    // Keep at most 32 pieces, keeping the occupancy consistent with them.
+    while (popcount(occupied) > 32) {
+        occupied &= ~square_bb(63 - std::countl_zero(occupied));
+    }
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<uint8_t>(occupied >> (8 * i));
+    }
+    for (int i = 0; occupied; ++i) {
+        const int code{piece_index(piece_on(pop_lsb(occupied)))};
+        bytes[8 + i / 2] |= static_cast<uint8_t>(code << (4 * (i % 2)));
     }
 
-    result += "  └";
-    for (int i = 0; i < BOARD_SIZE * 2 + 1; ++i) {
-        result += "─";
+    bytes[24] = static_cast<uint8_t>((white_turn ? 0 : 1) | castling << 1);
+    bytes[25] = static_cast<uint8_t>(en_passant);
+    bytes[26] = static_cast<uint8_t>(std::min(halfmove, 255));
+    bytes[27] = static_cast<uint8_t>(fullmove);
+    bytes[28] = static_cast<uint8_t>(fullmove >> 8);
+    return packed;
+}
+
+bool Board::unpack(const PackedPosition &packed) {
+    clear();
+    const std::array<uint8_t, 32> &bytes{packed.bytes};
+
+    Bitboard occupied{EMPTY_BB};
+    for (int i = 0; i < 8; ++i) {
+        occupied |= Bitboard{bytes[i]} << (8 * i);
+    }
+    if (popcount(occupied) > 32) {
+        return false;
+    }
+    for (int i = 0; occupied; ++i) {
+        const int code{bytes[8 + i / 2] >> (4 * (i % 2)) & 0xF};
+        if (code >= NUM_PIECE_BBS) {
+            return false;
+        }
+        place_piece(pop_lsb(occupied), Piece{
+                        static_cast<PieceType>(code % 6 + 1), code < 6
+                    });
+    }
+    if (popcount(pieces(Piece{PieceType::KING, true})) != 1 ||
+        popcount(pieces(Piece{PieceType::KING, false})) != 1 ||
+        bytes[24] >> 5 != 0 || bytes[25] > NO_SQUARE) {
+        return false;
     }
-    result += "┘\n    ";
 
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        result += std::string(1, static_cast<char>('a' + i)) + " ";
+    white_turn = (bytes[24] & 1) == 0;
+    if (!valid_placement()) {
+        return false;
+    }
+    castling = bytes[24] >> 1;
+    if (bytes[25] != NO_SQUARE && !valid_en_passant(bytes[25])) {
+        return false;
     }
+    en_passant = bytes[25];
+    halfmove = bytes[26];
+    fullmove = std::max(bytes[27] | bytes[28] << 8, 1);
+    hash = compute_key();
+    return true;
+}
 
-    return result;
+Piece Board::get_piece(const std::pair<int, int> &pos) const {
+    return get_piece(checked_square(pos));
+}
+
+Piece Board::get_piece(const Square &sq) const {
+    return piece_on(sq);
+}
+
+void Board::set_piece(const std::pair<int, int> &pos, const Piece &piece) {
+    set_piece(checked_square(pos), piece);
+}
+
+void Board::set_piece(const Square &sq, const Piece &piece) {
+    place_piece(sq, piece);
+}
+
+std::string Board::to_string() const {
+    std::array<char, MAX_RENDER_LENGTH> buffer;
+    return std::string(buffer.data(), render(buffer));
+}
+
+std::size_t Board::render(const std::span<char> buffer,
+                          const RenderMode mode) const {
+    if (buffer.size() < MAX_RENDER_LENGTH) {
+        return 0;
+    }
+
+    switch (mode) {
+        case RenderMode::FEN:
+            return write_fen(buffer);
+        case RenderMode::ASCII:
+            std::ranges::copy(ASCII_TEMPLATE, buffer.begin());
+            for (int row = 0; row < BOARD_SIZE; ++row) {
+                for (int col = 0; col < BOARD_SIZE; ++col) {
+                    buffer[ASCII_FIRST_SQUARE + row * ASCII_ROW_LENGTH +
+                           col * 2] = ASCII_GLYPHS[mailbox[square_of({row, col})]];
+                }
+            }
+            return ASCII_TEMPLATE.size();
+        default:
+            break;
+    }
+
+    char *out{buffer.data()};
+    auto write = [&out](const std::string_view text) {
+        out = std::ranges::copy(text, out).out;
+    };
+    write(UNICODE_TOP);
+    for (int row = 0; row < BOARD_SIZE; ++row) {
+        *out++ = static_cast<char>('8' - row);
+        write(UNICODE_RANK);
+        for (int col = 0; col < BOARD_SIZE; ++col) {
+            write(piece_on(square_of({row, col})).glyph());
+            *out++ = ' ';
+        }
+        write(UNICODE_ROW_END);
+    }
+    write(UNICODE_BOTTOM);
+    return static_cast<std::size_t>(out - buffer.data());
 }
 
 void Board::make_move_raw(const std::pair<int, int> &src_pos,
                           const std::pair<int, int> &dst_pos) {
-    if (src_pos.first >= 0 && src_pos.first < BOARD_SIZE &&
-        src_pos.second >= 0 && src_pos.second < BOARD_SIZE &&
-        dst_pos.first >= 0 && dst_pos.first < BOARD_SIZE &&
-        dst_pos.second >= 0 && dst_pos.second < BOARD_SIZE) {
-        board[dst_pos.first][dst_pos.second] = board[src_pos.first][src_pos.
-            second];
-        board[src_pos.first][src_pos.second] = Piece{
-            PieceType::EMPTY, false
-        };
-    } else {
-        const std::string error_msg{
-            "Invalid row or col specified (board size: " +
-            std::to_string(BOARD_SIZE) + "x" + std::to_string(BOARD_SIZE) +
-            ")"
-        };
-        throw std::out_of_range(error_msg);
-    }
+    const Square from{checked_square(src_pos)};
+    make_move_raw(from, checked_square(dst_pos));
+}
+
+void Board::make_move_raw(const Square &from, const Square &to) {
+    place_piece(to, piece_on(from));
+    place_piece(from, NO_PIECE);
 }
 
 void Board::make_move(const std::pair<int, int> &src_pos,
                       const std::pair<int, int> &dst_pos,
-                      const std::optional<PieceType> promotion_piece =
-                              std::nullopt) {
-    if (src_pos.first < 0 || src_pos.first >= BOARD_SIZE ||
-        src_pos.second < 0 || src_pos.second >= BOARD_SIZE ||
-        dst_pos.first < 0 || dst_pos.first >= BOARD_SIZE ||
-        dst_pos.second < 0 || dst_pos.second >= BOARD_SIZE) {
-        const std::string error_msg{
-            "Invalid row or col specified (board size: " +
-            std::to_string(BOARD_SIZE) + "x" + std::to_string(BOARD_SIZE) +
-            ")"
-        };
-        throw std::out_of_range(error_msg);
-    }
+                      const std::optional<PieceType> promotion_piece) {
+    const Square from{checked_square(src_pos)};
+    const Square to{checked_square(dst_pos)};
 
     if (src_pos.first == dst_pos.first && src_pos.second == dst_pos.second) {
         const std::string error_msg{
@@ -137,79 +475,387 @@ void Board::make_move(const std::pair<int, int> &src_pos,
     }
 
     if (promotion_piece.has_value()) {
-        if (promotion_piece.value() != PieceType::ROOK || promotion_piece.
-            value() != PieceType::KNIGHT || promotion_piece.value() !=
-            PieceType::BISHOP || promotion_piece.value() != PieceType::QUEEN) {
+        if (promotion_piece.value() != PieceType::ROOK && promotion_piece.
+            value() != PieceType::KNIGHT && promotion_piece.value() !=
+            PieceType::BISHOP && promotion_piece.value() != PieceType::QUEEN) {
             const std::string error_msg{"Invalid promotion piece specified"};
             throw std::invalid_argument(error_msg);
         }
     }
 
-    if (board[src_pos.first][src_pos.second].type == PieceType::EMPTY) {
+    const Piece moving{piece_on(from)};
+    if (moving.type == PieceType::EMPTY) {
         const std::string error_msg{"Empty start square specified"};
         throw std::invalid_argument(error_msg);
     }
 
-    if ((board[src_pos.first][src_pos.second].type == PieceType::PAWN && board[
-             src_pos.first][src_pos.second].isWhite && dst_pos.first == 0 && !
-         promotion_piece.has_value()) || (
-            board[src_pos.first][src_pos.second].type == PieceType::PAWN && !
-            board[src_pos.first][src_pos.second].isWhite && dst_pos.first == 7
-            && !promotion_piece.has_value())) {
+    if (moving.type == PieceType::PAWN &&
+        dst_pos.first == (moving.isWhite ? 0 : 7) &&
+        !promotion_piece.has_value()) {
         const std::string error_msg{
             "Promotion piece not specified for pawn promotion"
         };
         throw std::invalid_argument(error_msg);
     }
 
-    if (board[src_pos.first][src_pos.second].isWhite != white_turn) {
+    if (moving.isWhite != white_turn) {
         const std::string error_msg{
             "Cannot this color piece on this turn (white turn: " +
             std::to_string(white_turn) + ", white piece: " + std::to_string(
-                board[src_pos.first][src_pos.second].isWhite) + ")"
+                moving.isWhite) + ")"
         };
         throw std::invalid_argument(error_msg);
     }
 
-    std::vector<std::pair<int, int> > valid_moves = get_valid_moves_raw(
-        src_pos, false, true);
-    // TODO continue with move logic
+    if (const std::vector<std::pair<int, int> > valid_moves{
+            get_valid_moves_raw(src_pos, false, true)
+        }; std::ranges::find(valid_moves, dst_pos) == valid_moves.end()) {
+        const std::string error_msg{"Illegal move specified"};
+        throw std::invalid_argument(error_msg);
+    }
+
+    make_move(infer_move(from, to, promotion_piece.value_or(PieceType::QUEEN)));
+}
+
+void Board::make_move(const Move &move) {
+    if (white_turn) {
+        do_move<Color::WHITE>(move);
+    } else {
+        do_move<Color::BLACK>(move);
+    }
+}
+
+template<Color Us>
+void Board::do_move(const Move &move) {
+    constexpr bool us{Us == Color::WHITE};
+    const int from{move.from()};
+    const int to{move.to()};
+    const Piece moving{piece_on(from)};
+
+    UndoInfo &undo{
+        undo_stack.emplace_back(UndoInfo{
+            move, piece_on(to), moving, castling,
+            static_cast<uint8_t>(en_passant),
+            static_cast<uint16_t>(halfmove), hash
+        })
+    };
+
+    ++halfmove;
+    if (en_passant != NO_SQUARE) {
+        hash ^= zobrist::KEYS.en_passant[file_of(en_passant)];
+        en_passant = NO_SQUARE;
+    }
+
+    switch (move.flag()) {
+        case MoveFlag::EN_PASSANT: {
+            // The captured pawn sits behind the destination square.
+            const int captured_sq{us ? to - 8 : to + 8};
+            undo.captured = piece_on(captured_sq);
+            place_piece(captured_sq, NO_PIECE);
+            break;
+        }
+        case MoveFlag::CASTLING: {
+            const bool king_side{to > from};
+            const int rook_from{king_side ? from + 3 : from - 4};
+            const int rook_to{king_side ? from + 1 : from - 1};
+            place_piece(rook_to, piece_on(rook_from));
+            place_piece(rook_from, NO_PIECE);
+            break;
+        }
+        default:
+            break;
+    }
+
+    place_piece(to, move.flag() == MoveFlag::PROMOTION
+                        ? Piece{move.promotion(), us}
+                        : moving);
+    place_piece(from, NO_PIECE);
+
+    if (moving.type == PieceType::PAWN) {
+        halfmove = 0;
+        // The en passant square is only recorded when an enemy pawn can
+        // actually capture onto it, so that it does not split otherwise
+        // identical positions.
+        if (const int skipped{(from + to) / 2};
+            (to - from == 16 || from - to == 16) &&
+            pawn_attacks(us, skipped) & pieces(Piece{PieceType::PAWN, !us})) {
+            en_passant = skipped;
+            hash ^= zobrist::KEYS.en_passant[file_of(en_passant)];
+        }
+    }
+    if (!undo.captured.is_empty()) {
+        halfmove = 0;
+    }
+    hash ^= zobrist::KEYS.castling[castling];
+    castling &= CASTLING_MASK[from] & CASTLING_MASK[to];
+    hash ^= zobrist::KEYS.castling[castling];
+    hash ^= zobrist::KEYS.black_to_move;
+    if constexpr (!us) {
+        ++fullmove;
+    }
+    white_turn = !us;
+}
+
+void Board::make_null_move() {
+    undo_stack.emplace_back(UndoInfo{
+        Move::none(), NO_PIECE, NO_PIECE, castling,
+        static_cast<uint8_t>(en_passant),
+        static_cast<uint16_t>(halfmove), hash
+    });
+
+    ++halfmove;
+    if (en_passant != NO_SQUARE) {
+        hash ^= zobrist::KEYS.en_passant[file_of(en_passant)];
+        en_passant = NO_SQUARE;
+    }
+    hash ^= zobrist::KEYS.black_to_move;
+    fullmove += white_turn ? 0 : 1;
+    white_turn = !white_turn;
+}
+
+void Board::unmake_move() {
+    const UndoInfo undo{undo_stack.back()};
+    undo_stack.pop_back();
+
+    const Move &move{undo.move};
+    if (move.is_none()) {
+        en_passant = undo.en_passant;
+        halfmove = undo.halfmove_clock;
+        hash = undo.key;
+        white_turn = !white_turn;
+        fullmove -= white_turn ? 0 : 1;
+        return;
+    }
+
+    // The side that made the move is the one not to move now.
+    if (white_turn) {
+        undo_move<Color::BLACK>(undo);
+    } else {
+        undo_move<Color::WHITE>(undo);
+    }
+}
+
+template<Color Us>
+void Board::undo_move(const UndoInfo &undo) {
+    constexpr bool us{Us == Color::WHITE};
+    const Move &move{undo.move};
+    const int from{move.from()};
+    const int to{move.to()};
+
+    place_piece(from, move.flag() == MoveFlag::PROMOTION
+                          ? Piece{PieceType::PAWN, us}
+                          : piece_on(to));
+
+    switch (move.flag()) {
+        case MoveFlag::EN_PASSANT:
+            place_piece(to, NO_PIECE);
+            place_piece(us ? to - 8 : to + 8, undo.captured);
+            break;
+        case MoveFlag::CASTLING: {
+            const bool king_side{to > from};
+            const int rook_from{king_side ? from + 3 : from - 4};
+            const int rook_to{king_side ? from + 1 : from - 1};
+            place_piece(to, NO_PIECE);
+            place_piece(rook_from, piece_on(rook_to));
+            place_piece(rook_to, NO_PIECE);
+            break;
+        }
+        default:
+            place_piece(to, undo.captured);
+            break;
+    }
+
+    castling = undo.castling_rights;
+    en_passant = undo.en_passant;
+    halfmove = undo.halfmove_clock;
+    hash = undo.key;
+    white_turn = us;
+    if constexpr (!us) {
+        --fullmove;
+    }
+}
+
+Piece Board::piece_on(const int &sq) const {
+    return Piece::from_code(mailbox[sq]);
+}
+
+bool Board::is_white_turn() const {
+    return white_turn;
+}
+
+uint8_t Board::castling_rights() const {
+    return castling;
+}
+
+int Board::en_passant_square() const {
+    return en_passant;
+}
+
+int Board::halfmove_clock() const {
+    return halfmove;
+}
+
+int Board::fullmove_number() const {
+    return fullmove;
+}
+
+uint64_t Board::key() const {
+    return hash;
+}
+
+std::span<const UndoInfo> Board::history() const {
+    return undo_stack;
+}
+
+void Board::reserve_history(const int &plies) {
+    undo_stack.reserve(undo_stack.size() + plies);
+}
+
+bool Board::is_repetition(const int &ply) const {
+    const int size{static_cast<int>(undo_stack.size())};
+    const int distance{std::min(halfmove, size)};
+    int count{0};
+    for (int back = 2; back <= distance; back += 2) {
+        // Record size - back holds the key from `back` plies ago.
+        const UndoInfo &undo{undo_stack[size - back]};
+        if (undo.move.is_none() || undo_stack[size - back + 1].move.is_none()) {
+            return false;
+        }
+        if (undo.key == hash && (back < ply || ++count == 2)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+psqt::Score Board::psq_score() const {
+    return psq;
+}
+
+int Board::phase() const {
+    return game_phase;
+}
+
+bool Board::valid_en_passant(const int &sq) const {
+    // The pawn that just advanced two squares stands in front of the
+    // square, seen from its side, and the square it passed is empty.
+    const int pawn{white_turn ? sq - 8 : sq + 8};
+    return rank_of(sq) == (white_turn ? 5 : 2) &&
+           piece_on(sq).is_empty() &&
+           piece_on(pawn) == Piece{PieceType::PAWN, !white_turn};
+}
+
+bool Board::valid_placement() const {
+    return !(pieces(PieceType::PAWN) & (RANK_1_BB | RANK_8_BB)) &&
+           !attackers_to(king_square(!white_turn), white_turn);
+}
+
+uint64_t Board::compute_key() const {
+    uint64_t result{0};
+    Bitboard occupied{occupied_bb};
+    while (occupied) {
+        const int sq{pop_lsb(occupied)};
+        result ^= zobrist::KEYS.piece[piece_index(piece_on(sq))][sq];
+    }
+    result ^= zobrist::KEYS.castling[castling];
+    if (en_passant != NO_SQUARE) {
+        result ^= zobrist::KEYS.en_passant[file_of(en_passant)];
+    }
+    if (!white_turn) {
+        result ^= zobrist::KEYS.black_to_move;
+    }
+    return result;
+}
+
+Move Board::infer_move(const int &from, const int &to,
+                       const PieceType &promotion) const {
+    const Piece piece{piece_on(from)};
+    if (piece.type == PieceType::KING && (to - from == 2 || from - to == 2)) {
+        return Move{from, to, MoveFlag::CASTLING};
+    }
+    if (piece.type == PieceType::PAWN) {
+        if (to == en_passant) {
+            return Move{from, to, MoveFlag::EN_PASSANT};
+        }
+        if (square_bb(to) & (RANK_1_BB | RANK_8_BB)) {
+            return Move{from, to, MoveFlag::PROMOTION, promotion};
+        }
+    }
+    return Move{from, to};
 }
 
 std::vector<std::pair<int, int> > Board::find_piece(const Piece &piece) const {
     std::vector<std::pair<int, int> > result{};
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        for (int j = 0; j < BOARD_SIZE; ++j) {
-            if (piece == board[i][j]) {
-                result.emplace_back(i, j);
-            }
+    Bitboard squares{pieces(piece)};
+    result.reserve(popcount(squares));
+    while (squares) {
+        // Empty squares also carry a color, so they still need comparing.
+        if (const int sq{pop_lsb(squares)}; piece.code() == mailbox[sq]) {
+            result.push_back(position_of(sq));
         }
     }
 
     return result;
 }
 
+std::size_t Board::find_piece(const Piece &piece,
+                              const std::span<Square> squares) const {
+    Bitboard found{pieces(piece)};
+    std::size_t count{0};
+    while (found) {
+        const int sq{pop_lsb(found)};
+        // Empty squares also carry a color, so they still need comparing.
+        if (piece.code() == mailbox[sq]) {
+            if (count < squares.size()) {
+                squares[count] = Square{sq};
+            }
+            ++count;
+        }
+    }
+    return count;
+}
+
+Bitboard Board::pieces(const Piece &piece) const {
+    if (piece.is_empty()) {
+        return ~occupied_bb;
+    }
+    return piece_bb[piece_index(piece)];
+}
+
+Bitboard Board::occupancy(const bool &white) const {
+    return color_bb[color_index(white)];
+}
+
+Bitboard Board::occupancy() const {
+    return occupied_bb;
+}
+
+int Board::king_square(const bool &white) const {
+    return lsb(piece_bb[piece_index(Piece{PieceType::KING, white})]);
+}
+
 std::vector<std::pair<int, int> > Board::get_valid_moves_raw(
     const std::pair<int, int> &pos, const bool &attack_moves_only,
     const bool &validate_pin) {
-    if (pos.first < 0 || pos.first >= BOARD_SIZE || pos.second < 0 || pos.
-        second >= BOARD_SIZE) {
-        const std::string error_msg{
-            "Invalid row or column specified (board size: " +
-            std::to_string(BOARD_SIZE) + "x" + std::to_string(BOARD_SIZE) + ")"
-        };
-        throw std::out_of_range(error_msg);
-    }
-
+    const int sq{checked_square(pos)};
     std::vector<std::pair<int, int> > moves{};
     auto &[row, col]{pos};
-    auto &[type, isWhite]{board[row][col]};
+    const auto [type, isWhite]{piece_on(sq)};
+
+    const Bitboard own{occupancy(isWhite)};
 
     // Helper function for checking bounds of a row and column.
     auto is_inside = [](const int &r, const int &c) {
         return (0 <= r && r < BOARD_SIZE) && (0 <= c && c < BOARD_SIZE);
     };
 
+    // Helper function for appending every square of a target set.
+    auto add_targets = [&moves](Bitboard targets) {
+        while (targets) {
+            moves.push_back(position_of(pop_lsb(targets)));
+        }
+    };
+
     switch (type) {
         // ---------------------- Empty Square ----------------------
         case PieceType::EMPTY:
@@ -225,64 +871,34 @@ std::vector<std::pair<int, int> > Board::get_valid_moves_raw(
             if (!attack_moves_only) {
                 // Move forward one.
                 if (const int forward{row + direction};
-                    is_inside(forward, col) && board[forward][col].is_empty()) {
+                    is_inside(forward, col) &&
+                    piece_on(square_of({forward, col})).is_empty()) {
                     moves.emplace_back(forward, col);
                     // If on starting rank, pawn can move two squares forward.
                     if (row == start_row) {
                         if (const int forward2{row + 2 * direction};
-                            is_inside(forward2, col) && board[forward2][col].
-                            is_empty()) {
+                            is_inside(forward2, col) &&
+                            piece_on(square_of({forward2, col})).is_empty()) {
                             moves.emplace_back(forward2, col);
                         }
                     }
                 }
             }
 
-            for (const int &dc: std::array{-1, 1}) {
-                if (int new_c{col + dc}, new_r{row + direction}; is_inside(
-                    new_r, new_c)) {
-                    if (Piece &target{board[new_r][new_c]};
-                        !target.is_empty() && target.isWhite != isWhite) {
-                        moves.emplace_back(new_r, new_c);
-                    }
-                    // Check en passant: if en_passant is set and matches the candidate square.
-                    if (!en_passant.has_value()) {
-                        if (new_r == en_passant->first && new_c == en_passant->
-                            second) {
-                            moves.emplace_back(new_r, new_c);
-                        }
-                    }
-                }
+            Bitboard targets{pawn_attacks(isWhite, sq) & occupancy(!isWhite)};
+            // Check en passant: if en_passant is set and is a capture square.
+            // Only the side to move may capture en passant.
+            if (en_passant != NO_SQUARE && isWhite == white_turn) {
+                targets |= pawn_attacks(isWhite, sq) & square_bb(en_passant);
             }
+            add_targets(targets);
             break;
         }
 
         // ----------------------- Knight Moves -----------------------
-        case PieceType::KNIGHT: {
-            constexpr std::array<std::pair<int, int>, 8> knight_offsets{
-                {
-                    {2, 1},
-                    {2, -1},
-                    {-2, 1},
-                    {-2, -1},
-                    {1, 2},
-                    {1, -2},
-                    {-1, 2},
-                    {-1, -2}
-                }
-            };
-
-            for (const auto &[dr, dc]: knight_offsets) {
-                if (int new_r{row + dr}, new_c{col + dc}; is_inside(
-                    new_r, new_c)) {
-                    if (Piece &target{board[new_r][new_c]};
-                        target.is_empty() || target.isWhite != isWhite) {
-                        moves.emplace_back(new_r, new_c);
-                    }
-                }
-            }
+        case PieceType::KNIGHT:
+            add_targets(knight_attacks(sq) & ~own);
             break;
-        }
 
         // ------------------------ Rook Moves ------------------------
         case PieceType::ROOK:
@@ -292,145 +908,22 @@ std::vector<std::pair<int, int> > Board::get_valid_moves_raw(
             [[fallthrough]];
         // ----------------------- Queen Moves ------------------------
         case PieceType::QUEEN: {
-            constexpr std::array<std::pair<int, int>, 4> rank_file_directions{
-                {
-                    {-1, 0},
-                    {1, 0},
-                    {0, -1},
-                    {0, 1}
-                }
-            };
-            constexpr std::array<std::pair<int, int>, 4> diag_directions{
-                {
-                    {-1, -1},
-                    {-1, 1},
-                    {1, -1},
-                    {1, 1}
-                }
-            };
-
-            std::vector<const std::array<std::pair<int, int>, 4> *>
-                    direction_types;
-
-            if (type == PieceType::ROOK || type ==
-                PieceType::QUEEN) {
-                direction_types.push_back(&rank_file_directions);
-            }
-            if (type == PieceType::BISHOP || type ==
-                PieceType::QUEEN) {
-                direction_types.push_back(&diag_directions);
+            Bitboard targets{EMPTY_BB};
+            if (type == PieceType::ROOK || type == PieceType::QUEEN) {
+                targets |= rook_attacks(sq, occupied_bb);
             }
-
-            for (const auto *directions: direction_types) {
-                for (const auto &[dr, dc]: *directions) {
-                    int r{row}, c{col};
-
-                    while (true) {
-                        r += dr;
-                        c += dc;
-                        if (!is_inside(r, c)) {
-                            break;
-                        }
-                        if (Piece &target{board[r][c]}; target.is_empty()) {
-                            moves.emplace_back(r, c);
-                        } else if (target.isWhite != isWhite) {
-                            moves.emplace_back(r, c);
-                            break;
-                        } else {
-                            break;
-                        }
-                    }
-                }
+            if (type == PieceType::BISHOP || type == PieceType::QUEEN) {
+                targets |= bishop_attacks(sq, occupied_bb);
             }
+            add_targets(targets & ~own);
             break;
         }
         // ------------- King Moves (including castling) --------------
         case PieceType::KING: {
-            std::array<std::pair<int, int>, 8> king_offsets{
-                {
-                    {-1, -1},
-                    {-1, 0},
-                    {-1, 1},
-                    {0, -1},
-                    {0, 1},
-                    {1, -1},
-                    {1, 0},
-                    {1, 1}
-                }
-            };
-
-            for (const auto &[dr, dc]: king_offsets) {
-                if (int new_r{row + dr}, new_c{col + dc}; is_inside(
-                    new_r, new_c)) {
-                    if (Piece &target{board[new_r][new_c]};
-                        !target.is_empty() || target.isWhite != isWhite) {
-                        moves.emplace_back(new_r, new_c);
-                    }
-                }
-            }
+            add_targets(king_attacks(sq) & ~own);
 
             if (!attack_moves_only) {
-                // For castling, we check that the king is at its starting square.
-                if (isWhite && row == 7 && col == 4) {
-                    // White king-side castling: squares f1 and g1 must be empty
-                    // and the rook must be at h1.
-                    if (white_king_side_castle && board[7][5].is_empty() &&
-                        board[7][6].is_empty() &&
-                        board[7][7] == Piece{PieceType::ROOK, true} &&
-                        is_under_attack(
-                            std::vector{
-                                {
-                                    std::pair{7, 5},
-                                    std::pair{7, 6}
-                                }
-                            },
-                            false, true)) {
-                        moves.emplace_back(7, 6);
-                    }
-                    // White queen-side castling: squares d1, c1, and b1 must be empty
-                    // and the rook must be at a1.
-                    if (white_queen_side_castle && board[7][3].is_empty() &&
-                        board[7][2].is_empty() && board[7][1].is_empty() &&
-                        board[7][0] == Piece{PieceType::ROOK, true} &&
-                        is_under_attack(std::vector{
-                                            {
-                                                std::pair{7, 3},
-                                                std::pair{7, 2},
-                                                std::pair{7, 1}
-                                            }
-                                        }, false, true)) {
-                        moves.emplace_back(7, 2);
-                    }
-                    // Black king-side castling: squares f8 and g8 must be empty and
-                    // the rook must be at h8.
-                    if (black_king_side_castle && board[0][5].is_empty() &&
-                        board[0][6].is_empty() &&
-                        board[0][7] == Piece{PieceType::ROOK, false} &&
-                        is_under_attack(
-                            std::vector{
-                                {
-                                    std::pair{0, 5},
-                                    std::pair{0, 6}
-                                }
-                            },
-                            true, true)) {
-                        moves.emplace_back(0, 6);
-                    }
-                    // Black queen-side castling: squares d8, c8, and b8 must be empty and
-                    // the rook must be at a8.
-                    if (white_queen_side_castle && board[0][3].is_empty() &&
-                        board[0][2].is_empty() && board[0][1].is_empty() &&
-                        board[0][0] == Piece{PieceType::ROOK, false} &&
-                        is_under_attack(std::vector{
-                                            {
-                                                std::pair{0, 3},
-                                                std::pair{0, 2},
-                                                std::pair{0, 1}
-                                            }
-                                        }, true, true)) {
-                        moves.emplace_back(0, 2);
-                    }
-                }
+                add_targets(castling_destinations(isWhite));
             }
             break;
         }
@@ -439,24 +932,51 @@ std::vector<std::pair<int, int> > Board::get_valid_moves_raw(
     }
 
     // ----------------------- Pinned Piece Verification -----------------------
-    if (validate_pin) {
-        int i{0};
-        while (true) {
-            std::pair<int, int> &move = moves[i];
-
-            const Piece dest_piece{board[move.first][move.second]};
-            make_move_raw(pos, move);
-            if (in_check(board[move.first][move.second].isWhite)) {
-                moves.erase(moves.begin() + i);
-            } else {
-                ++i;
+    if (validate_pin && !attack_moves_only && isWhite == white_turn) {
+        // Pieces of the side to move take their moves from the legal
+        // generator, which masks out pinned and check-ignoring moves.
+        MoveList legal_moves;
+        generate_moves(legal_moves);
+        moves.clear();
+        for (const Move &move: legal_moves) {
+            if (move.from() == sq) {
+                // Promotions appear once per piece but share a destination.
+                if (move.flag() == MoveFlag::PROMOTION &&
+                    move.promotion() != PieceType::QUEEN) {
+                    continue;
+                }
+                moves.push_back(position_of(move.to()));
             }
-            make_move_raw(move, pos);
-            board[move.first][move.second] = dest_piece;
-            if (i >= moves.size()) {
-                break;
+        }
+    } else if (validate_pin) {
+        // The opponent's pieces cannot be played, as make_move() moves for
+        // the side to move; their legality comes from the check and pin
+        // masks instead, the way the generator works it out.
+        const bool white{isWhite};
+        const int king{king_square(white)};
+        const Bitboard enemy{occupancy(!white)};
+        Bitboard legal{EMPTY_BB};
+        if (type == PieceType::KING) {
+            // Castling destinations were already checked for attacks.
+            const Bitboard occupied_without_king{occupied_bb ^ square_bb(king)};
+            Bitboard targets{king_attacks(sq) & ~own};
+            while (targets) {
+                if (const int to{pop_lsb(targets)};
+                    !(attackers_to(to, occupied_without_king) & enemy)) {
+                    legal |= square_bb(to);
+                }
+            }
+            legal |= castling_destinations(white);
+        } else if (const Bitboard checking{attackers_to(king, !white)};
+            !(checking & (checking - 1))) {
+            legal = checking ? between_bb(king, lsb(checking)) | checking : ~EMPTY_BB;
+            if (pinned_pieces(white) & square_bb(sq)) {
+                legal &= line_bb(king, sq);
             }
         }
+        std::erase_if(moves, [&legal](const std::pair<int, int> &move) {
+            return !(legal & square_bb(square_of(move)));
+        });
     }
 
     return moves;
@@ -467,70 +987,516 @@ std::unordered_map<std::pair<int, int>, std::pair<Piece, std::vector<std::pair<
     const bool &attack_moves_only, const bool &validate_pins) {
     std::unordered_map<std::pair<int, int>, std::pair<Piece, std::vector<
         std::pair<int, int> > > > moves{};
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        for (int j = 0; j < BOARD_SIZE; ++j) {
-            std::pair pos{i, j};
-            moves[pos] = std::make_pair(get_piece(pos),
-                                        get_valid_moves_raw(
-                                            pos, attack_moves_only,
-                                            validate_pins));
-        }
+    // Empty squares have no moves, so only occupied squares are visited.
+    Bitboard occupied{occupied_bb};
+    while (occupied) {
+        std::pair pos{position_of(pop_lsb(occupied))};
+        moves[pos] = std::make_pair(get_piece(pos),
+                                    get_valid_moves_raw(
+                                        pos, attack_moves_only,
+                                        validate_pins));
     }
     return moves;
 }
 
-bool Board::is_under_attack(const std::pair<int, int> &pos,
-                            const bool &white_is_attacking) {
-    for (std::unordered_map attacking_moves{
-             get_all_valid_moves_raw(true, false)
-         }; const auto &[fst, snd]: attacking_moves | std::views::values) {
-        if (fst.isWhite == white_is_attacking) {
-            if (std::ranges::find_if(snd, [&pos](const std::pair<int, int> &p) {
-                return p.first == pos.first && p.second == pos.second;
-            }) != snd.end()) {
-                return true;
-            }
+Bitboard Board::pieces(const PieceType &type) const {
+    return piece_bb[piece_index(Piece{type, true})] |
+           piece_bb[piece_index(Piece{type, false})];
+}
+
+Bitboard Board::attackers_to(const int &sq, const Bitboard &occupied) const {
+    // Every attack pattern is symmetric, so a piece attacks `sq` exactly when
+    // the same piece standing on `sq` would attack it. Pawns are the
+    // exception and use the opposite color's pattern.
+    return (pawn_attacks(false, sq) & pieces(Piece{PieceType::PAWN, true})) |
+           (pawn_attacks(true, sq) & pieces(Piece{PieceType::PAWN, false})) |
+           (knight_attacks(sq) & pieces(PieceType::KNIGHT)) |
+           (king_attacks(sq) & pieces(PieceType::KING)) |
+           (rook_attacks(sq, occupied) &
+            (pieces(PieceType::ROOK) | pieces(PieceType::QUEEN))) |
+           (bishop_attacks(sq, occupied) &
+            (pieces(PieceType::BISHOP) | pieces(PieceType::QUEEN)));
+}
+
+Bitboard Board::attackers_to(const int &sq,
+                             const bool &white_is_attacking) const {
+    return attackers_to(sq, occupied_bb) & occupancy(white_is_attacking);
+}
+
+Bitboard Board::attacked_squares(Bitboard squares,
+                                 const bool &white_is_attacking) const {
+    STATS_COUNT(ATTACK_QUERIES);
+    STATS_TIME(ATTACKS);
+    Bitboard attacked{EMPTY_BB};
+    while (squares) {
+        if (const int sq{pop_lsb(squares)};
+            attackers_to(sq, white_is_attacking)) {
+            attacked |= square_bb(sq);
         }
     }
+    return attacked;
+}
 
-    return false;
+template<GenType Type>
+void Board::generate_moves(MoveList &moves) const {
+    STATS_COUNT(MOVEGEN_CALLS);
+    STATS_TIME(MOVEGEN);
+    moves.clear();
+    if (white_turn) {
+        generate<Color::WHITE, Type>(moves);
+    } else {
+        generate<Color::BLACK, Type>(moves);
+    }
+    STATS_ADD(MOVES_GENERATED, moves.size());
 }
 
-bool Board::is_under_attack(const std::vector<std::pair<int, int> > &positions,
-                            const bool &white_is_attacking, const bool &nor) {
-    bool result = true;
-    for (std::unordered_map attacking_moves{
-             get_all_valid_moves_raw(true, false)
-         }; const auto &[fst, snd]: attacking_moves | std::views::values) {
-        if (fst.isWhite == white_is_attacking) {
-            if (!nor) {
-                for (const auto &pos: positions) {
-                    if (std::ranges::find_if(
-                            snd, [&pos](const std::pair<int, int> &p) {
-                                return p.first == pos.first && p.second == pos.
-                                       second;
-                            }) == snd.end()) {
-                        result = false;
+template void Board::generate_moves<GenType::CAPTURES>(MoveList &) const;
+template void Board::generate_moves<GenType::QUIETS>(MoveList &) const;
+template void Board::generate_moves<GenType::EVASIONS>(MoveList &) const;
+template void Board::generate_moves<GenType::ALL>(MoveList &) const;
+
+template<Color Us, GenType Type>
+void Board::generate(MoveList &moves) const {
+    constexpr bool us{Us == Color::WHITE};
+    constexpr int up{us ? 8 : -8};
+    constexpr bool captures{Type != GenType::QUIETS};
+    constexpr bool quiets{Type != GenType::CAPTURES};
+    const int king{king_square(us)};
+    const Bitboard own{occupancy(us)};
+    const Bitboard enemy{occupancy(!us)};
+    const Bitboard empty{~occupied_bb};
+    const Bitboard checking{checkers()};
+
+    // Squares a piece other than a pawn may move to for this kind of move.
+    const Bitboard kind_mask{
+        Type == GenType::CAPTURES ? enemy : Type == GenType::QUIETS ? empty : ~own
+    };
+
+    // --------------------------- King Moves ---------------------------
+    // The king may not step onto an attacked square. It is taken off the
+    // board first so that it cannot hide behind itself from a slider.
+    const Bitboard occupied_without_king{occupied_bb ^ square_bb(king)};
+    Bitboard king_targets{king_attacks(king) & kind_mask};
+    while (king_targets) {
+        if (const int to{pop_lsb(king_targets)};
+            !(attackers_to(to, occupied_without_king) & enemy)) {
+            moves.push_back(Move{king, to});
+        }
+    }
+
+    // In double check only the king can move.
+    if (checking & (checking - 1)) {
+        return;
+    }
+
+    // Out of check, every other move must capture the checker or block it.
+    const Bitboard target_mask{
+        checking ? between_bb(king, lsb(checking)) | checking : ~EMPTY_BB
+    };
+    const Bitboard pinned{pinned_pieces(us)};
+
+    // A pinned piece may only move along the line through its king.
+    auto allowed = [&pinned, &king](const int &from) {
+        return pinned & square_bb(from) ? line_bb(king, from) : ~EMPTY_BB;
+    };
+
+    // Helper function for appending a move to every square of a target set.
+    auto add_moves = [&moves](const int &from, Bitboard targets) {
+        while (targets) {
+            moves.push_back(Move{from, pop_lsb(targets)});
+        }
+    };
+
+    // Helper function for appending pawn moves ending on the given squares,
+    // expanding moves onto the last rank into promotions. Queen promotions
+    // count as captures; underpromotions belong to the same kind as the move
+    // itself.
+    auto add_pawn_moves = [&moves, &allowed](Bitboard targets,
+                                             const int &offset,
+                                             const bool &capture) {
+        while (targets) {
+            const int to{pop_lsb(targets)};
+            const int from{to - offset};
+            if (!(allowed(from) & square_bb(to))) {
+                continue;
+            }
+            if (square_bb(to) & (RANK_1_BB | RANK_8_BB)) {
+                if constexpr (captures) {
+                    moves.push_back(Move{from, to, MoveFlag::PROMOTION,
+                                         PieceType::QUEEN});
+                }
+                if (Type == GenType::ALL || Type == GenType::EVASIONS ||
+                    (Type == GenType::CAPTURES) == capture) {
+                    for (const PieceType type: {
+                             PieceType::KNIGHT, PieceType::ROOK,
+                             PieceType::BISHOP
+                         }) {
+                        moves.push_back(
+                            Move{from, to, MoveFlag::PROMOTION, type});
                     }
                 }
             } else {
-                for (const auto &pos: positions) {
-                    if (std::ranges::find_if(
-                            snd, [&pos](const std::pair<int, int> &p) {
-                                return p.first == pos.first && p.second == pos.
-                                       second;
-                            }) != snd.end()) {
-                        result = false;
-                    }
+                moves.push_back(Move{from, to});
+            }
+        }
+    };
+
+    // --------------------------- Pawn Moves ---------------------------
+    constexpr Bitboard promotion_rank{us ? RANK_8_BB : RANK_1_BB};
+    const Bitboard pawns{pieces(Piece{PieceType::PAWN, us})};
+    const Bitboard single{push_bb(pawns, us) & empty};
+    if constexpr (quiets) {
+        const Bitboard double_push{
+            push_bb(single & (us ? RANK_3_BB : RANK_6_BB), us) & empty
+        };
+        add_pawn_moves(single & target_mask, up, false);
+        add_pawn_moves(double_push & target_mask, 2 * up, false);
+    } else {
+        // Only pushes onto the last rank, for the queen promotion.
+        add_pawn_moves(single & promotion_rank & target_mask, up, false);
+    }
+
+    if constexpr (captures) {
+        // Captures are generated per direction by shifting the pawn set,
+        // keeping pawns on the edge file from wrapping around the board.
+        const Bitboard west{push_bb(pawns & ~FILE_A_BB, us) >> 1};
+        const Bitboard east{push_bb(pawns & ~FILE_H_BB, us) << 1};
+        add_pawn_moves(west & enemy & target_mask, up - 1, true);
+        add_pawn_moves(east & enemy & target_mask, up + 1, true);
+    }
+
+    if (captures && en_passant != NO_SQUARE) {
+        // En passant removes two pieces from the capturing pawn's rank, which
+        // the pin mask cannot see, so the resulting occupancy is tested for
+        // slider attacks on the king directly.
+        const int captured{en_passant - up};
+        const Bitboard rooks{
+            (pieces(Piece{PieceType::ROOK, !us}) |
+             pieces(Piece{PieceType::QUEEN, !us}))
+        };
+        const Bitboard bishops{
+            (pieces(Piece{PieceType::BISHOP, !us}) |
+             pieces(Piece{PieceType::QUEEN, !us}))
+        };
+        Bitboard capturers{pawn_attacks(!us, en_passant) & pawns};
+        if (checking && !(checking & square_bb(captured)) &&
+            !(target_mask & square_bb(en_passant))) {
+            capturers = EMPTY_BB;
+        }
+        while (capturers) {
+            const int from{pop_lsb(capturers)};
+            const Bitboard occupied{
+                (occupied_bb ^ square_bb(from) ^ square_bb(captured)) |
+                square_bb(en_passant)
+            };
+            if (!(rook_attacks(king, occupied) & rooks) &&
+                !(bishop_attacks(king, occupied) & bishops)) {
+                moves.push_back(Move{from, en_passant, MoveFlag::EN_PASSANT});
+            }
+        }
+    }
+
+    // ---------------------- Knight to Queen Moves ----------------------
+    for (const PieceType type: {
+             PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK,
+             PieceType::QUEEN
+         }) {
+        Bitboard from_squares{pieces(Piece{type, us})};
+        while (from_squares) {
+            const int from{pop_lsb(from_squares)};
+            add_moves(from, piece_attacks(type, from, occupied_bb) &
+                            kind_mask & target_mask & allowed(from));
+        }
+    }
+
+    // ---------------------------- Castling ----------------------------
+    if (quiets && Type != GenType::EVASIONS && !checking) {
+        Bitboard targets{castling_destinations<Us>()};
+        while (targets) {
+            moves.push_back(Move{king, pop_lsb(targets), MoveFlag::CASTLING});
+        }
+    }
+}
+
+bool Board::is_legal(const Move &move) const {
+    STATS_COUNT(LEGALITY_CHECKS);
+    STATS_TIME(LEGALITY);
+    const bool us{white_turn};
+    const int from{move.from()};
+    const int to{move.to()};
+    const Piece moving{piece_on(from)};
+    if (move.is_none() || moving.is_empty() || moving.isWhite != us ||
+        occupancy(us) & square_bb(to)) {
+        return false;
+    }
+
+    const Bitboard checking{checkers()};
+    switch (move.flag()) {
+        case MoveFlag::CASTLING:
+            return moving.type == PieceType::KING && !checking &&
+                   castling_destinations(us) & square_bb(to);
+        case MoveFlag::EN_PASSANT: {
+            // Rare enough that the generator can settle it.
+            if (moving.type != PieceType::PAWN || to != en_passant) {
+                return false;
+            }
+            MoveList captures;
+            generate_moves<GenType::CAPTURES>(captures);
+            for (const Move &capture: captures) {
+                if (capture == move) {
+                    return true;
                 }
             }
+            return false;
         }
+        default:
+            break;
+    }
+
+    if (moving.type == PieceType::PAWN) {
+        const int up{us ? 8 : -8};
+        const bool last_rank{(square_bb(to) & (RANK_1_BB | RANK_8_BB)) != 0};
+        const bool capture{
+            (pawn_attacks(us, from) & occupancy(!us) & square_bb(to)) != 0
+        };
+        const bool push{to == from + up && piece_on(to).is_empty()};
+        const bool double_push{
+            to == from + 2 * up && rank_of(from) == (us ? 1 : 6) &&
+            piece_on(from + up).is_empty() && piece_on(to).is_empty()
+        };
+        if (last_rank != (move.flag() == MoveFlag::PROMOTION) ||
+            !(capture || push || double_push)) {
+            return false;
+        }
+    } else if (move.flag() != MoveFlag::NORMAL ||
+               !(piece_attacks(moving.type, from, occupied_bb) &
+                 square_bb(to))) {
+        return false;
+    }
+
+    // The move is possible; it is legal if it does not leave the king in
+    // check, tested the same way as in the generator.
+    const int king{king_square(us)};
+    if (moving.type == PieceType::KING) {
+        return !(attackers_to(to, occupied_bb ^ square_bb(from)) &
+                 occupancy(!us));
+    }
+    if (checking && ((checking & (checking - 1)) ||
+                     !((between_bb(king, lsb(checking)) | checking) &
+                       square_bb(to)))) {
+        return false;
+    }
+    return !(pinned_pieces(us) & square_bb(from)) ||
+           line_bb(king, from) & square_bb(to);
+}
+
+bool Board::see_ge(const Move &move, const int &threshold) const {
+    // Promotions, en passant and castling count as even exchanges.
+    if (move.flag() != MoveFlag::NORMAL) {
+        return threshold <= 0;
     }
 
+    const int from{move.from()};
+    const int to{move.to()};
+    // `swap` is what the side to move is ahead by, less the threshold, if
+    // the last capture is answered. The side that would have to go below it
+    // stops capturing.
+    int swap{PIECE_VALUE[static_cast<int>(piece_on(to).type)] - threshold};
+    if (swap < 0) {
+        return false;
+    }
+    swap = PIECE_VALUE[static_cast<int>(piece_on(from).type)] - swap;
+    if (swap <= 0) {
+        return true;
+    }
+
+    const Bitboard bishops{
+        pieces(PieceType::BISHOP) | pieces(PieceType::QUEEN)
+    };
+    const Bitboard rooks{pieces(PieceType::ROOK) | pieces(PieceType::QUEEN)};
+    Bitboard occupied{occupied_bb ^ square_bb(from) ^ square_bb(to)};
+    Bitboard attackers{attackers_to(to, occupied)};
+    bool side{white_turn};
+    bool result{true};
+
+    while (true) {
+        side = !side;
+        attackers &= occupied;
+        const Bitboard side_attackers{attackers & occupancy(side)};
+        if (!side_attackers) {
+            break;
+        }
+        result = !result;
+
+        // The least valuable attacker captures next. Removing it may uncover
+        // a slider behind it.
+        PieceType type{PieceType::PAWN};
+        Bitboard bb{EMPTY_BB};
+        for (const PieceType candidate: {
+                 PieceType::PAWN, PieceType::KNIGHT, PieceType::BISHOP,
+                 PieceType::ROOK, PieceType::QUEEN, PieceType::KING
+             }) {
+            if ((bb = side_attackers & pieces(candidate))) {
+                type = candidate;
+                break;
+            }
+        }
+        if (type == PieceType::KING) {
+            // The king may only capture last, when nothing defends.
+            return attackers & occupancy(!side) ? !result : result;
+        }
+        swap = PIECE_VALUE[static_cast<int>(type)] - swap;
+        if (swap < static_cast<int>(result)) {
+            break;
+        }
+        occupied ^= square_bb(lsb(bb));
+        if (type == PieceType::PAWN || type == PieceType::BISHOP ||
+            type == PieceType::QUEEN) {
+            attackers |= bishop_attacks(to, occupied) & bishops;
+        }
+        if (type == PieceType::ROOK || type == PieceType::QUEEN) {
+            attackers |= rook_attacks(to, occupied) & rooks;
+        }
+    }
     return result;
 }
 
-bool Board::in_check(const bool &white) {
-    return is_under_attack(find_piece(Piece{PieceType::PAWN, white})[0],
-                           !white);
+Bitboard Board::checkers() const {
+    STATS_COUNT(ATTACK_QUERIES);
+    STATS_TIME(ATTACKS);
+    return attackers_to(king_square(white_turn), !white_turn);
+}
+
+Bitboard Board::pinned_pieces(const bool &white) const {
+    const int king{king_square(white)};
+    // Enemy sliders that would attack the king on an empty board, of which
+    // those with exactly one piece in between pin it if it is ours.
+    Bitboard snipers{
+        ((rook_attacks(king, EMPTY_BB) &
+          (pieces(Piece{PieceType::ROOK, !white}) |
+           pieces(Piece{PieceType::QUEEN, !white}))) |
+         (bishop_attacks(king, EMPTY_BB) &
+          (pieces(Piece{PieceType::BISHOP, !white}) |
+           pieces(Piece{PieceType::QUEEN, !white}))))
+    };
+    Bitboard pinned{EMPTY_BB};
+    while (snipers) {
+        const Bitboard blockers{
+            between_bb(king, pop_lsb(snipers)) & occupied_bb
+        };
+        if (blockers && !(blockers & (blockers - 1))) {
+            pinned |= blockers & occupancy(white);
+        }
+    }
+    return pinned;
+}
+
+Bitboard Board::castling_destinations(const bool &white) const {
+    return white ? castling_destinations<Color::WHITE>()
+                 : castling_destinations<Color::BLACK>();
+}
+
+template<Color Us>
+Bitboard Board::castling_destinations() const {
+    constexpr bool white{Us == Color::WHITE};
+    constexpr int home_row{white ? 7 : 0};
+    constexpr int base{square_of({home_row, 0})};
+    constexpr uint8_t king_side{white ? WHITE_KING_SIDE : BLACK_KING_SIDE};
+    constexpr uint8_t queen_side{white ? WHITE_QUEEN_SIDE : BLACK_QUEEN_SIDE};
+    // For castling, the king must be on its starting square and not in check,
+    // the squares between king and rook must be empty, and the squares the
+    // king crosses must not be attacked. The attack test is by far the most
+    // expensive, so it runs last and only for the squares that matter.
+    if (!(castling & (king_side | queen_side)) ||
+        piece_on(base + 4) != Piece{PieceType::KING, white}) {
+        return EMPTY_BB;
+    }
+
+    const Piece rook{PieceType::ROOK, white};
+    Bitboard destinations{EMPTY_BB};
+
+    // King-side castling: squares on the f and g files must be empty and the
+    // rook must be on the h file.
+    if (castling & king_side && !(occupied_bb & Bitboard{0x60} << base) &&
+        piece_on(base + 7) == rook &&
+        !attacked_squares(Bitboard{0x70} << base, !white)) {
+        destinations |= square_bb(base + 6);
+    }
+    // Queen-side castling: squares on the b, c and d files must be empty and
+    // the rook must be on the a file.
+    if (castling & queen_side && !(occupied_bb & Bitboard{0x0E} << base) &&
+        piece_on(base) == rook &&
+        !attacked_squares(Bitboard{0x1C} << base, !white)) {
+        destinations |= square_bb(base + 2);
+    }
+    return destinations;
+}
+
+bool Board::is_under_attack(const std::pair<int, int> &pos,
+                            const bool &white_is_attacking) const {
+    return is_under_attack(checked_square(pos), white_is_attacking);
+}
+
+bool Board::is_under_attack(const Square &sq,
+                            const bool &white_is_attacking) const {
+    STATS_COUNT(ATTACK_QUERIES);
+    STATS_TIME(ATTACKS);
+    return attackers_to(sq, white_is_attacking) != EMPTY_BB;
+}
+
+bool Board::is_under_attack(const std::vector<std::pair<int, int> > &positions,
+                            const bool &white_is_attacking,
+                            const bool &nor) const {
+    Bitboard squares{EMPTY_BB};
+    for (const auto &pos: positions) {
+        squares |= square_bb(checked_square(pos));
+    }
+    const bool any_attacked{
+        attacked_squares(squares, white_is_attacking) != EMPTY_BB
+    };
+    return nor ? !any_attacked : any_attacked;
+}
+
+bool Board::in_check(const bool &white) const {
+    STATS_COUNT(ATTACK_QUERIES);
+    STATS_TIME(ATTACKS);
+    return attackers_to(king_square(white), !white) != EMPTY_BB;
+}
+
+void Board::clear() {
+    mailbox.fill(NO_PIECE.code());
+    piece_bb.fill(EMPTY_BB);
+    color_bb.fill(EMPTY_BB);
+    occupied_bb = EMPTY_BB;
+    en_passant = NO_SQUARE;
+    castling = 0;
+    halfmove = 0;
+    fullmove = 1;
+    white_turn = true;
+    hash = 0;
+    psq = {};
+    game_phase = 0;
+    undo_stack.clear();
+}
+
+void Board::place_piece(const int &sq, const Piece &piece) {
+    const Bitboard bb{square_bb(sq)};
+
+    if (const Piece old{piece_on(sq)}; !old.is_empty()) {
+        piece_bb[piece_index(old)] &= ~bb;
+        color_bb[color_index(old.isWhite)] &= ~bb;
+        occupied_bb &= ~bb;
+        hash ^= zobrist::KEYS.piece[piece_index(old)][sq];
+        psq -= psqt::SCORES[piece_index(old)][sq];
+        game_phase -= psqt::PHASE_WEIGHT[static_cast<int>(old.type)];
+    }
+    if (!piece.is_empty()) {
+        piece_bb[piece_index(piece)] |= bb;
+        color_bb[color_index(piece.isWhite)] |= bb;
+        occupied_bb |= bb;
+        hash ^= zobrist::KEYS.piece[piece_index(piece)][sq];
+        psq += psqt::SCORES[piece_index(piece)][sq];
+        game_phase += psqt::PHASE_WEIGHT[static_cast<int>(piece.type)];
+    }
+    mailbox[sq] = piece.code();
 }
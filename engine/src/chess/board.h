@@ -2,34 +2,196 @@
 #define BOARD_H
 
 #include <array>
+#include <cstddef>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "engine/public_headers.h"
+#include "eval/psqt.h"
+#include "bitboard.h"
+#include "move.h"
+#include "packed_position.h"
 #include "piece.h"
+#include "square.h"
 
 constexpr int BOARD_SIZE{8};
+// Enough for any FEN write_fen() produces.
+constexpr std::size_t MAX_FEN_LENGTH{96};
+// Enough for any mode of Board::render().
+constexpr std::size_t MAX_RENDER_LENGTH{480};
+
+// Output formats of Board::render().
+enum class RenderMode : uint8_t {
+    // The diagram of to_string(), with box-drawing frame and chess glyphs.
+    UNICODE,
+    // The same diagram in plain ASCII, FEN letters for the pieces.
+    ASCII,
+    // The FEN string alone.
+    FEN
+};
+
+// Castling rights, combined as a bit mask.
+constexpr uint8_t WHITE_KING_SIDE{1};
+constexpr uint8_t WHITE_QUEEN_SIDE{2};
+constexpr uint8_t BLACK_KING_SIDE{4};
+constexpr uint8_t BLACK_QUEEN_SIDE{8};
+constexpr uint8_t ALL_CASTLING{15};
+
+// State that a move destroys, saved so that the move can be taken back.
+struct UndoInfo {
+    Move move;
+    Piece captured;
+    // The piece that made the move; empty for a null move.
+    Piece moved;
+    uint8_t castling_rights;
+    uint8_t en_passant;
+    uint16_t halfmove_clock;
+    uint64_t key;
+};
 
 class Board {
 public:
     Board();
 
+    // Sets up the position described by a FEN string. Throws
+    // std::invalid_argument if the string cannot be parsed.
+    explicit Board(const std::string &fen);
+
+    // Replaces the position with the one described by a FEN string, without
+    // allocating, and returns whether the string could be parsed. The
+    // halfmove clock and fullmove number may be omitted. Castling fields
+    // other than '-' or letters of "KQkq" are rejected, as are an en passant
+    // square that no pawn can just have passed, pawns on the 1st or 8th
+    // rank and a side not to move that is in check. After a failure the
+    // position is unspecified until the next successful set.
+    bool set_fen(std::string_view fen);
+
+    // Writes the position as FEN into `buffer` and returns the number of
+    // characters written, or 0 if the buffer is shorter than MAX_FEN_LENGTH.
+    // No terminating null is added.
+    std::size_t write_fen(std::span<char> buffer) const;
+
+    [[nodiscard]] std::string fen() const;
+
+    // Encodes the position into its 32-byte form. Positions with more than
+    // 32 pieces cannot be represented and keep only the first 32.
+    [[nodiscard]] PackedPosition pack() const;
+
+    // Replaces the position with a packed one and returns whether it was
+    // well-formed, checking the pawns, the check of the side not to move and
+    // the en passant square as set_fen() does. Like set_fen(), does not
+    // allocate.
+    bool unpack(const PackedPosition &packed);
+
+    // The (row, col) overloads check the position and throw
+    // std::out_of_range if it is off the board. The Square overloads are
+    // their unchecked counterparts for hot paths.
     [[nodiscard]] Piece get_piece(const std::pair<int, int> &pos) const;
 
+    [[nodiscard]] Piece get_piece(const Square &sq) const;
+
     void set_piece(const std::pair<int, int> &pos, const Piece &piece);
 
+    void set_piece(const Square &sq, const Piece &piece);
+
     [[nodiscard]] std::string to_string() const;
 
+    // Writes the position in the given format into `buffer` and returns the
+    // number of bytes written, or 0 if the buffer is shorter than
+    // MAX_RENDER_LENGTH. Does not allocate; no terminating null is added.
+    std::size_t render(std::span<char> buffer,
+                       RenderMode mode = RenderMode::UNICODE) const;
+
     void make_move_raw(const std::pair<int, int> &src_pos,
                        const std::pair<int, int> &dst_pos);
 
+    void make_move_raw(const Square &from, const Square &to);
+
     void make_move(const std::pair<int, int> &src_pos,
                    const std::pair<int, int> &dst_pos,
-                   std::optional<PieceType> promotion_piece);
+                   std::optional<PieceType> promotion_piece = std::nullopt);
+
+    // Plays a move without validating it and pushes an undo record. The move
+    // must be pseudo-legal in the current position.
+    void make_move(const Move &move);
+
+    // Passes the turn to the opponent, as used by null-move pruning. Must
+    // not be called while in check.
+    void make_null_move();
+
+    // Takes back the last move played with make_move(const Move &) or
+    // make_null_move().
+    void unmake_move();
+
+    // Unchecked lookup of the piece on a square index.
+    [[nodiscard]] Piece piece_on(const int &sq) const;
+
+    [[nodiscard]] bool is_white_turn() const;
+
+    // Bit mask of the remaining castling rights.
+    [[nodiscard]] uint8_t castling_rights() const;
+
+    // Square a pawn may capture onto en passant, or NO_SQUARE.
+    [[nodiscard]] int en_passant_square() const;
+
+    // Number of halfmoves since the last capture or pawn move.
+    [[nodiscard]] int halfmove_clock() const;
+
+    // Starts at 1 and increases after every black move.
+    [[nodiscard]] int fullmove_number() const;
+
+    // Zobrist key of the position, maintained incrementally.
+    [[nodiscard]] uint64_t key() const;
+
+    // Undo records of the moves played with make_move(const Move &) and
+    // make_null_move(), oldest first. Record i holds the key of the
+    // position before move i.
+    [[nodiscard]] std::span<const UndoInfo> history() const;
+
+    // Makes room for `plies` more undo records, so that playing that many
+    // moves does not allocate. Searches call this on their copy of the
+    // board, which only has room for the moves already played.
+    void reserve_history(const int &plies);
+
+    // Whether the position repeats one in history(). A repetition of a
+    // position reached in the last `ply` moves, those of a search, counts at
+    // once; the search root and earlier positions must have occurred twice,
+    // making the position's third occurrence. Only
+    // positions since the last capture, pawn move or null move, with the
+    // same side to move, are compared.
+    [[nodiscard]] bool is_repetition(const int &ply = 0) const;
+
+    // Material and piece-square score from white's point of view, in both
+    // phases, maintained incrementally.
+    [[nodiscard]] psqt::Score psq_score() const;
+
+    // Sum of psqt::PHASE_WEIGHT over the pieces on the board.
+    [[nodiscard]] int phase() const;
 
     [[nodiscard]] std::vector<std::pair<int, int> > find_piece(
         const Piece &piece) const;
 
+    // Writes the squares holding the given piece into `squares`, up to its
+    // size, and returns how many there are. Does not allocate.
+    std::size_t find_piece(const Piece &piece,
+                           std::span<Square> squares) const;
+
+    // Set of squares holding the given (non-empty) piece.
+    [[nodiscard]] Bitboard pieces(const Piece &piece) const;
+
+    // Set of squares holding a piece of the given color.
+    [[nodiscard]] Bitboard occupancy(const bool &white) const;
+
+    // Set of squares holding any piece.
+    [[nodiscard]] Bitboard occupancy() const;
+
+    // Square index of the given side's king.
+    [[nodiscard]] int king_square(const bool &white) const;
+
     std::vector<std::pair<int, int> > get_valid_moves_raw(
         const std::pair<int, int> &pos, const bool &attack_moves_only,
         const bool &validate_pin);
@@ -38,22 +200,115 @@ public:
         std::pair<int, int> > > > get_all_valid_moves_raw(
         const bool &attack_moves_only, const bool &validate_pins);
 
-    bool is_under_attack(const std::pair<int, int> &pos,
-                         const bool &white_is_attacking);
+    // Fills `moves` with the legal moves of the given type for the side to
+    // move, without allocating.
+    template<GenType Type = GenType::ALL>
+    void generate_moves(MoveList &moves) const;
+
+    // Whether a move, e.g. one taken from the transposition table, is legal
+    // in this position. Much cheaper than generating every move.
+    [[nodiscard]] bool is_legal(const Move &move) const;
+
+    // Static exchange evaluation: whether the sequence of captures on the
+    // destination square that the move starts wins at least `threshold`
+    // centipawns for the side to move. Pins are not taken into account.
+    [[nodiscard]] bool see_ge(const Move &move, const int &threshold) const;
+
+    // Set of enemy pieces giving check to the side to move.
+    [[nodiscard]] Bitboard checkers() const;
+
+    // Set of the given side's pieces pinned against their own king.
+    [[nodiscard]] Bitboard pinned_pieces(const bool &white) const;
+
+    // Set of squares holding a piece of the given type, of either color.
+    [[nodiscard]] Bitboard pieces(const PieceType &type) const;
+
+    // Set of pieces of either color attacking a square, with sliders blocked
+    // by the given occupancy.
+    [[nodiscard]] Bitboard attackers_to(const int &sq,
+                                        const Bitboard &occupied) const;
+
+    // Set of pieces of the given color attacking a square.
+    [[nodiscard]] Bitboard attackers_to(const int &sq,
+                                        const bool &white_is_attacking) const;
 
-    bool is_under_attack(const std::vector<std::pair<int, int>> &positions,
-                         const bool &white_is_attacking, const bool &nor);
+    // Subset of the given squares attacked by the given color.
+    [[nodiscard]] Bitboard attacked_squares(Bitboard squares,
+                                            const bool &white_is_attacking)
+    const;
 
-    bool in_check(const bool &white);
+    [[nodiscard]] bool is_under_attack(const std::pair<int, int> &pos,
+                                       const bool &white_is_attacking) const;
+
+    [[nodiscard]] bool is_under_attack(const Square &sq,
+                                       const bool &white_is_attacking) const;
+
+    // Whether any of the positions is attacked, or with `nor` set, whether
+    // none of them are.
+    [[nodiscard]] bool is_under_attack(
+        const std::vector<std::pair<int, int> > &positions,
+        const bool &white_is_attacking, const bool &nor) const;
+
+    [[nodiscard]] bool in_check(const bool &white) const;
 
 private:
-    std::array<std::array<Piece, BOARD_SIZE>, BOARD_SIZE> board{};
-    std::optional<std::pair<int, int> > en_passant{};
-    bool white_king_side_castle{};
-    bool white_queen_side_castle{};
-    bool black_king_side_castle{};
-    bool black_queen_side_castle{};
+    // Empties the board and resets all state, keeping allocated capacity.
+    void clear();
+
+    // Writes a piece (possibly empty) to a square, keeping the bitboards,
+    // key and score in sync with the board array.
+    void place_piece(const int &sq, const Piece &piece);
+
+    // Move generation and make/unmake, specialized per side so that every
+    // color test is resolved at compile time.
+    template<Color Us, GenType Type>
+    void generate(MoveList &moves) const;
+
+    template<Color Us>
+    void do_move(const Move &move);
+
+    template<Color Us>
+    void undo_move(const UndoInfo &undo);
+
+    // Destination squares of the king for each castling move currently
+    // available to the given side.
+    template<Color Us>
+    [[nodiscard]] Bitboard castling_destinations() const;
+
+    [[nodiscard]] Bitboard castling_destinations(const bool &white) const;
+
+    // Whether `sq` can be the en passant square: on the 3rd or 6th rank as
+    // the side to move requires, empty, with the opponent's pawn in front.
+    [[nodiscard]] bool valid_en_passant(const int &sq) const;
+
+    // Whether the pieces can stand as they do with this side to move: no
+    // pawn on the 1st or 8th rank, and the side not to move not in check.
+    [[nodiscard]] bool valid_placement() const;
+
+    // Recomputes the Zobrist key from scratch.
+    [[nodiscard]] uint64_t compute_key() const;
+
+    // Builds the move from one square to another, working out its flag from
+    // the position. The promotion piece is only used for promotions.
+    [[nodiscard]] Move infer_move(const int &from, const int &to,
+                                  const PieceType &promotion) const;
+
+    // Piece::code() of the piece on each square, indexed like the bitboards.
+    std::array<uint8_t, NUM_SQUARES> mailbox{};
+    std::array<Bitboard, NUM_PIECE_BBS> piece_bb{};
+    std::array<Bitboard, NUM_COLORS> color_bb{};
+    Bitboard occupied_bb{};
+    int en_passant{NO_SQUARE};
+    uint8_t castling{};
+    int halfmove{};
+    int fullmove{1};
     bool white_turn{};
+    uint64_t hash{};
+    psqt::Score psq{};
+    int game_phase{};
+    // A vector rather than a fixed array: games have no length limit, and a
+    // copy of the board only copies the moves played.
+    std::vector<UndoInfo> undo_stack{};
 };
 
 #endif //BOARD_H
@@ -0,0 +1,30 @@
+#include "bitboard.h"
+#include "move.h"
+
+std::string Move::to_string() const {
+    std::string result{
+        static_cast<char>('a' + file_of(from())),
+        static_cast<char>('1' + rank_of(from())),
+        static_cast<char>('a' + file_of(to())),
+        static_cast<char>('1' + rank_of(to()))
+    };
+
+    if (flag() == MoveFlag::PROMOTION) {
+        switch (promotion()) {
+            case PieceType::KNIGHT:
+                result += 'n';
+                break;
+            case PieceType::BISHOP:
+                result += 'b';
+                break;
+            case PieceType::ROOK:
+                result += 'r';
+                break;
+            default:
+                result += 'q';
+                break;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,154 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "piece.h"
+
+enum class MoveFlag : uint8_t {
+    NORMAL,
+    PROMOTION,
+    EN_PASSANT,
+    CASTLING
+};
+
+// Subsets of the legal moves that Board::generate_moves() can produce.
+// CAPTURES and QUIETS partition the legal moves.
+enum class GenType : uint8_t {
+    // Captures, including en passant and capturing promotions to any piece,
+    // and non-capturing promotions to a queen.
+    CAPTURES,
+    // Every other move: pushes, quiet piece moves, castling and
+    // non-capturing underpromotions.
+    QUIETS,
+    // Every legal move of a side in check. Must not be used otherwise.
+    EVASIONS,
+    ALL
+};
+
+// A move packed into 16 bits: source square (bits 0-5), destination square
+// (bits 6-11), promotion piece (bits 12-13, knight to queen) and flag
+// (bits 14-15). Castling is encoded as the king's two-square move.
+class Move {
+public:
+    // Leaves the move uninitialized so that move lists cost nothing to create.
+    Move() = default;
+
+    constexpr Move(const int from, const int to,
+                   const MoveFlag flag = MoveFlag::NORMAL,
+                   const PieceType promotion = PieceType::KNIGHT)
+        : data{
+            static_cast<uint16_t>(
+                from | to << 6 |
+                (static_cast<int>(promotion) -
+                 static_cast<int>(PieceType::KNIGHT)) << 12 |
+                static_cast<int>(flag) << 14)
+        } {}
+
+    // The null move, which never appears in a generated move list.
+    static constexpr Move none() {
+        return Move{0, 0};
+    }
+
+    // Rebuilds a move from its packed representation (see raw()).
+    static constexpr Move from_raw(const uint16_t raw) {
+        Move move{0, 0};
+        move.data = raw;
+        return move;
+    }
+
+    [[nodiscard]] constexpr int from() const {
+        return data & 0x3F;
+    }
+
+    [[nodiscard]] constexpr int to() const {
+        return data >> 6 & 0x3F;
+    }
+
+    [[nodiscard]] constexpr MoveFlag flag() const {
+        return static_cast<MoveFlag>(data >> 14);
+    }
+
+    // The piece a pawn promotes to; only meaningful for promotion moves.
+    [[nodiscard]] constexpr PieceType promotion() const {
+        return static_cast<PieceType>(
+            (data >> 12 & 0x3) + static_cast<int>(PieceType::KNIGHT));
+    }
+
+    [[nodiscard]] constexpr uint16_t raw() const {
+        return data;
+    }
+
+    [[nodiscard]] constexpr bool is_none() const {
+        return data == 0;
+    }
+
+    // Long algebraic (UCI) notation, e.g. "e2e4" or "e7e8q".
+    [[nodiscard]] std::string to_string() const;
+
+    constexpr bool operator==(const Move &other) const = default;
+
+private:
+    uint16_t data;
+};
+
+// Fixed-capacity move buffer, meant to live on the stack.
+class MoveList {
+public:
+    // Comfortably above the 218 legal moves possible in any position.
+    static constexpr std::size_t CAPACITY{256};
+
+    void push_back(const Move &move) {
+        moves[count++] = move;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    // Keeps only the first `size` moves.
+    void truncate(const std::size_t size) {
+        count = size;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return count;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return count == 0;
+    }
+
+    Move &operator[](const std::size_t i) {
+        return moves[i];
+    }
+
+    const Move &operator[](const std::size_t i) const {
+        return moves[i];
+    }
+
+    Move *begin() {
+        return moves.data();
+    }
+
+    Move *end() {
+        return moves.data() + count;
+    }
+
+    [[nodiscard]] const Move *begin() const {
+        return moves.data();
+    }
+
+    [[nodiscard]] const Move *end() const {
+        return moves.data() + count;
+    }
+
+private:
+    std::array<Move, CAPACITY> moves;
+    std::size_t count{0};
+};
+
+#endif //MOVE_H
@@ -0,0 +1,25 @@
+#ifndef PACKED_POSITION_H
+#define PACKED_POSITION_H
+
+#include <array>
+#include <cstdint>
+
+// A position in 32 bytes, for bulk storage and IPC. Multi-byte fields are
+// little-endian regardless of the host.
+//   bytes  0-7   occupancy bitboard
+//   bytes  8-23  4-bit piece_index() of each occupied square in ascending
+//                square order, low nibble first
+//   byte  24     bit 0: black to move, bits 1-4: castling rights
+//   byte  25     en passant square, or NO_SQUARE
+//   byte  26     halfmove clock, saturating at 255
+//   bytes 27-28  fullmove number
+//   bytes 29-31  ignored by Board; free for callers, e.g. a score or result
+struct PackedPosition {
+    std::array<uint8_t, 32> bytes{};
+
+    bool operator==(const PackedPosition &other) const = default;
+};
+
+static_assert(sizeof(PackedPosition) == 32);
+
+#endif //PACKED_POSITION_H
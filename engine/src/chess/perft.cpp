@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <ranges>
+#include <thread>
+
+#include "perft.h"
+
+PerftTable::PerftTable(const std::size_t &megabytes) {
+    const std::size_t count{
+        std::bit_floor(std::max<std::size_t>(
+            megabytes * 1024 * 1024 / sizeof(Entry), 1))
+    };
+    entries = std::make_unique<Entry[]>(count);
+    mask = count - 1;
+}
+
+bool PerftTable::probe(const uint64_t &key, const int &depth,
+                       uint64_t &nodes) const {
+    const Entry &entry{entries[key & mask]};
+    const uint64_t data{entry.data.load(std::memory_order_relaxed)};
+    if ((entry.check.load(std::memory_order_relaxed) ^ data) != key ||
+        static_cast<int>(data & 0xFF) != depth) {
+        return false;
+    }
+    nodes = data >> 8;
+    return true;
+}
+
+void PerftTable::store(const uint64_t &key, const int &depth,
+                       const uint64_t &nodes) {
+    Entry &entry{entries[key & mask]};
+    const uint64_t data{nodes << 8 | static_cast<uint64_t>(depth)};
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+uint64_t perft(Board &board, const int &depth, PerftTable *table) {
+    if (depth <= 0) {
+        return 1;
+    }
+
+    MoveList moves;
+    board.generate_moves(moves);
+    // Bulk counting: the last ply only needs the number of legal moves.
+    if (depth == 1) {
+        return moves.size();
+    }
+
+    const uint64_t key{board.key()};
+    uint64_t nodes{};
+    if (table) {
+        if (table->probe(key, depth, nodes)) {
+            return nodes;
+        }
+    }
+
+    for (const Move &move: moves) {
+        board.make_move(move);
+        nodes += perft(board, depth - 1, table);
+        board.unmake_move();
+    }
+
+    if (table) {
+        table->store(key, depth, nodes);
+    }
+    return nodes;
+}
+
+PerftResult perft_divide(const Board &board, const int &depth,
+                         const int &threads, PerftTable *table) {
+    const auto start{std::chrono::steady_clock::now()};
+    PerftResult result{};
+
+    MoveList moves;
+    board.generate_moves(moves);
+    for (const Move &move: moves) {
+        result.divide.emplace_back(move, 0);
+    }
+
+    // Workers claim root moves one at a time, so an unusually large subtree
+    // does not leave the other threads idle.
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        Board local{board};
+        for (std::size_t i = next++; i < result.divide.size(); i = next++) {
+            auto &[move, nodes]{result.divide[i]};
+            local.make_move(move);
+            nodes = perft(local, depth - 1, table);
+            local.unmake_move();
+        }
+    };
+
+    if (depth <= 0) {
+        result.divide.clear();
+        result.nodes = 1;
+    } else if (threads <= 1) {
+        worker();
+    } else {
+        std::vector<std::jthread> pool{};
+        for (int i = 0; i < threads; ++i) {
+            pool.emplace_back(worker);
+        }
+    }
+
+    for (const auto &nodes: result.divide | std::views::values) {
+        result.nodes += nodes;
+    }
+    result.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    return result;
+}
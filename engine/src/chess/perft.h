@@ -0,0 +1,52 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+#include "move.h"
+
+// Shared cache of subtree node counts, keyed by position and depth. Entries
+// store the key XORed with the data, so a torn write by a concurrent thread
+// fails verification instead of returning a wrong count.
+class PerftTable {
+public:
+    explicit PerftTable(const std::size_t &megabytes);
+
+    [[nodiscard]] bool probe(const uint64_t &key, const int &depth,
+                             uint64_t &nodes) const;
+
+    void store(const uint64_t &key, const int &depth, const uint64_t &nodes);
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    std::size_t mask;
+};
+
+struct PerftResult {
+    uint64_t nodes{};
+    // Node count below each root move, in generation order.
+    std::vector<std::pair<Move, uint64_t> > divide{};
+    double seconds{};
+};
+
+// Number of leaf nodes of the legal move tree of the given depth, with an
+// optional shared cache.
+uint64_t perft(Board &board, const int &depth, PerftTable *table = nullptr);
+
+// Runs perft below every root move, splitting the root moves across the
+// given number of threads, each working on its own copy of the board.
+PerftResult perft_divide(const Board &board, const int &depth,
+                         const int &threads, PerftTable *table = nullptr);
+
+#endif //PERFT_H
@@ -1,33 +1,24 @@
+#include <array>
+#include <stdexcept>
+
 #include "piece.h"
 
-std::string Piece::to_string() const {
-    switch (type) {
-        case PieceType::EMPTY:
-            return ".";
-        case PieceType::PAWN:
-            return isWhite ? "♟" : "♙";
-        case PieceType::ROOK:
-            return isWhite ? "♜" : "♖";
-        case PieceType::KNIGHT:
-            return isWhite ? "♞" : "♘";
-        case PieceType::BISHOP:
-            return isWhite ? "♝" : "♗";
-        case PieceType::QUEEN:
-            return isWhite ? "♛" : "♕";
-        case PieceType::KING:
-            return isWhite ? "♚" : "♔";
-        default:
-            throw std::domain_error("Unknown piece type");
-    }
+namespace {
+    // Indexed by Piece::code(); codes 7 and 15 hold no valid type.
+    constexpr std::array<std::string_view, NUM_PIECE_CODES> GLYPHS{
+        ".", "♙", "♘", "♗", "♖", "♕", "♔", "",
+        ".", "♟", "♞", "♝", "♜", "♛", "♚", ""
+    };
 }
 
-bool Piece::is_empty() const {
-    if (type == PieceType::EMPTY) {
-        return true;
+std::string Piece::to_string() const {
+    const std::string_view symbol{glyph()};
+    if (symbol.empty()) {
+        throw std::domain_error("Unknown piece type");
     }
-    return false;
+    return std::string{symbol};
 }
 
-bool Piece::operator==(const Piece &other) const {
-    return std::tie(type, isWhite) == std::tie(other.type, isWhite);
+std::string_view Piece::glyph() const {
+    return GLYPHS[code()];
 }
@@ -2,6 +2,7 @@
 #define PIECE_H
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 enum class PieceType : uint8_t {
     EMPTY,
@@ -13,14 +14,58 @@ enum class PieceType : uint8_t {
     KING
 };
 
+// Number of distinct 4-bit piece codes, see Piece::code().
+constexpr int NUM_PIECE_CODES{16};
+
 struct Piece {
     PieceType type: 3;
     bool isWhite: 1;
 
+    // The piece packed into 4 bits, the type in bits 0-2 and bit 3 set for
+    // white, for use as an index into tables of NUM_PIECE_CODES entries.
+    // Empty squares keep their color, like the struct itself.
+    [[nodiscard]] constexpr uint8_t code() const {
+        return static_cast<uint8_t>(static_cast<uint8_t>(type) |
+                                    (isWhite ? 8 : 0));
+    }
+
+    static constexpr Piece from_code(const uint8_t code) {
+        return Piece{static_cast<PieceType>(code & 7), (code & 8) != 0};
+    }
+
     [[nodiscard]] std::string to_string() const;
-    [[nodiscard]] bool is_empty() const;
 
-    bool operator==(const Piece &other) const;
+    // Same as to_string(), without allocating.
+    [[nodiscard]] std::string_view glyph() const;
+
+    [[nodiscard]] constexpr bool is_empty() const {
+        return type == PieceType::EMPTY;
+    }
+
+    constexpr bool operator==(const Piece &other) const {
+        return code() == other.code();
+    }
 };
 
+// A side as a compile-time parameter, for code specialized per color.
+enum class Color : uint8_t {
+    WHITE,
+    BLACK
+};
+
+constexpr Color operator~(const Color &color) {
+    return color == Color::WHITE ? Color::BLACK : Color::WHITE;
+}
+
+// Index of a side into per-color tables (white first).
+constexpr int color_index(const bool &white) {
+    return white ? 0 : 1;
+}
+
+// Index of a non-empty piece into per-piece tables: white pawn to king map to
+// 0-5 and black pawn to king map to 6-11.
+constexpr int piece_index(const Piece &piece) {
+    return color_index(piece.isWhite) * 6 + static_cast<int>(piece.type) - 1;
+}
+
 #endif //PIECE_H
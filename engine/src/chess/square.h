@@ -0,0 +1,73 @@
+#ifndef SQUARE_H
+#define SQUARE_H
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "bitboard.h"
+
+// A board square in one byte, numbered like the bitboards: a1 = 0, b1 = 1,
+// ..., h8 = 63. Converts implicitly to its index, so it can be used directly
+// with the bitboard and attack helpers.
+class Square {
+public:
+    // Leaves the square uninitialized, like Move.
+    Square() = default;
+
+    // The index must be in 0-63; it is not checked.
+    constexpr explicit Square(const int index)
+        : index{static_cast<uint8_t>(index)} {}
+
+    // Both coordinates must be in 0-7. A named factory rather than a
+    // constructor, so that a braced {row, col} pair never converts to it.
+    static constexpr Square from_coords(const int file, const int rank) {
+        return Square{rank * 8 + file};
+    }
+
+    // Parses a square name such as "e4".
+    static constexpr std::optional<Square> from_algebraic(
+        const std::string_view name) {
+        if (name.size() != 2 || name[0] < 'a' || name[0] > 'h' ||
+            name[1] < '1' || name[1] > '8') {
+            return std::nullopt;
+        }
+        return from_coords(name[0] - 'a', name[1] - '1');
+    }
+
+    // Converts a (row, col) board position, where row 0 is the 8th rank, as
+    // used by the checked Board API. The position must be on the board.
+    static constexpr Square from_position(const std::pair<int, int> &pos) {
+        return Square{square_of(pos)};
+    }
+
+    // Whether a (row, col) board position lies on the board.
+    static constexpr bool is_valid(const std::pair<int, int> &pos) {
+        return 0 <= pos.first && pos.first < 8 && 0 <= pos.second &&
+               pos.second < 8;
+    }
+
+    [[nodiscard]] constexpr int rank() const {
+        return index >> 3;
+    }
+
+    [[nodiscard]] constexpr int file() const {
+        return index & 7;
+    }
+
+    [[nodiscard]] constexpr std::pair<int, int> position() const {
+        return position_of(index);
+    }
+
+    constexpr operator int() const {
+        return index;
+    }
+
+private:
+    uint8_t index;
+};
+
+static_assert(sizeof(Square) == 1);
+
+#endif //SQUARE_H
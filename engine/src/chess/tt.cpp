@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "tt.h"
+#include "util/stats.h"
+
+namespace {
+    // Data word layout: move (16 bits), score (16), static eval (16),
+    // depth (8), bound (2) and generation (6).
+    constexpr int GENERATION_BITS{6};
+    constexpr uint8_t GENERATION_MASK{(1 << GENERATION_BITS) - 1};
+
+    uint64_t pack(const Move &move, const int &score, const int &eval,
+                  const int &depth, const Bound &bound,
+                  const uint8_t &generation) {
+        return static_cast<uint64_t>(move.raw()) |
+               static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16 |
+               static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 32 |
+               static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48 |
+               static_cast<uint64_t>(bound) << 56 |
+               static_cast<uint64_t>(generation) << 58;
+    }
+
+    Move unpack_move(const uint64_t &data) {
+        return Move::from_raw(static_cast<uint16_t>(data));
+    }
+
+    int unpack_depth(const uint64_t &data) {
+        return static_cast<int8_t>(data >> 48 & 0xFF);
+    }
+
+    Bound unpack_bound(const uint64_t &data) {
+        return static_cast<Bound>(data >> 56 & 0x3);
+    }
+
+    uint8_t unpack_generation(const uint64_t &data) {
+        return static_cast<uint8_t>(data >> 58);
+    }
+
+    // Large tables are aligned to 2 MB so that the kernel can back them with
+    // huge pages, which cuts TLB misses on random probes considerably.
+    constexpr std::size_t HUGE_PAGE_SIZE{2 * 1024 * 1024};
+
+    void *allocate(const std::size_t &bytes) {
+        const std::size_t alignment{
+            bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : 64
+        };
+        const std::size_t rounded{(bytes + alignment - 1) / alignment * alignment};
+#ifdef _WIN32
+        void *memory{_aligned_malloc(rounded, alignment)};
+#else
+        void *memory{std::aligned_alloc(alignment, rounded)};
+#endif
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (alignment == HUGE_PAGE_SIZE) {
+            madvise(memory, rounded, MADV_HUGEPAGE);
+        }
+#endif
+        return memory;
+    }
+
+    void deallocate(void *memory) {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+}
+
+TranspositionTable::TranspositionTable(const std::size_t &megabytes) {
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() {
+    release();
+}
+
+void TranspositionTable::resize(const std::size_t &megabytes) {
+    release();
+    bucket_count = std::max<std::size_t>(
+        megabytes * 1024 * 1024 / sizeof(Bucket), 1);
+    allocated_bytes = bucket_count * sizeof(Bucket);
+    buckets = static_cast<Bucket *>(allocate(allocated_bytes));
+    clear();
+}
+
+void TranspositionTable::clear() {
+    // Atomics of this size are plain words, so zeroing the memory directly is
+    // equivalent to storing zero into every slot.
+    std::memset(static_cast<void *>(buckets), 0, allocated_bytes);
+    generation = 0;
+}
+
+void TranspositionTable::new_search() {
+    generation = (generation + 1) & GENERATION_MASK;
+}
+
+bool TranspositionTable::probe(const uint64_t &key, TTEntry &entry) const {
+    STATS_COUNT(TT_PROBES);
+    for (const Slot &slot: bucket_of(key).slots) {
+        const uint64_t data{slot.data.load(std::memory_order_relaxed)};
+        if ((slot.check.load(std::memory_order_relaxed) ^ data) == key &&
+            data != 0) {
+            entry.move = unpack_move(data);
+            entry.score = static_cast<int16_t>(data >> 16);
+            entry.eval = static_cast<int16_t>(data >> 32);
+            entry.depth = unpack_depth(data);
+            entry.bound = unpack_bound(data);
+            STATS_COUNT(TT_HITS);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(const uint64_t &key, const Move &move,
+                               const int &score, const int &eval,
+                               const int &depth, const Bound &bound) {
+    Bucket &bucket{bucket_of(key)};
+    Slot *replace{&bucket.slots[0]};
+    int worst_value{std::numeric_limits<int>::max()};
+    uint64_t replaced_data{0};
+
+    for (Slot &slot: bucket.slots) {
+        const uint64_t data{slot.data.load(std::memory_order_relaxed)};
+        // Overwrite the same position in place.
+        if ((slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+            replace = &slot;
+            replaced_data = data;
+            break;
+        }
+        // Otherwise evict the shallowest entry, counting every generation of
+        // age as eight plies of depth.
+        const int age{(generation - unpack_generation(data)) & GENERATION_MASK};
+        if (const int value{unpack_depth(data) - 8 * age}; value < worst_value) {
+            worst_value = value;
+            replace = &slot;
+            replaced_data = data;
+        }
+    }
+
+    // Keep the previous best move when this result has none, and do not let
+    // a shallow non-exact result overwrite a deeper one for the same
+    // position.
+    const bool same_position{
+        (replace->check.load(std::memory_order_relaxed) ^ replaced_data) == key
+    };
+    Move best{move};
+    if (same_position) {
+        if (best.is_none()) {
+            best = unpack_move(replaced_data);
+        }
+        if (bound != Bound::EXACT && depth + 4 <
+            unpack_depth(replaced_data) &&
+            unpack_generation(replaced_data) == generation) {
+            return;
+        }
+    }
+
+#ifdef ENGINE_STATS
+    if (!same_position && replaced_data != 0 &&
+        unpack_generation(replaced_data) == generation) {
+        STATS_COUNT(TT_COLLISIONS);
+    }
+#endif
+
+    const uint64_t data{pack(best, score, eval, depth, bound, generation)};
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::prefetch(const uint64_t &key) const {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(&bucket_of(key));
+#else
+    static_cast<void>(key);
+#endif
+}
+
+int TranspositionTable::hashfull() const {
+    const std::size_t sample{
+        std::min<std::size_t>(bucket_count, 1000 / BUCKET_SIZE)
+    };
+    int used{0};
+    for (std::size_t i = 0; i < sample; ++i) {
+        for (const Slot &slot: buckets[i].slots) {
+            const uint64_t data{slot.data.load(std::memory_order_relaxed)};
+            used += data != 0 && unpack_generation(data) == generation;
+        }
+    }
+    return static_cast<int>(used * 1000 / (sample * BUCKET_SIZE));
+}
+
+std::size_t TranspositionTable::size_mb() const {
+    return allocated_bytes / (1024 * 1024);
+}
+
+TranspositionTable::Bucket &TranspositionTable::bucket_of(
+    const uint64_t &key) const {
+    // Maps the key onto [0, bucket_count) with a multiply instead of a
+    // modulo, which allows table sizes that are not powers of two.
+#ifdef __SIZEOF_INT128__
+    return buckets[static_cast<std::size_t>(
+        static_cast<unsigned __int128>(key) * bucket_count >> 64)];
+#else
+    return buckets[key % bucket_count];
+#endif
+}
+
+void TranspositionTable::release() {
+    if (buckets) {
+        deallocate(buckets);
+        buckets = nullptr;
+    }
+    bucket_count = allocated_bytes = 0;
+}
@@ -0,0 +1,91 @@
+#ifndef TT_H
+#define TT_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "move.h"
+
+enum class Bound : uint8_t {
+    NONE,
+    UPPER,
+    LOWER,
+    EXACT
+};
+
+// Decoded contents of a transposition table entry.
+struct TTEntry {
+    Move move;
+    int16_t score;
+    int16_t eval;
+    int depth;
+    Bound bound;
+};
+
+// Fixed-size hash table of search results shared by all search threads.
+//
+// Each entry is two 64-bit words: the packed data, and the position key
+// XORed with that data. Threads read and write entries without locks; an
+// entry torn by a concurrent write no longer verifies against its key and
+// is treated as a miss. Entries are grouped into cache-line-sized buckets,
+// so a probe touches a single line.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(const std::size_t &megabytes = 16);
+
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable &) = delete;
+
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+    // Reallocates the table with the given size, discarding its contents.
+    void resize(const std::size_t &megabytes);
+
+    void clear();
+
+    // Starts a new search generation, making older entries preferred for
+    // replacement.
+    void new_search();
+
+    [[nodiscard]] bool probe(const uint64_t &key, TTEntry &entry) const;
+
+    void store(const uint64_t &key, const Move &move, const int &score,
+               const int &eval, const int &depth, const Bound &bound);
+
+    // Hints the CPU to start loading the bucket of a key.
+    void prefetch(const uint64_t &key) const;
+
+    // Approximate fill level in permille, sampled from the first buckets and
+    // counting only entries of the current generation.
+    [[nodiscard]] int hashfull() const;
+
+    [[nodiscard]] std::size_t size_mb() const;
+
+private:
+    static constexpr int BUCKET_SIZE{4};
+
+    struct Slot {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket {
+        std::array<Slot, BUCKET_SIZE> slots;
+    };
+
+    static_assert(sizeof(Bucket) == 64, "TT buckets must fill a cache line");
+
+    [[nodiscard]] Bucket &bucket_of(const uint64_t &key) const;
+
+    void release();
+
+    Bucket *buckets{nullptr};
+    std::size_t bucket_count{0};
+    std::size_t allocated_bytes{0};
+    uint8_t generation{0};
+};
+
+#endif //TT_H
@@ -0,0 +1,60 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <array>
+#include <cstdint>
+
+#include "bitboard.h"
+
+// Random keys for Zobrist hashing. A position's key is the XOR of the keys of
+// its pieces, castling rights, en passant file and side to move, so a move
+// updates it with a handful of XORs. The keys are generated at compile time
+// from a fixed seed and are therefore identical across builds.
+namespace zobrist {
+    struct Keys {
+        std::array<std::array<uint64_t, NUM_SQUARES>, NUM_PIECE_BBS> piece{};
+        // Indexed by the full castling rights mask.
+        std::array<uint64_t, 16> castling{};
+        // Indexed by the file of the en passant square.
+        std::array<uint64_t, 8> en_passant{};
+        // Included when black is to move.
+        uint64_t black_to_move{};
+    };
+
+    constexpr Keys generate() {
+        // splitmix64, seeded arbitrarily.
+        uint64_t state{0x3C6EF372FE94F82AULL};
+        auto next = [&state] {
+            uint64_t z{state += 0x9E3779B97F4A7C15ULL};
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        };
+
+        Keys keys{};
+        for (auto &squares: keys.piece) {
+            for (uint64_t &key: squares) {
+                key = next();
+            }
+        }
+        // Castling keys are built from one key per right, so that updating
+        // the rights is a single XOR of two table entries.
+        std::array<uint64_t, 4> rights{next(), next(), next(), next()};
+        for (int mask = 0; mask < 16; ++mask) {
+            for (int right = 0; right < 4; ++right) {
+                if (mask & (1 << right)) {
+                    keys.castling[mask] ^= rights[right];
+                }
+            }
+        }
+        for (uint64_t &key: keys.en_passant) {
+            key = next();
+        }
+        keys.black_to_move = next();
+        return keys;
+    }
+
+    inline constexpr Keys KEYS{generate()};
+}
+
+#endif //ZOBRIST_H
@@ -0,0 +1,135 @@
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#include "position_db.h"
+
+namespace {
+    constexpr std::array<char, 8> MAGIC{'C', 'A', 'P', 'O', 'S', 'D', 'B', '\0'};
+
+    void write_le(std::array<char, position_db::HEADER_SIZE> &header,
+                  const std::size_t &offset, const uint64_t &value,
+                  const int &bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            header[offset + i] = static_cast<char>(value >> (8 * i));
+        }
+    }
+
+    uint64_t read_le(const std::byte *data, const int &bytes) {
+        uint64_t value{0};
+        for (int i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(data[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    std::array<char, position_db::HEADER_SIZE> make_header(
+        const uint64_t &count) {
+        std::array<char, position_db::HEADER_SIZE> header{};
+        std::memcpy(header.data(), MAGIC.data(), MAGIC.size());
+        write_le(header, 8, position_db::VERSION, 4);
+        write_le(header, 12, sizeof(PackedPosition), 4);
+        write_le(header, 16, count, 8);
+        return header;
+    }
+}
+
+PositionDbWriter::PositionDbWriter(const std::string &path)
+    : out{path, std::ios::binary | std::ios::trunc} {
+    if (!out) {
+        const std::string error_msg{"Cannot create position database " + path};
+        throw std::invalid_argument(error_msg);
+    }
+    // The count is filled in by close().
+    const std::array<char, position_db::HEADER_SIZE> header{make_header(0)};
+    out.write(header.data(), header.size());
+}
+
+PositionDbWriter::~PositionDbWriter() {
+    if (out.is_open()) {
+        static_cast<void>(close());
+    }
+}
+
+bool PositionDbWriter::append(const PackedPosition &position) {
+    out.write(reinterpret_cast<const char *>(position.bytes.data()),
+              position.bytes.size());
+    if (!out) {
+        return false;
+    }
+    ++count;
+    return true;
+}
+
+bool PositionDbWriter::append(const Board &board) {
+    return append(board.pack());
+}
+
+bool PositionDbWriter::close() {
+    const std::array<char, position_db::HEADER_SIZE> header{make_header(count)};
+    out.seekp(0);
+    out.write(header.data(), header.size());
+    // Buffered records are only written out here, so a full disk may show
+    // up no earlier.
+    out.close();
+    return !out.fail();
+}
+
+uint64_t PositionDbWriter::size() const {
+    return count;
+}
+
+PositionDb::PositionDb(const std::string &path)
+    : file{path, MappedFile::Access::SEQUENTIAL} {
+    const std::string error_msg{"Invalid position database " + path};
+    const std::byte *data{file.data()};
+    if (file.size() < position_db::HEADER_SIZE ||
+        std::memcmp(data, MAGIC.data(), MAGIC.size()) != 0 ||
+        read_le(data + 8, 4) != position_db::VERSION ||
+        read_le(data + 12, 4) != sizeof(PackedPosition)) {
+        throw std::invalid_argument(error_msg);
+    }
+    const uint64_t count{read_le(data + 16, 8)};
+    if ((file.size() - position_db::HEADER_SIZE) / sizeof(PackedPosition) <
+        count) {
+        throw std::invalid_argument(error_msg);
+    }
+    positions = {
+        reinterpret_cast<const PackedPosition *>(data + position_db::HEADER_SIZE),
+        static_cast<std::size_t>(count)
+    };
+}
+
+std::size_t PositionDb::size() const {
+    return positions.size();
+}
+
+std::span<const PackedPosition> PositionDb::records() const {
+    return positions;
+}
+
+const PackedPosition &PositionDb::operator[](const std::size_t &index) const {
+    return positions[index];
+}
+
+const PackedPosition &PositionDb::at(const std::size_t &index) const {
+    if (index >= positions.size()) {
+        const std::string error_msg{
+            "Invalid record index " + std::to_string(index) + " (size: " +
+            std::to_string(positions.size()) + ")"
+        };
+        throw std::out_of_range(error_msg);
+    }
+    return positions[index];
+}
+
+bool PositionDb::load(const std::size_t &index, Board &board) const {
+    return board.unpack(at(index));
+}
+
+std::span<const PackedPosition> PositionDb::shard(
+    const std::size_t &index, const std::size_t &count) const {
+    const std::size_t begin{positions.size() * index / count};
+    const std::size_t end{positions.size() * (index + 1) / count};
+    return positions.subspan(begin, end - begin);
+}
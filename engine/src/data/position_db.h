@@ -0,0 +1,121 @@
+#ifndef POSITION_DB_H
+#define POSITION_DB_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chess/board.h"
+#include "chess/packed_position.h"
+#include "util/mapped_file.h"
+
+// File layout: a 64-byte header followed by 32-byte PackedPosition records.
+//   bytes  0-7   magic "CAPOSDB\0"
+//   bytes  8-11  format version (1), little-endian
+//   bytes 12-15  record size (32)
+//   bytes 16-23  record count
+//   bytes 24-63  zero
+// Games are stored as runs of consecutive positions; the spare record bytes
+// can carry per-position data such as a score or the game result.
+namespace position_db {
+    constexpr std::size_t HEADER_SIZE{64};
+    constexpr uint32_t VERSION{1};
+}
+
+// Streams positions into a new database file.
+class PositionDbWriter {
+public:
+    // Creates or truncates the file. Throws std::invalid_argument if it
+    // cannot be opened.
+    explicit PositionDbWriter(const std::string &path);
+
+    PositionDbWriter(const PositionDbWriter &) = delete;
+
+    PositionDbWriter &operator=(const PositionDbWriter &) = delete;
+
+    // Closes the file if close() was not called, ignoring failures; call
+    // close() to learn whether the file is complete.
+    ~PositionDbWriter();
+
+    // Returns false if the record could not be written, e.g. on a full
+    // disk. The file is then incomplete, and later appends fail too.
+    bool append(const PackedPosition &position);
+
+    bool append(const Board &board);
+
+    // Writes the final record count into the header and returns whether
+    // the whole file, with everything still buffered, reached the disk.
+    bool close();
+
+    // Records written so far.
+    [[nodiscard]] uint64_t size() const;
+
+private:
+    std::ofstream out;
+    uint64_t count{0};
+};
+
+// Read-only view of a database file, memory-mapped so that records are read
+// in place: nothing is copied or allocated per record.
+class PositionDb {
+public:
+    // Throws std::invalid_argument if the file cannot be mapped or is not a
+    // well-formed database.
+    explicit PositionDb(const std::string &path);
+
+    [[nodiscard]] std::size_t size() const;
+
+    [[nodiscard]] std::span<const PackedPosition> records() const;
+
+    // Unchecked access by index.
+    const PackedPosition &operator[](const std::size_t &index) const;
+
+    // Throws std::out_of_range for an invalid index.
+    [[nodiscard]] const PackedPosition &at(const std::size_t &index) const;
+
+    // Decodes a record into an existing board; returns false if the record
+    // is malformed.
+    bool load(const std::size_t &index, Board &board) const;
+
+    // Contiguous part `index` of `count` nearly equal parts.
+    [[nodiscard]] std::span<const PackedPosition> shard(
+        const std::size_t &index, const std::size_t &count) const;
+
+    // Calls visit(board, index) for every well-formed record, splitting the
+    // file into one shard per thread. Each thread decodes into its own
+    // reused Board, so `visit` must be safe to call concurrently.
+    template<typename Visitor>
+    void scan(const std::size_t &threads, Visitor &&visit) const;
+
+private:
+    MappedFile file;
+    std::span<const PackedPosition> positions{};
+};
+
+template<typename Visitor>
+void PositionDb::scan(const std::size_t &threads, Visitor &&visit) const {
+    const std::size_t count{std::max<std::size_t>(threads, 1)};
+    std::vector<std::jthread> workers{};
+    workers.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        workers.emplace_back([this, &visit, i, count] {
+            const std::span<const PackedPosition> part{shard(i, count)};
+            const std::size_t first{
+                static_cast<std::size_t>(part.data() - positions.data())
+            };
+            Board board{};
+            for (std::size_t j = 0; j < part.size(); ++j) {
+                if (board.unpack(part[j])) {
+                    visit(static_cast<const Board &>(board), first + j);
+                }
+            }
+        });
+    }
+}
+
+#endif //POSITION_DB_H
@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
+#include "batch.h"
+#include "psqt.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BATCH_X86_DISPATCH
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+    // The piece-square score of every piece is split into the low and high
+    // byte of its middlegame and endgame halves, each a 16-entry table by
+    // Piece::code(). That is exactly one byte shuffle, so a vector of codes
+    // looks up its scores in a single instruction, with no gathers.
+    enum Term { MG_LOW, MG_HIGH, EG_LOW, EG_HIGH, NUM_TERMS };
+
+    using CodeTable = std::array<uint8_t, NUM_PIECE_CODES>;
+
+    alignas(64) constexpr std::array<std::array<CodeTable, NUM_TERMS>, NUM_SQUARES> TERMS{
+        [] {
+            std::array<std::array<CodeTable, NUM_TERMS>, NUM_SQUARES> terms{};
+            for (int code = 0; code < NUM_PIECE_CODES; ++code) {
+                const Piece piece{Piece::from_code(static_cast<uint8_t>(code))};
+                // Empty squares, and the two codes no piece uses, add nothing.
+                if (piece.is_empty() || piece.type > PieceType::KING) {
+                    continue;
+                }
+                for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+                    const psqt::Score score{psqt::SCORES[piece_index(piece)][sq]};
+                    const auto mg{static_cast<uint16_t>(score.mg)};
+                    const auto eg{static_cast<uint16_t>(score.eg)};
+                    terms[sq][MG_LOW][code] = static_cast<uint8_t>(mg);
+                    terms[sq][MG_HIGH][code] = static_cast<uint8_t>(mg >> 8);
+                    terms[sq][EG_LOW][code] = static_cast<uint8_t>(eg);
+                    terms[sq][EG_HIGH][code] = static_cast<uint8_t>(eg >> 8);
+                }
+            }
+            return terms;
+        }()
+    };
+
+    alignas(16) constexpr CodeTable PHASE{
+        [] {
+            CodeTable phase{};
+            for (int code = 0; code < NUM_PIECE_CODES; ++code) {
+                const PieceType type{Piece::from_code(static_cast<uint8_t>(code)).type};
+                if (type <= PieceType::KING) {
+                    phase[code] = static_cast<uint8_t>(
+                        psqt::PHASE_WEIGHT[static_cast<int>(type)]);
+                }
+            }
+            return phase;
+        }()
+    };
+
+    // Sums the terms over all squares of `count` positions, a multiple of
+    // PositionBatch::LANES. 16 bits hold any sum: a position has at most 32
+    // pieces, and a side's pieces add up to less than 32768 either way.
+    using Kernel = void (*)(const uint8_t *planes, std::size_t stride,
+                            std::size_t count, int16_t *mg, int16_t *eg,
+                            uint8_t *phase);
+
+    // ---------------------- Portable ----------------------
+
+    int16_t term(const int &sq, const uint8_t &code, const Term &low) {
+        return static_cast<int16_t>(TERMS[sq][low][code] |
+                                    TERMS[sq][low + 1][code] << 8);
+    }
+
+    void evaluate_scalar(const uint8_t *planes, const std::size_t stride,
+                         const std::size_t count, int16_t *mg, int16_t *eg,
+                         uint8_t *phase) {
+        std::fill_n(mg, count, 0);
+        std::fill_n(eg, count, 0);
+        std::fill_n(phase, count, 0);
+        for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+            const uint8_t *codes{planes + sq * stride};
+            for (std::size_t i = 0; i < count; ++i) {
+                mg[i] = static_cast<int16_t>(mg[i] + term(sq, codes[i], MG_LOW));
+                eg[i] = static_cast<int16_t>(eg[i] + term(sq, codes[i], EG_LOW));
+                phase[i] = static_cast<uint8_t>(phase[i] + PHASE[codes[i]]);
+            }
+        }
+    }
+
+#ifdef BATCH_X86_DISPATCH
+    // ---------------------- AVX2 ----------------------
+
+    // A byte shuffle only looks up within 128-bit lanes, so each table is
+    // repeated in both halves.
+    __attribute__((target("avx2")))
+    __m256i lookup_avx2(const CodeTable &table, const __m256i codes) {
+        return _mm256_shuffle_epi8(
+            _mm256_broadcastsi128_si256(
+                _mm_load_si128(reinterpret_cast<const __m128i *>(table.data()))),
+            codes);
+    }
+
+    // 32 positions per vector of codes.
+    __attribute__((target("avx2")))
+    void evaluate_avx2(const uint8_t *planes, const std::size_t stride,
+                       const std::size_t count, int16_t *mg, int16_t *eg,
+                       uint8_t *phase) {
+        for (std::size_t i = 0; i < count; i += 32) {
+            __m256i mg_first{_mm256_setzero_si256()};
+            __m256i mg_second{_mm256_setzero_si256()};
+            __m256i eg_first{_mm256_setzero_si256()};
+            __m256i eg_second{_mm256_setzero_si256()};
+            __m256i phases{_mm256_setzero_si256()};
+            for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+                const __m256i codes{
+                    _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(planes + sq * stride + i))
+                };
+                phases = _mm256_add_epi8(phases, lookup_avx2(PHASE, codes));
+
+                // Interleaving low and high bytes widens to 16 bits but
+                // works within lanes; reordering the 64-bit quarters first
+                // keeps the positions in order: 0-15, then 16-31.
+                const __m256i ordered{_mm256_permute4x64_epi64(codes, 0xD8)};
+                const auto &terms{TERMS[sq]};
+                const __m256i mg_low{lookup_avx2(terms[MG_LOW], ordered)};
+                const __m256i mg_high{lookup_avx2(terms[MG_HIGH], ordered)};
+                const __m256i eg_low{lookup_avx2(terms[EG_LOW], ordered)};
+                const __m256i eg_high{lookup_avx2(terms[EG_HIGH], ordered)};
+                mg_first = _mm256_add_epi16(mg_first, _mm256_unpacklo_epi8(mg_low, mg_high));
+                mg_second = _mm256_add_epi16(mg_second, _mm256_unpackhi_epi8(mg_low, mg_high));
+                eg_first = _mm256_add_epi16(eg_first, _mm256_unpacklo_epi8(eg_low, eg_high));
+                eg_second = _mm256_add_epi16(eg_second, _mm256_unpackhi_epi8(eg_low, eg_high));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(mg + i), mg_first);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(mg + i + 16), mg_second);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(eg + i), eg_first);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(eg + i + 16), eg_second);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(phase + i), phases);
+        }
+    }
+
+    // ---------------------- AVX-512 ----------------------
+
+    __attribute__((target("avx512f,avx512bw")))
+    __m512i lookup_avx512(const CodeTable &table, const __m512i codes) {
+        return _mm512_shuffle_epi8(
+            _mm512_broadcast_i32x4(
+                _mm_load_si128(reinterpret_cast<const __m128i *>(table.data()))),
+            codes);
+    }
+
+    // 64 positions per vector of codes.
+    __attribute__((target("avx512f,avx512bw")))
+    void evaluate_avx512(const uint8_t *planes, const std::size_t stride,
+                         const std::size_t count, int16_t *mg, int16_t *eg,
+                         uint8_t *phase) {
+        // Puts quarters i and i + 4 in lane i, as for AVX2.
+        const __m512i order{_mm512_setr_epi64(0, 4, 1, 5, 2, 6, 3, 7)};
+        for (std::size_t i = 0; i < count; i += 64) {
+            __m512i mg_first{_mm512_setzero_si512()};
+            __m512i mg_second{_mm512_setzero_si512()};
+            __m512i eg_first{_mm512_setzero_si512()};
+            __m512i eg_second{_mm512_setzero_si512()};
+            __m512i phases{_mm512_setzero_si512()};
+            for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+                const __m512i codes{_mm512_loadu_si512(planes + sq * stride + i)};
+                phases = _mm512_add_epi8(phases, lookup_avx512(PHASE, codes));
+
+                const __m512i ordered{_mm512_permutexvar_epi64(order, codes)};
+                const auto &terms{TERMS[sq]};
+                const __m512i mg_low{lookup_avx512(terms[MG_LOW], ordered)};
+                const __m512i mg_high{lookup_avx512(terms[MG_HIGH], ordered)};
+                const __m512i eg_low{lookup_avx512(terms[EG_LOW], ordered)};
+                const __m512i eg_high{lookup_avx512(terms[EG_HIGH], ordered)};
+                mg_first = _mm512_add_epi16(mg_first, _mm512_unpacklo_epi8(mg_low, mg_high));
+                mg_second = _mm512_add_epi16(mg_second, _mm512_unpackhi_epi8(mg_low, mg_high));
+                eg_first = _mm512_add_epi16(eg_first, _mm512_unpacklo_epi8(eg_low, eg_high));
+                eg_second = _mm512_add_epi16(eg_second, _mm512_unpackhi_epi8(eg_low, eg_high));
+            }
+            _mm512_storeu_si512(mg + i, mg_first);
+            _mm512_storeu_si512(mg + i + 32, mg_second);
+            _mm512_storeu_si512(eg + i, eg_first);
+            _mm512_storeu_si512(eg + i + 32, eg_second);
+            _mm512_storeu_si512(phase + i, phases);
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    // ---------------------- NEON ----------------------
+
+    // 16 positions per vector of codes; zipping keeps them in order.
+    void evaluate_neon(const uint8_t *planes, const std::size_t stride,
+                       const std::size_t count, int16_t *mg, int16_t *eg,
+                       uint8_t *phase) {
+        const uint8x16_t phase_table{vld1q_u8(PHASE.data())};
+        for (std::size_t i = 0; i < count; i += 16) {
+            int16x8_t mg_first{vdupq_n_s16(0)};
+            int16x8_t mg_second{vdupq_n_s16(0)};
+            int16x8_t eg_first{vdupq_n_s16(0)};
+            int16x8_t eg_second{vdupq_n_s16(0)};
+            uint8x16_t phases{vdupq_n_u8(0)};
+            for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+                const uint8x16_t codes{vld1q_u8(planes + sq * stride + i)};
+                phases = vaddq_u8(phases, vqtbl1q_u8(phase_table, codes));
+
+                const auto &terms{TERMS[sq]};
+                const uint8x16_t mg_low{vqtbl1q_u8(vld1q_u8(terms[MG_LOW].data()), codes)};
+                const uint8x16_t mg_high{vqtbl1q_u8(vld1q_u8(terms[MG_HIGH].data()), codes)};
+                const uint8x16_t eg_low{vqtbl1q_u8(vld1q_u8(terms[EG_LOW].data()), codes)};
+                const uint8x16_t eg_high{vqtbl1q_u8(vld1q_u8(terms[EG_HIGH].data()), codes)};
+                mg_first = vaddq_s16(mg_first, vreinterpretq_s16_u8(vzip1q_u8(mg_low, mg_high)));
+                mg_second = vaddq_s16(mg_second, vreinterpretq_s16_u8(vzip2q_u8(mg_low, mg_high)));
+                eg_first = vaddq_s16(eg_first, vreinterpretq_s16_u8(vzip1q_u8(eg_low, eg_high)));
+                eg_second = vaddq_s16(eg_second, vreinterpretq_s16_u8(vzip2q_u8(eg_low, eg_high)));
+            }
+            vst1q_s16(mg + i, mg_first);
+            vst1q_s16(mg + i + 8, mg_second);
+            vst1q_s16(eg + i, eg_first);
+            vst1q_s16(eg + i + 8, eg_second);
+            vst1q_u8(phase + i, phases);
+        }
+    }
+#endif
+
+    struct Selected {
+        const char *name;
+        Kernel kernel;
+    };
+
+    const Selected &select() {
+        static constexpr Selected SCALAR{"scalar", evaluate_scalar};
+#ifdef BATCH_X86_DISPATCH
+        static constexpr Selected AVX2{"avx2", evaluate_avx2};
+        static constexpr Selected AVX512{"avx512", evaluate_avx512};
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+            return AVX512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return AVX2;
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        static constexpr Selected NEON{"neon", evaluate_neon};
+        return NEON;
+#endif
+        return SCALAR;
+    }
+
+    const Selected &selected() {
+        static const Selected &kernel{select()};
+        return kernel;
+    }
+}
+
+void PositionBatch::assign(const uint8_t *packed, const std::size_t &count) {
+    resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        decode(packed + i * sizeof(PackedPosition), i);
+    }
+}
+
+void PositionBatch::assign(const std::span<const PackedPosition> positions) {
+    resize(positions.size());
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        decode(positions[i].bytes.data(), i);
+    }
+}
+
+std::size_t PositionBatch::size() const {
+    return count;
+}
+
+const uint8_t *PositionBatch::plane(const int &sq) const {
+    return planes.data() + sq * padded;
+}
+
+std::size_t PositionBatch::stride() const {
+    return padded;
+}
+
+bool PositionBatch::is_white_turn(const std::size_t &i) const {
+    return white_turn[i] != 0;
+}
+
+bool PositionBatch::is_valid(const std::size_t &i) const {
+    return valid[i] != 0;
+}
+
+void PositionBatch::resize(const std::size_t &count) {
+    this->count = count;
+    padded = (count + LANES - 1) / LANES * LANES;
+    // assign() keeps the capacity, so a batch no larger than an earlier one
+    // does not allocate.
+    planes.assign(NUM_SQUARES * padded, 0);
+    white_turn.assign(count, 0);
+    valid.assign(count, 0);
+}
+
+void PositionBatch::decode(const uint8_t *bytes, const std::size_t &i) {
+    // The same layout and piece checks as Board::unpack(), without setting
+    // up a board. Scoring needs no legality checks, so they are left out.
+    Bitboard occupied{EMPTY_BB};
+    for (int b = 0; b < 8; ++b) {
+        occupied |= Bitboard{bytes[b]} << (8 * b);
+    }
+    if (popcount(occupied) > 32 || bytes[24] >> 5 != 0 ||
+        bytes[25] > NO_SQUARE) {
+        return;
+    }
+
+    bool well_formed{true};
+    std::array<int, NUM_COLORS> kings{};
+    Bitboard remaining{occupied};
+    for (int k = 0; remaining; ++k) {
+        const int index{bytes[8 + k / 2] >> (4 * (k % 2)) & 0xF};
+        const int sq{pop_lsb(remaining)};
+        if (index >= NUM_PIECE_BBS) {
+            well_formed = false;
+            break;
+        }
+        const Piece piece{static_cast<PieceType>(index % 6 + 1), index < 6};
+        if (piece.type == PieceType::KING) {
+            ++kings[color_index(piece.isWhite)];
+        }
+        planes[sq * padded + i] = piece.code();
+    }
+    if (!well_formed || kings[0] != 1 || kings[1] != 1) {
+        // Leaves the column empty, so it scores like padding.
+        while (occupied) {
+            planes[pop_lsb(occupied) * padded + i] = 0;
+        }
+        return;
+    }
+
+    white_turn[i] = (bytes[24] & 1) == 0;
+    valid[i] = 1;
+}
+
+void evaluate_batch(const PositionBatch &batch, const std::span<int> scores) {
+    if (scores.size() < batch.size()) {
+        const std::string error_msg{
+            "Score buffer too small: " + std::to_string(scores.size()) +
+            " for " + std::to_string(batch.size()) + " positions"
+        };
+        throw std::invalid_argument(error_msg);
+    }
+
+    // Per thread, so batches of similar sizes reuse the same buffers.
+    thread_local std::vector<int16_t> mg{};
+    thread_local std::vector<int16_t> eg{};
+    thread_local std::vector<uint8_t> phase{};
+    mg.resize(batch.stride());
+    eg.resize(batch.stride());
+    phase.resize(batch.stride());
+
+    selected().kernel(batch.plane(0), batch.stride(), batch.stride(),
+                      mg.data(), eg.data(), phase.data());
+
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        const int score{psqt::taper({mg[i], eg[i]}, phase[i])};
+        scores[i] = !batch.is_valid(i) ? 0 : batch.is_white_turn(i) ? score : -score;
+    }
+}
+
+const char *batch_kernel_name() {
+    return selected().name;
+}
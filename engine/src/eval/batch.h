@@ -0,0 +1,62 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "chess/packed_position.h"
+
+// Positions in structure-of-arrays form for batch evaluation: for every
+// square, the Piece::code() on it in each position, so that consecutive
+// positions sit side by side in a vector register. Reused across batches,
+// it only allocates when a batch is larger than any before. Batches of about
+// a thousand positions keep the planes in cache.
+class PositionBatch {
+public:
+    // Positions per plane are padded to a multiple of the widest kernel's
+    // lanes, so kernels never need a scalar tail.
+    static constexpr std::size_t LANES{64};
+
+    // Replaces the batch by `count` positions stored as consecutive 32-byte
+    // PackedPosition images.
+    void assign(const uint8_t *packed, const std::size_t &count);
+
+    void assign(std::span<const PackedPosition> positions);
+
+    [[nodiscard]] std::size_t size() const;
+
+    // Codes of one square across the padded batch.
+    [[nodiscard]] const uint8_t *plane(const int &sq) const;
+
+    // Distance between planes, a multiple of LANES.
+    [[nodiscard]] std::size_t stride() const;
+
+    [[nodiscard]] bool is_white_turn(const std::size_t &i) const;
+
+    // Whether position `i` passed the checks of Board::unpack().
+    [[nodiscard]] bool is_valid(const std::size_t &i) const;
+
+private:
+    void resize(const std::size_t &count);
+
+    // Writes one position into column `i`, which must be empty.
+    void decode(const uint8_t *bytes, const std::size_t &i);
+
+    std::size_t count{0};
+    std::size_t padded{0};
+    std::vector<uint8_t> planes{};
+    std::vector<uint8_t> white_turn{};
+    std::vector<uint8_t> valid{};
+};
+
+// Static evaluation of every position in the batch, as evaluate() would
+// give after Board::unpack(), into scores[0, batch.size()). Malformed
+// positions score 0.
+void evaluate_batch(const PositionBatch &batch, std::span<int> scores);
+
+// Name of the kernel evaluate_batch() uses on this CPU.
+const char *batch_kernel_name();
+
+#endif //BATCH_H
@@ -0,0 +1,8 @@
+#include "evaluate.h"
+#include "psqt.h"
+
+int evaluate(const Board &board) {
+    // Material and piece-square terms are kept up to date by the board.
+    const int score{psqt::taper(board.psq_score(), board.phase())};
+    return board.is_white_turn() ? score : -score;
+}
@@ -0,0 +1,9 @@
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include "chess/board.h"
+
+// Static evaluation in centipawns from the side to move's point of view.
+int evaluate(const Board &board);
+
+#endif //EVALUATE_H
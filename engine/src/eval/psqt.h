@@ -0,0 +1,185 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+#include <array>
+
+#include "chess/bitboard.h"
+#include "chess/piece.h"
+
+// Material values in centipawns, indexed by PieceType.
+inline constexpr std::array<int, 7> PIECE_VALUE{0, 100, 320, 330, 500, 900, 0};
+
+namespace psqt {
+    // A middlegame and an endgame score, blended by the game phase.
+    struct Score {
+        int mg;
+        int eg;
+
+        constexpr Score &operator+=(const Score &other) {
+            mg += other.mg;
+            eg += other.eg;
+            return *this;
+        }
+
+        constexpr Score &operator-=(const Score &other) {
+            mg -= other.mg;
+            eg -= other.eg;
+            return *this;
+        }
+
+        constexpr bool operator==(const Score &other) const = default;
+    };
+
+    // Endgame material, indexed by PieceType. Pawns gain value as they get
+    // closer to promoting with fewer pieces left to stop them.
+    inline constexpr std::array<int, 7> ENDGAME_VALUE{0, 120, 300, 320, 520, 930, 0};
+
+    // Contribution of each piece type to the game phase, indexed by
+    // PieceType. The starting position has MAX_PHASE; bare kings and pawns
+    // have 0.
+    inline constexpr std::array<int, 7> PHASE_WEIGHT{0, 0, 1, 1, 2, 4, 0};
+    inline constexpr int MAX_PHASE{24};
+
+    using Table = std::array<int, NUM_SQUARES>;
+
+    // Tables are written as seen from white's side of the board, 8th rank
+    // first, so they read like a diagram. Pieces other than pawns and the
+    // king use the same table in both phases.
+    inline constexpr Table PAWN{
+        0, 0, 0, 0, 0, 0, 0, 0,
+        50, 50, 50, 50, 50, 50, 50, 50,
+        10, 10, 20, 30, 30, 20, 10, 10,
+        5, 5, 10, 25, 25, 10, 5, 5,
+        0, 0, 0, 20, 20, 0, 0, 0,
+        5, -5, -10, 0, 0, -10, -5, 5,
+        5, 10, 10, -20, -20, 10, 10, 5,
+        0, 0, 0, 0, 0, 0, 0, 0
+    };
+
+    inline constexpr Table KNIGHT{
+        -50, -40, -30, -30, -30, -30, -40, -50,
+        -40, -20, 0, 0, 0, 0, -20, -40,
+        -30, 0, 10, 15, 15, 10, 0, -30,
+        -30, 5, 15, 20, 20, 15, 5, -30,
+        -30, 0, 15, 20, 20, 15, 0, -30,
+        -30, 5, 10, 15, 15, 10, 5, -30,
+        -40, -20, 0, 5, 5, 0, -20, -40,
+        -50, -40, -30, -30, -30, -30, -40, -50
+    };
+
+    inline constexpr Table BISHOP{
+        -20, -10, -10, -10, -10, -10, -10, -20,
+        -10, 0, 0, 0, 0, 0, 0, -10,
+        -10, 0, 5, 10, 10, 5, 0, -10,
+        -10, 5, 5, 10, 10, 5, 5, -10,
+        -10, 0, 10, 10, 10, 10, 0, -10,
+        -10, 10, 10, 10, 10, 10, 10, -10,
+        -10, 5, 0, 0, 0, 0, 5, -10,
+        -20, -10, -10, -10, -10, -10, -10, -20
+    };
+
+    inline constexpr Table ROOK{
+        0, 0, 0, 0, 0, 0, 0, 0,
+        5, 10, 10, 10, 10, 10, 10, 5,
+        -5, 0, 0, 0, 0, 0, 0, -5,
+        -5, 0, 0, 0, 0, 0, 0, -5,
+        -5, 0, 0, 0, 0, 0, 0, -5,
+        -5, 0, 0, 0, 0, 0, 0, -5,
+        -5, 0, 0, 0, 0, 0, 0, -5,
+        0, 0, 0, 5, 5, 0, 0, 0
+    };
+
+    inline constexpr Table QUEEN{
+        -20, -10, -10, -5, -5, -10, -10, -20,
+        -10, 0, 0, 0, 0, 0, 0, -10,
+        -10, 0, 5, 5, 5, 5, 0, -10,
+        -5, 0, 5, 5, 5, 5, 0, -5,
+        0, 0, 5, 5, 5, 5, 0, -5,
+        -10, 5, 5, 5, 5, 5, 0, -10,
+        -10, 0, 5, 0, 0, 0, 0, -10,
+        -20, -10, -10, -5, -5, -10, -10, -20
+    };
+
+    // Passed pawns near promotion matter far more once pieces come off.
+    inline constexpr Table PAWN_ENDGAME{
+        0, 0, 0, 0, 0, 0, 0, 0,
+        80, 80, 80, 80, 80, 80, 80, 80,
+        50, 50, 50, 50, 50, 50, 50, 50,
+        30, 30, 30, 30, 30, 30, 30, 30,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        5, 5, 5, 5, 5, 5, 5, 5,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0
+    };
+
+    inline constexpr Table KING{
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -20, -30, -30, -40, -40, -30, -30, -20,
+        -10, -20, -20, -20, -20, -20, -20, -10,
+        20, 20, 0, 0, 0, 0, 20, 20,
+        20, 30, 10, 0, 0, 10, 30, 20
+    };
+
+    // Without attackers left, the king belongs in the center.
+    inline constexpr Table KING_ENDGAME{
+        -50, -40, -30, -20, -20, -30, -40, -50,
+        -30, -20, -10, 0, 0, -10, -20, -30,
+        -30, -10, 20, 30, 30, 20, -10, -30,
+        -30, -10, 30, 40, 40, 30, -10, -30,
+        -30, -10, 30, 40, 40, 30, -10, -30,
+        -30, -10, 20, 30, 30, 20, -10, -30,
+        -30, -30, 0, 0, 0, 0, -30, -30,
+        -50, -30, -30, -30, -30, -30, -30, -50
+    };
+
+    inline constexpr std::array<const Table *, 7> TABLES{
+        nullptr, &PAWN, &KNIGHT, &BISHOP, &ROOK, &QUEEN, &KING
+    };
+
+    inline constexpr std::array<const Table *, 7> ENDGAME_TABLES{
+        nullptr, &PAWN_ENDGAME, &KNIGHT, &BISHOP, &ROOK, &QUEEN, &KING_ENDGAME
+    };
+
+    // Material plus square bonus of a piece in both phases, from white's
+    // point of view.
+    constexpr Score value(const Piece &piece, const int sq) {
+        const int type{static_cast<int>(piece.type)};
+        // Table index of the square as seen by the piece's own side.
+        const int index{piece.isWhite ? sq ^ 56 : sq};
+        const Score score{
+            PIECE_VALUE[type] + (*TABLES[type])[index],
+            ENDGAME_VALUE[type] + (*ENDGAME_TABLES[type])[index]
+        };
+        return piece.isWhite ? score : Score{-score.mg, -score.eg};
+    }
+
+    // value() for every piece and square, indexed by piece_index(), so that
+    // boards can update their score with a single lookup.
+    inline constexpr std::array<std::array<Score, NUM_SQUARES>, NUM_PIECE_BBS> SCORES{
+        [] {
+            std::array<std::array<Score, NUM_SQUARES>, NUM_PIECE_BBS> scores{};
+            for (const bool white: {true, false}) {
+                for (int type = 1; type <= 6; ++type) {
+                    const Piece piece{static_cast<PieceType>(type), white};
+                    for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+                        scores[piece_index(piece)][sq] = value(piece, sq);
+                    }
+                }
+            }
+            return scores;
+        }()
+    };
+
+    // Blends a score by the game phase, clamped because promotions can
+    // push the phase past MAX_PHASE.
+    constexpr int taper(const Score &score, const int phase) {
+        const int mg_phase{phase < MAX_PHASE ? phase : MAX_PHASE};
+        return (score.mg * mg_phase + score.eg * (MAX_PHASE - mg_phase)) /
+               MAX_PHASE;
+    }
+}
+
+#endif //PSQT_H
@@ -0,0 +1,37 @@
+#ifndef FEATURES_H
+#define FEATURES_H
+
+#include <cstddef>
+
+#include "chess/bitboard.h"
+#include "chess/piece.h"
+
+// HalfKA: every (king square, piece, square) triple of one side's point of
+// view is an input, kings included. Each side has its own accumulator, so
+// a move only changes a handful of inputs unless it moves that side's king.
+namespace nnue {
+    constexpr int NUM_FEATURES{NUM_SQUARES * NUM_PIECE_BBS * NUM_SQUARES};
+    constexpr int HIDDEN_SIZE{256};
+    // Fixed-point scales of the quantized accumulator and output weights.
+    // Hidden activations are clipped to [0, QA].
+    constexpr int QA{255};
+    constexpr int QB{64};
+    // Most inputs a single move changes in one accumulator: a castling
+    // move, or a capture that promotes.
+    constexpr std::size_t MAX_CHANGED{4};
+
+    // Input index of a piece on `sq` from the point of view of the side
+    // whose king stands on `king_sq`. Black sees the board flipped, with
+    // its own pieces first, so that both sides share one set of weights.
+    constexpr int feature_index(const bool &perspective, const int &king_sq,
+                                const Piece &piece, const int &sq) {
+        const int flip{perspective ? 0 : 56};
+        const int piece_idx{
+            (piece.isWhite == perspective ? 0 : 6) + static_cast<int>(piece.type) - 1
+        };
+        return ((king_sq ^ flip) * NUM_PIECE_BBS + piece_idx) * NUM_SQUARES +
+               (sq ^ flip);
+    }
+}
+
+#endif //FEATURES_H
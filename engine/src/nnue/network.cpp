@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "network.h"
+#include "simd.h"
+
+namespace nnue {
+    namespace {
+        constexpr std::array<char, 8> MAGIC{'C', 'A', 'N', 'N', 'U', 'E', '\0', '\0'};
+
+        constexpr std::size_t FEATURE_WEIGHTS_SIZE{
+            static_cast<std::size_t>(NUM_FEATURES) * HIDDEN_SIZE
+        };
+        constexpr std::size_t FILE_SIZE{
+            HEADER_SIZE +
+            (FEATURE_WEIGHTS_SIZE + HIDDEN_SIZE + 2 * HIDDEN_SIZE) * sizeof(int16_t) +
+            sizeof(int32_t)
+        };
+
+        uint32_t read_le32(const std::byte *data) {
+            uint32_t value{0};
+            for (int i = 0; i < 4; ++i) {
+                value |= static_cast<uint32_t>(data[i]) << (8 * i);
+            }
+            return value;
+        }
+
+        // Squares whose inputs a move turns on and off, for one point of view.
+        struct Changes {
+            std::array<std::pair<Piece, int>, MAX_CHANGED> added;
+            std::array<std::pair<Piece, int>, MAX_CHANGED> removed;
+            std::size_t added_count{0};
+            std::size_t removed_count{0};
+
+            void add(const Piece &piece, const int &sq) {
+                added[added_count++] = {piece, sq};
+            }
+
+            void remove(const Piece &piece, const int &sq) {
+                removed[removed_count++] = {piece, sq};
+            }
+        };
+
+        Changes changes_of(const UndoInfo &undo) {
+            Changes changes{};
+            const Move &move{undo.move};
+            if (move.is_none()) {
+                return changes;
+            }
+            const int from{move.from()};
+            const int to{move.to()};
+            const bool us{undo.moved.isWhite};
+
+            changes.remove(undo.moved, from);
+            changes.add(move.flag() == MoveFlag::PROMOTION
+                            ? Piece{move.promotion(), us}
+                            : undo.moved, to);
+            if (!undo.captured.is_empty()) {
+                changes.remove(undo.captured, move.flag() == MoveFlag::EN_PASSANT
+                                                  ? (us ? to - 8 : to + 8)
+                                                  : to);
+            }
+            if (move.flag() == MoveFlag::CASTLING) {
+                // Matches the rook squares of Board::make_move().
+                const bool king_side{to > from};
+                const Piece rook{PieceType::ROOK, us};
+                changes.remove(rook, king_side ? from + 3 : from - 4);
+                changes.add(rook, king_side ? from + 1 : from - 1);
+            }
+            return changes;
+        }
+
+        // Key of the position after `ply` moves of the board's history.
+        uint64_t key_at(const Board &board, const std::size_t &ply) {
+            const std::span<const UndoInfo> history{board.history()};
+            return ply < history.size() ? history[ply].key : board.key();
+        }
+    }
+
+    void AccumulatorStack::clear() {
+        for (Accumulator &entry: entries) {
+            entry.computed = {};
+        }
+    }
+
+    Accumulator &AccumulatorStack::at(const std::size_t &ply) {
+        if (ply >= entries.size()) {
+            // Grows in steps, so that a game's worth of moves only
+            // reallocates a few times.
+            entries.resize(std::max<std::size_t>(ply + 1, entries.size() * 2));
+        }
+        return entries[ply];
+    }
+
+    Network::Network(const std::string &path) : file{path} {
+        const std::string error_msg{"Invalid network file " + path};
+        const std::byte *data{file.data()};
+        if (file.size() != FILE_SIZE ||
+            std::memcmp(data, MAGIC.data(), MAGIC.size()) != 0 ||
+            read_le32(data + 8) != VERSION ||
+            read_le32(data + 12) != static_cast<uint32_t>(NUM_FEATURES) ||
+            read_le32(data + 16) != static_cast<uint32_t>(HIDDEN_SIZE)) {
+            throw std::invalid_argument(error_msg);
+        }
+        output_scale = static_cast<int32_t>(read_le32(data + 20));
+        if (output_scale <= 0) {
+            throw std::invalid_argument(error_msg);
+        }
+
+        // The weights are read in place; the mapping is page aligned and
+        // the header keeps every row 64-byte aligned after it.
+        const auto *weights{reinterpret_cast<const int16_t *>(data + HEADER_SIZE)};
+        feature_weights = weights;
+        feature_biases = feature_weights + FEATURE_WEIGHTS_SIZE;
+        output_weights = feature_biases + HIDDEN_SIZE;
+        output_bias = static_cast<int32_t>(read_le32(
+            reinterpret_cast<const std::byte *>(output_weights + 2 * HIDDEN_SIZE)));
+    }
+
+    int Network::evaluate(const Board &board, AccumulatorStack &stack) const {
+        update(board, stack, true);
+        update(board, stack, false);
+
+        const Accumulator &accumulator{stack.at(board.history().size())};
+        const bool us{board.is_white_turn()};
+        const int32_t output{
+            simd::kernels().output(accumulator.values[color_index(us)].data(),
+                                   accumulator.values[color_index(!us)].data(),
+                                   output_weights) + output_bias
+        };
+        return static_cast<int>(static_cast<int64_t>(output) * output_scale / (QA * QB));
+    }
+
+    int Network::scale() const {
+        return output_scale;
+    }
+
+    void Network::update(const Board &board, AccumulatorStack &stack,
+                         const bool &perspective) const {
+        const std::span<const UndoInfo> history{board.history()};
+        const std::size_t current{history.size()};
+        const int side{color_index(perspective)};
+
+        // Walk back to the nearest entry computed for this line. A move of
+        // this side's king changes every input, so the search stops there.
+        std::size_t base{current};
+        bool found{false};
+        while (true) {
+            const Accumulator &entry{stack.at(base)};
+            if (entry.computed[side] && entry.keys[side] == key_at(board, base)) {
+                found = true;
+                break;
+            }
+            if (base == 0) {
+                break;
+            }
+            const Piece &moved{history[base - 1].moved};
+            if (moved.type == PieceType::KING && moved.isWhite == perspective) {
+                break;
+            }
+            --base;
+        }
+
+        if (!found) {
+            Accumulator &entry{stack.at(current)};
+            refresh(board, entry, perspective);
+            entry.keys[side] = board.key();
+            entry.computed[side] = true;
+            return;
+        }
+
+        // The king has not moved since `base`, so its current square holds
+        // for every position in between.
+        const int king_sq{board.king_square(perspective)};
+        for (std::size_t ply = base + 1; ply <= current; ++ply) {
+            const Changes changes{changes_of(history[ply - 1])};
+            std::array<const int16_t *, MAX_CHANGED> added{};
+            std::array<const int16_t *, MAX_CHANGED> removed{};
+            for (std::size_t i = 0; i < changes.added_count; ++i) {
+                const auto &[piece, sq]{changes.added[i]};
+                added[i] = feature_row(feature_index(perspective, king_sq, piece, sq));
+            }
+            for (std::size_t i = 0; i < changes.removed_count; ++i) {
+                const auto &[piece, sq]{changes.removed[i]};
+                removed[i] = feature_row(feature_index(perspective, king_sq, piece, sq));
+            }
+
+            Accumulator &entry{stack.at(ply)};
+            const Accumulator &previous{stack.at(ply - 1)};
+            simd::kernels().update(entry.values[side].data(), previous.values[side].data(),
+                                   added.data(), changes.added_count,
+                                   removed.data(), changes.removed_count);
+            entry.keys[side] = key_at(board, ply);
+            entry.computed[side] = true;
+        }
+    }
+
+    void Network::refresh(const Board &board, Accumulator &accumulator,
+                          const bool &perspective) const {
+        const int king_sq{board.king_square(perspective)};
+        const int side{color_index(perspective)};
+        int16_t *values{accumulator.values[side].data()};
+
+        // Rows are added a few at a time so that the accumulator stays in
+        // registers for each batch.
+        constexpr std::size_t BATCH{8};
+        std::array<const int16_t *, BATCH> rows{};
+        std::size_t count{0};
+        const int16_t *source{feature_biases};
+        Bitboard occupied{board.occupancy()};
+        while (occupied) {
+            const int sq{pop_lsb(occupied)};
+            rows[count++] = feature_row(
+                feature_index(perspective, king_sq, board.piece_on(sq), sq));
+            if (count == BATCH || !occupied) {
+                simd::kernels().update(values, source, rows.data(), count, nullptr, 0);
+                source = values;
+                count = 0;
+            }
+        }
+        if (source == feature_biases) {
+            std::memcpy(values, feature_biases, HIDDEN_SIZE * sizeof(int16_t));
+        }
+    }
+
+    const int16_t *Network::feature_row(const int &feature) const {
+        return feature_weights + static_cast<std::size_t>(feature) * HIDDEN_SIZE;
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chess/board.h"
+#include "features.h"
+#include "util/mapped_file.h"
+
+// File layout, all little-endian:
+//   bytes 0-7    magic "CANNUE\0\0"
+//   bytes 8-11   format version (1)
+//   bytes 12-15  number of inputs (NUM_FEATURES)
+//   bytes 16-19  hidden size (HIDDEN_SIZE)
+//   bytes 20-23  output scale: centipawns per unit of the raw output
+//   bytes 24-63  zero
+// followed by int16 feature weights [NUM_FEATURES][HIDDEN_SIZE], int16
+// feature biases [HIDDEN_SIZE], int16 output weights [2 * HIDDEN_SIZE]
+// (side to move first) and an int32 output bias in units of QA * QB. This
+// is the raw quantized layout common trainers export, behind a header.
+namespace nnue {
+    constexpr std::size_t HEADER_SIZE{64};
+    constexpr uint32_t VERSION{1};
+
+    // Both halves of the hidden layer for one position, indexed by
+    // color_index() of the side whose point of view they hold.
+    struct Accumulator {
+        alignas(64) std::array<std::array<int16_t, HIDDEN_SIZE>, NUM_COLORS> values;
+        // Key of the position each half was computed for, if computed.
+        std::array<uint64_t, NUM_COLORS> keys;
+        std::array<bool, NUM_COLORS> computed;
+    };
+
+    // Accumulators along the current line, indexed by the number of moves
+    // in the board's history. Entries are computed lazily on evaluation
+    // from the nearest computed ancestor, so a move that is searched but
+    // never evaluated costs nothing. One stack per searching thread.
+    class AccumulatorStack {
+    public:
+        // Forgets every computed entry, e.g. when the network changes.
+        void clear();
+
+    private:
+        friend class Network;
+
+        // Entry for the position after `ply` moves, growing the stack as
+        // needed.
+        Accumulator &at(const std::size_t &ply);
+
+        std::vector<Accumulator> entries{};
+    };
+
+    // A HalfKA network: a feature transformer into two HIDDEN_SIZE
+    // accumulators, then a clipped ReLU and a single output neuron. The
+    // weights are used in place from the mapped file.
+    class Network {
+    public:
+        // Throws std::invalid_argument if the file cannot be mapped or is
+        // not a network of this architecture.
+        explicit Network(const std::string &path);
+
+        // Evaluation in centipawns from the side to move's point of view.
+        // Updates the stack for the board's current line.
+        int evaluate(const Board &board, AccumulatorStack &stack) const;
+
+        // Centipawns per unit of raw output.
+        [[nodiscard]] int scale() const;
+
+    private:
+        // Brings one half of the entry for the current position up to date.
+        void update(const Board &board, AccumulatorStack &stack,
+                    const bool &perspective) const;
+
+        // Computes one half from scratch.
+        void refresh(const Board &board, Accumulator &accumulator,
+                     const bool &perspective) const;
+
+        [[nodiscard]] const int16_t *feature_row(const int &feature) const;
+
+        MappedFile file;
+        const int16_t *feature_weights{nullptr};
+        const int16_t *feature_biases{nullptr};
+        const int16_t *output_weights{nullptr};
+        int32_t output_bias{0};
+        int output_scale{0};
+    };
+}
+
+#endif //NETWORK_H
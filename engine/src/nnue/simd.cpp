@@ -0,0 +1,241 @@
+#include <algorithm>
+
+#include "features.h"
+#include "simd.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define NNUE_X86_DISPATCH
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace nnue::simd {
+    namespace {
+        // ---------------------- Portable ----------------------
+
+        void update_scalar(int16_t *out, const int16_t *in,
+                           const int16_t *const *added, const std::size_t added_count,
+                           const int16_t *const *removed, const std::size_t removed_count) {
+            for (int i = 0; i < HIDDEN_SIZE; ++i) {
+                int value{in[i]};
+                for (std::size_t a = 0; a < added_count; ++a) {
+                    value += added[a][i];
+                }
+                for (std::size_t r = 0; r < removed_count; ++r) {
+                    value -= removed[r][i];
+                }
+                out[i] = static_cast<int16_t>(value);
+            }
+        }
+
+        int32_t output_scalar(const int16_t *us, const int16_t *them,
+                              const int16_t *weights) {
+            int32_t sum{0};
+            for (int i = 0; i < HIDDEN_SIZE; ++i) {
+                sum += std::clamp<int32_t>(us[i], 0, QA) * weights[i];
+                sum += std::clamp<int32_t>(them[i], 0, QA) * weights[HIDDEN_SIZE + i];
+            }
+            return sum;
+        }
+
+#ifdef NNUE_X86_DISPATCH
+        // ---------------------- AVX2 ----------------------
+
+        // 256 values fill 16 registers, so a whole accumulator stays in
+        // registers while all the rows are added.
+        constexpr int AVX2_LANES{16};
+        constexpr int AVX2_REGISTERS{HIDDEN_SIZE / AVX2_LANES};
+
+        __attribute__((target("avx2")))
+        void update_avx2(int16_t *out, const int16_t *in,
+                         const int16_t *const *added, const std::size_t added_count,
+                         const int16_t *const *removed, const std::size_t removed_count) {
+            __m256i acc[AVX2_REGISTERS];
+            for (int j = 0; j < AVX2_REGISTERS; ++j) {
+                acc[j] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in) + j);
+            }
+            for (std::size_t a = 0; a < added_count; ++a) {
+                const auto *row{reinterpret_cast<const __m256i *>(added[a])};
+                for (int j = 0; j < AVX2_REGISTERS; ++j) {
+                    acc[j] = _mm256_add_epi16(acc[j], _mm256_loadu_si256(row + j));
+                }
+            }
+            for (std::size_t r = 0; r < removed_count; ++r) {
+                const auto *row{reinterpret_cast<const __m256i *>(removed[r])};
+                for (int j = 0; j < AVX2_REGISTERS; ++j) {
+                    acc[j] = _mm256_sub_epi16(acc[j], _mm256_loadu_si256(row + j));
+                }
+            }
+            for (int j = 0; j < AVX2_REGISTERS; ++j) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out) + j, acc[j]);
+            }
+        }
+
+        __attribute__((target("avx2")))
+        __m256i dot_avx2(__m256i sum, const int16_t *values, const int16_t *weights) {
+            const __m256i zero{_mm256_setzero_si256()};
+            const __m256i max{_mm256_set1_epi16(QA)};
+            for (int i = 0; i < HIDDEN_SIZE; i += AVX2_LANES) {
+                const __m256i v{
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i))
+                };
+                const __m256i w{
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i))
+                };
+                const __m256i clipped{_mm256_min_epi16(_mm256_max_epi16(v, zero), max)};
+                // Multiplies pairs of int16 and adds each pair into an int32.
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(clipped, w));
+            }
+            return sum;
+        }
+
+        __attribute__((target("avx2")))
+        int32_t output_avx2(const int16_t *us, const int16_t *them,
+                            const int16_t *weights) {
+            __m256i sum{_mm256_setzero_si256()};
+            sum = dot_avx2(sum, us, weights);
+            sum = dot_avx2(sum, them, weights + HIDDEN_SIZE);
+            const __m128i half{
+                _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1))
+            };
+            const __m128i quarter{_mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E))};
+            return _mm_cvtsi128_si32(_mm_add_epi32(quarter, _mm_shuffle_epi32(quarter, 0xB1)));
+        }
+
+        // ---------------------- AVX-512 ----------------------
+
+        constexpr int AVX512_LANES{32};
+        constexpr int AVX512_REGISTERS{HIDDEN_SIZE / AVX512_LANES};
+
+        __attribute__((target("avx512f,avx512bw")))
+        void update_avx512(int16_t *out, const int16_t *in,
+                           const int16_t *const *added, const std::size_t added_count,
+                           const int16_t *const *removed, const std::size_t removed_count) {
+            __m512i acc[AVX512_REGISTERS];
+            for (int j = 0; j < AVX512_REGISTERS; ++j) {
+                acc[j] = _mm512_loadu_si512(in + j * AVX512_LANES);
+            }
+            for (std::size_t a = 0; a < added_count; ++a) {
+                for (int j = 0; j < AVX512_REGISTERS; ++j) {
+                    acc[j] = _mm512_add_epi16(
+                        acc[j], _mm512_loadu_si512(added[a] + j * AVX512_LANES));
+                }
+            }
+            for (std::size_t r = 0; r < removed_count; ++r) {
+                for (int j = 0; j < AVX512_REGISTERS; ++j) {
+                    acc[j] = _mm512_sub_epi16(
+                        acc[j], _mm512_loadu_si512(removed[r] + j * AVX512_LANES));
+                }
+            }
+            for (int j = 0; j < AVX512_REGISTERS; ++j) {
+                _mm512_storeu_si512(out + j * AVX512_LANES, acc[j]);
+            }
+        }
+
+        __attribute__((target("avx512f,avx512bw")))
+        __m512i dot_avx512(__m512i sum, const int16_t *values, const int16_t *weights) {
+            const __m512i zero{_mm512_setzero_si512()};
+            const __m512i max{_mm512_set1_epi16(QA)};
+            for (int i = 0; i < HIDDEN_SIZE; i += AVX512_LANES) {
+                const __m512i v{_mm512_loadu_si512(values + i)};
+                const __m512i w{_mm512_loadu_si512(weights + i)};
+                const __m512i clipped{_mm512_min_epi16(_mm512_max_epi16(v, zero), max)};
+                sum = _mm512_add_epi32(sum, _mm512_madd_epi16(clipped, w));
+            }
+            return sum;
+        }
+
+        __attribute__((target("avx512f,avx512bw")))
+        int32_t output_avx512(const int16_t *us, const int16_t *them,
+                              const int16_t *weights) {
+            __m512i sum{_mm512_setzero_si512()};
+            sum = dot_avx512(sum, us, weights);
+            sum = dot_avx512(sum, them, weights + HIDDEN_SIZE);
+            // Runs once per evaluation, so a plain horizontal sum will do.
+            alignas(64) int32_t lanes[16];
+            _mm512_store_si512(lanes, sum);
+            int32_t total{0};
+            for (const int32_t lane: lanes) {
+                total += lane;
+            }
+            return total;
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        // ---------------------- NEON ----------------------
+
+        // NEON is part of every AArch64 CPU, so it needs no runtime check.
+        // 32 registers of 8 values: half an accumulator at a time.
+        constexpr int NEON_LANES{8};
+        constexpr int NEON_REGISTERS{16};
+
+        void update_neon(int16_t *out, const int16_t *in,
+                         const int16_t *const *added, const std::size_t added_count,
+                         const int16_t *const *removed, const std::size_t removed_count) {
+            for (int block = 0; block < HIDDEN_SIZE; block += NEON_LANES * NEON_REGISTERS) {
+                int16x8_t acc[NEON_REGISTERS];
+                for (int j = 0; j < NEON_REGISTERS; ++j) {
+                    acc[j] = vld1q_s16(in + block + j * NEON_LANES);
+                }
+                for (std::size_t a = 0; a < added_count; ++a) {
+                    for (int j = 0; j < NEON_REGISTERS; ++j) {
+                        acc[j] = vaddq_s16(acc[j], vld1q_s16(added[a] + block + j * NEON_LANES));
+                    }
+                }
+                for (std::size_t r = 0; r < removed_count; ++r) {
+                    for (int j = 0; j < NEON_REGISTERS; ++j) {
+                        acc[j] = vsubq_s16(acc[j], vld1q_s16(removed[r] + block + j * NEON_LANES));
+                    }
+                }
+                for (int j = 0; j < NEON_REGISTERS; ++j) {
+                    vst1q_s16(out + block + j * NEON_LANES, acc[j]);
+                }
+            }
+        }
+
+        int32x4_t dot_neon(int32x4_t sum, const int16_t *values, const int16_t *weights) {
+            const int16x8_t zero{vdupq_n_s16(0)};
+            const int16x8_t max{vdupq_n_s16(QA)};
+            for (int i = 0; i < HIDDEN_SIZE; i += NEON_LANES) {
+                const int16x8_t clipped{vminq_s16(vmaxq_s16(vld1q_s16(values + i), zero), max)};
+                const int16x8_t w{vld1q_s16(weights + i)};
+                sum = vmlal_s16(sum, vget_low_s16(clipped), vget_low_s16(w));
+                sum = vmlal_high_s16(sum, clipped, w);
+            }
+            return sum;
+        }
+
+        int32_t output_neon(const int16_t *us, const int16_t *them,
+                            const int16_t *weights) {
+            int32x4_t sum{vdupq_n_s32(0)};
+            sum = dot_neon(sum, us, weights);
+            sum = dot_neon(sum, them, weights + HIDDEN_SIZE);
+            return vaddvq_s32(sum);
+        }
+#endif
+
+        const Kernels &select() {
+            static constexpr Kernels SCALAR{"scalar", update_scalar, output_scalar};
+#ifdef NNUE_X86_DISPATCH
+            static constexpr Kernels AVX2{"avx2", update_avx2, output_avx2};
+            static constexpr Kernels AVX512{"avx512", update_avx512, output_avx512};
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+                return AVX512;
+            }
+            if (__builtin_cpu_supports("avx2")) {
+                return AVX2;
+            }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+            static constexpr Kernels NEON{"neon", update_neon, output_neon};
+            return NEON;
+#endif
+            return SCALAR;
+        }
+    }
+
+    const Kernels &kernels() {
+        static const Kernels &selected{select()};
+        return selected;
+    }
+}
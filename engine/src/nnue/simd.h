@@ -0,0 +1,30 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized kernels of the network, one set per instruction set. The set
+// is picked once at runtime from what the CPU supports, so a single build
+// runs everywhere and still uses the widest vectors available.
+namespace nnue::simd {
+    struct Kernels {
+        const char *name;
+
+        // out = in + sum(added) - sum(removed) over HIDDEN_SIZE values, with
+        // int16 wrap-around. `out` may alias `in`.
+        void (*update)(int16_t *out, const int16_t *in,
+                       const int16_t *const *added, std::size_t added_count,
+                       const int16_t *const *removed, std::size_t removed_count);
+
+        // Dot product of both accumulators, clipped to [0, QA], with the
+        // 2 * HIDDEN_SIZE output weights: the side to move's half first.
+        int32_t (*output)(const int16_t *us, const int16_t *them,
+                          const int16_t *weights);
+    };
+
+    // The fastest kernels this CPU supports.
+    const Kernels &kernels();
+}
+
+#endif //SIMD_H
@@ -0,0 +1,553 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine/engine_api.h"
+#include "chess/board.h"
+#include "book/polyglot.h"
+#include "chess/perft.h"
+#include "data/position_db.h"
+
+namespace {
+    constexpr auto START_FEN{
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+    };
+
+    struct SuiteEntry {
+        const char *name;
+        const char *fen;
+        int depth;
+        uint64_t nodes;
+    };
+
+    // Standard perft positions, together covering castling, en passant,
+    // promotions, pins and checks.
+    constexpr std::array<SuiteEntry, 6> SUITE{
+        {
+            {"startpos", START_FEN, 6, 119060324},
+            {
+                "kiwipete",
+                "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                5, 193690690
+            },
+            {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 7, 178633661},
+            {
+                "position4",
+                "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                5, 15833292
+            },
+            {
+                "position5",
+                "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                5, 89941194
+            },
+            {
+                "position6",
+                "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+                5, 164075551
+            }
+        }
+    };
+
+    // Positions for the raw move generator check, where the side not to
+    // move can promote, castle, has a pinned piece or a pawn next to the en
+    // passant square.
+    constexpr std::array<const char *, 6> RAW_POSITIONS{
+        "4k3/8/8/8/8/8/1p6/4K3 w - - 0 1",
+        "4k3/2p5/8/3pP3/8/8/8/4K3 w - d6 0 2",
+        "4k3/8/8/8/3Pp3/8/2P5/4K3 b - d3 0 1",
+        "r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1",
+        "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+        "4k3/4r3/8/8/8/8/4B3/4K3 b - - 0 1"
+    };
+
+    using RawMoves = std::map<std::pair<int, int>, std::vector<std::pair<int, int> > >;
+
+    // Validated raw moves of one side's pieces, sorted for comparison.
+    RawMoves raw_moves(Board &board, const bool &white) {
+        RawMoves moves{};
+        for (auto &[pos, entry]: board.get_all_valid_moves_raw(false, true)) {
+            if (entry.first.isWhite == white) {
+                std::ranges::sort(entry.second);
+                moves[pos] = entry.second;
+            }
+        }
+        return moves;
+    }
+
+    // Checks that get_all_valid_moves_raw() leaves the position as it was,
+    // and that the moves it gives the side not to move are those that side
+    // would have if it were its turn.
+    bool check_raw_moves(const std::string &fen) {
+        Board board{fen};
+        const std::string before{board.fen()};
+        static_cast<void>(board.get_all_valid_moves_raw(true, true));
+        RawMoves opponent{raw_moves(board, !board.is_white_turn())};
+        if (board.fen() != before) {
+            std::cout << "[FAIL] raw moves changed " << before << " to "
+                    << board.fen() << '\n';
+            return false;
+        }
+        // With the side to move in check, handing the turn over is illegal.
+        if (board.checkers()) {
+            return true;
+        }
+
+        std::istringstream fields{before};
+        std::string placement{}, side{}, castling{}, en_passant{};
+        fields >> placement >> side >> castling >> en_passant;
+        Board flipped{
+            placement + (side == "w" ? " b " : " w ") + castling + " - 0 1"
+        };
+        if (raw_moves(flipped, flipped.is_white_turn()) != opponent) {
+            std::cout << "[FAIL] raw moves of the side not to move in "
+                    << before << '\n';
+            return false;
+        }
+        return true;
+    }
+
+    struct KeyEntry {
+        const char *fen;
+        uint64_t key;
+    };
+
+    // The test positions and keys published with the Polyglot book format.
+    constexpr std::array<KeyEntry, 9> POLYGLOT_KEYS{{
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463B96181691FC9CULL},
+        {"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823C9B50FD114196ULL},
+        {"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756B94461C50FB0ULL},
+        {"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662FAFB965DB29D4ULL},
+        {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22A48B5A8E47FF78ULL},
+        {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652A607CA3F242C1ULL},
+        {"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00FDD303C946BDD9ULL},
+        {"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3C8123EA7B067637ULL},
+        {"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5C3F9B829B279560ULL}
+    }};
+
+    bool check_polyglot_keys() {
+        bool passed{true};
+        for (const auto &[fen, expected]: POLYGLOT_KEYS) {
+            if (const uint64_t key{polyglot_key(Board{fen})}; key != expected) {
+                std::cout << "[FAIL] polyglot key " << std::hex << key
+                        << " (expected " << expected << std::dec << ") in "
+                        << fen << '\n';
+                passed = false;
+            }
+        }
+        return passed;
+    }
+
+    // Plays moves given in long algebraic notation.
+    void play(Board &board, const std::vector<std::string> &moves) {
+        for (const std::string &text: moves) {
+            MoveList legal;
+            board.generate_moves(legal);
+            const auto found{std::ranges::find_if(legal, [&](const Move &move) {
+                return move.to_string() == text;
+            })};
+            if (found == legal.end()) {
+                throw std::invalid_argument("Illegal move " + text);
+            }
+            board.make_move(*found);
+        }
+    }
+
+    // Checks is_repetition() on knight shuffles from the start position: a
+    // third occurrence in the game, a position first seen at the search
+    // root, which needs two more, and one first seen after the root, which
+    // needs only one.
+    bool check_repetitions() {
+        const std::vector<std::string> shuffle{"g1f3", "g8f6", "f3g1", "f6g8"};
+        struct Case {
+            const char *name;
+            int game_shuffles;
+            int search_shuffles;
+            // Checked after the shuffles and after one more knight move.
+            bool expected;
+            bool expected_after_move;
+        };
+        constexpr std::array<Case, 5> CASES{{
+            {"second occurrence in the game", 1, 0, false, false},
+            {"third occurrence in the game", 2, 0, true, true},
+            {"root seen again once in the search", 0, 1, false, true},
+            {"root seen again twice in the search", 0, 2, true, true},
+            {"root already repeated in the game", 1, 1, true, true}
+        }};
+
+        bool passed{true};
+        for (const auto &[name, game_shuffles, search_shuffles, expected,
+                 expected_after_move]: CASES) {
+            Board board{};
+            for (int i = 0; i < game_shuffles; ++i) {
+                play(board, shuffle);
+            }
+            const int root{static_cast<int>(board.history().size())};
+            for (int i = 0; i < search_shuffles; ++i) {
+                play(board, shuffle);
+            }
+            auto plies = [&] {
+                return static_cast<int>(board.history().size()) - root;
+            };
+            const bool repeated{board.is_repetition(plies())};
+            // One more g1f3 repeats the position after the first one.
+            play(board, {shuffle[0]});
+            const bool repeated_after_move{board.is_repetition(plies())};
+            if (repeated != expected || repeated_after_move != expected_after_move) {
+                std::cout << "[FAIL] repetition: " << name << '\n';
+                passed = false;
+            }
+        }
+        return passed;
+    }
+
+    // FENs set_fen() must reject: unknown castling letters, and en passant
+    // squares on the wrong rank or with no pawn that can just have passed.
+    constexpr std::array<const char *, 9> INVALID_FENS{
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQxq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w K- - 0 1",
+        "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d5 0 3",
+        "rnbqkbnr/ppp1pppp/8/4P3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3",
+        "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d3 0 3",
+        "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq e3 0 1",
+        "4k2R/8/8/8/8/8/8/4K3 w - - 0 1",
+        "P3k3/8/8/8/8/8/8/4K3 b - - 0 1",
+        "4k3/8/8/8/8/8/8/p3K3 w - - 0 1"
+    };
+
+    // Checks that the invalid FENs, and packed positions with the same en
+    // passant squares, side not to move in check or pawn on the 8th rank,
+    // are rejected, while the valid positions they are made from are not.
+    bool check_fen_validation() {
+        bool passed{true};
+        Board board{};
+        for (const char *fen: INVALID_FENS) {
+            if (board.set_fen(fen)) {
+                std::cout << "[FAIL] accepted invalid FEN " << fen << '\n';
+                passed = false;
+            }
+        }
+
+        const Board valid{"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3"};
+        PackedPosition packed{valid.pack()};
+        if (!board.unpack(packed) || board.fen() != valid.fen()) {
+            std::cout << "[FAIL] packed position " << valid.fen() << '\n';
+            passed = false;
+        }
+        // d5, d3 and e6 in place of d6.
+        for (const int sq: {35, 19, 44}) {
+            packed.bytes[25] = static_cast<uint8_t>(sq);
+            if (board.unpack(packed)) {
+                std::cout << "[FAIL] unpacked en passant square " << sq << '\n';
+                passed = false;
+            }
+        }
+
+        Board checked{"4k2R/8/8/8/8/8/8/4K3 b - - 0 1"};
+        packed = checked.pack();
+        if (!board.unpack(packed)) {
+            std::cout << "[FAIL] packed position " << checked.fen() << '\n';
+            passed = false;
+        }
+        // White to move, with the black king in check.
+        packed.bytes[24] ^= 1;
+        if (board.unpack(packed)) {
+            std::cout << "[FAIL] unpacked a capturable king\n";
+            passed = false;
+        }
+        checked.set_piece({0, 0}, Piece{PieceType::PAWN, true});
+        if (board.unpack(checked.pack())) {
+            std::cout << "[FAIL] unpacked a pawn on the 8th rank\n";
+            passed = false;
+        }
+        return passed;
+    }
+
+    // Checks that the C interface refuses a position whose side not to move
+    // is in check, singly and in batches, and keeps a usable board after.
+    bool check_c_api() {
+        constexpr auto ILLEGAL{"4k2R/8/8/8/8/8/8/4K3 w - - 0 1"};
+        bool passed{true};
+        EngineBoard *board{engine_board_new()};
+        std::array<uint16_t, ENGINE_MAX_MOVES> moves{};
+        if (board == nullptr || engine_board_set_fen(board, ILLEGAL) ||
+            engine_board_legal_moves(board, moves.data(), moves.size()) != 20) {
+            std::cout << "[FAIL] C interface accepted " << ILLEGAL << '\n';
+            passed = false;
+        }
+
+        // The same position with black to move is legal; white to move is
+        // bit 0 of byte 24 cleared.
+        std::array<uint8_t, ENGINE_PACKED_SIZE> packed{};
+        if (board == nullptr ||
+            !engine_board_set_fen(board, "4k2R/8/8/8/8/8/8/4K3 b - - 0 1")) {
+            std::cout << "[FAIL] C interface rejected a legal position\n";
+            passed = false;
+        } else {
+            engine_board_pack(board, packed.data());
+            packed[24] ^= 1;
+            uint64_t nodes{1};
+            engine_batch_perft(packed.data(), 1, 3, &nodes);
+            if (engine_board_unpack(board, packed.data()) || nodes != 0) {
+                std::cout << "[FAIL] C interface unpacked a capturable king\n";
+                passed = false;
+            }
+        }
+        engine_board_free(board);
+
+        const std::string fens{std::string{START_FEN} + '\n' + ILLEGAL + '\n' + START_FEN};
+        std::array<uint8_t, 3 * ENGINE_PACKED_SIZE> batch{};
+        if (engine_batch_pack_fens(fens.c_str(), batch.data(), 3) != 1) {
+            std::cout << "[FAIL] C interface packed " << ILLEGAL << '\n';
+            passed = false;
+        }
+        return passed;
+    }
+
+    // Writes the suite and raw move positions to a database, and checks that
+    // they load back in order and that a parallel scan visits each once.
+    // Where /dev/full exists, also checks that a write to a full disk is
+    // reported.
+    bool check_position_db() {
+        std::vector<std::string> fens{};
+        for (const auto &entry: SUITE) {
+            fens.push_back(Board{entry.fen}.fen());
+        }
+        for (const char *fen: RAW_POSITIONS) {
+            fens.push_back(Board{fen}.fen());
+        }
+
+        bool passed{true};
+        const std::filesystem::path path{
+            std::filesystem::temp_directory_path() / "engine_perft_positions.db"
+        };
+        {
+            PositionDbWriter writer{path.string()};
+            for (const std::string &fen: fens) {
+                passed &= writer.append(Board{fen});
+            }
+            passed &= writer.close();
+        }
+        if (!passed) {
+            std::cout << "[FAIL] writing " << path.string() << '\n';
+            return false;
+        }
+
+        try {
+            const PositionDb db{path.string()};
+            Board board{};
+            for (std::size_t i = 0; i < fens.size(); ++i) {
+                if (db.size() != fens.size() || !db.load(i, board) ||
+                    board.fen() != fens[i]) {
+                    std::cout << "[FAIL] record " << i << " of " << path.string() << '\n';
+                    passed = false;
+                    break;
+                }
+            }
+            // Each index is visited by a single thread, so the slots need no
+            // lock.
+            std::vector<std::string> scanned(fens.size());
+            std::vector<int> visits(fens.size());
+            db.scan(4, [&](const Board &position, const std::size_t &index) {
+                scanned[index] = position.fen();
+                ++visits[index];
+            });
+            if (scanned != fens || std::ranges::count(visits, 1) !=
+                static_cast<std::ptrdiff_t>(visits.size())) {
+                std::cout << "[FAIL] parallel scan of " << path.string() << '\n';
+                passed = false;
+            }
+        } catch (const std::invalid_argument &e) {
+            std::cout << "[FAIL] " << e.what() << '\n';
+            passed = false;
+        }
+        std::filesystem::remove(path);
+
+        if (std::filesystem::exists("/dev/full")) {
+            PositionDbWriter writer{"/dev/full"};
+            bool written{true};
+            for (const std::string &fen: fens) {
+                written &= writer.append(Board{fen});
+            }
+            if (writer.close() && written) {
+                std::cout << "[FAIL] write to a full disk reported success\n";
+                passed = false;
+            }
+        }
+        return passed;
+    }
+
+    struct Options {
+        std::vector<std::string> fens{};
+        int depth{5};
+        bool divide{false};
+        bool suite{false};
+        std::size_t hash_mb{0};
+        int threads{static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))};
+    };
+
+    void print_usage() {
+        std::cout
+                << "Usage: engine_perft [options]\n"
+                << "  --fen <FEN>      position to count (repeatable, default: start position)\n"
+                << "  --file <path>    read one FEN per line from a file\n"
+                << "  --depth <N>      search depth (default: 5)\n"
+                << "  --divide         print the node count below each root move\n"
+                << "  --hash <MB>      use a perft hash table of the given size\n"
+                << "  --threads <N>    split root moves across N threads\n"
+                << "  --suite          run the standard suite and check expected counts, then\n"
+                << "                   check the raw move generator, Polyglot keys,\n"
+                << "                   repetitions, FEN validation, the C interface and\n"
+                << "                   the position database on fixed positions\n";
+    }
+
+    Options parse_options(const int argc, char **argv) {
+        Options options{};
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg{argv[i]};
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--fen") {
+                options.fens.push_back(value());
+            } else if (arg == "--file") {
+                std::ifstream file{value()};
+                if (!file) {
+                    throw std::invalid_argument("Cannot open FEN file");
+                }
+                for (std::string line; std::getline(file, line);) {
+                    if (!line.empty()) {
+                        options.fens.push_back(line);
+                    }
+                }
+            } else if (arg == "--depth") {
+                options.depth = std::stoi(value());
+            } else if (arg == "--divide") {
+                options.divide = true;
+            } else if (arg == "--hash") {
+                options.hash_mb = std::stoul(value());
+            } else if (arg == "--threads") {
+                options.threads = std::max(1, std::stoi(value()));
+            } else if (arg == "--suite") {
+                options.suite = true;
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+        if (options.fens.empty()) {
+            options.fens.emplace_back(START_FEN);
+        }
+        return options;
+    }
+
+    void print_result(const PerftResult &result, const bool &divide) {
+        if (divide) {
+            for (const auto &[move, nodes]: result.divide) {
+                std::cout << move.to_string() << ": " << nodes << '\n';
+            }
+        }
+        std::cout << "nodes: " << result.nodes << "  time: " << result.seconds
+                << "s  nps: "
+                << static_cast<uint64_t>(result.nodes /
+                                         std::max(result.seconds, 1e-9))
+                << '\n';
+    }
+}
+
+int main(const int argc, char **argv) {
+    Options options{};
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<PerftTable> table{};
+    if (options.hash_mb > 0) {
+        table = std::make_unique<PerftTable>(options.hash_mb);
+    }
+
+    if (options.suite) {
+        bool passed{true};
+        uint64_t total_nodes{0};
+        double total_seconds{0};
+        for (const auto &[name, fen, depth, expected]: SUITE) {
+            const PerftResult result{
+                perft_divide(Board{fen}, depth, options.threads, table.get())
+            };
+            const bool ok{result.nodes == expected};
+            passed &= ok;
+            total_nodes += result.nodes;
+            total_seconds += result.seconds;
+            std::cout << (ok ? "[ OK ] " : "[FAIL] ") << name << " depth "
+                    << depth << ": " << result.nodes << " (expected "
+                    << expected << ")\n";
+        }
+        print_result(PerftResult{total_nodes, {}, total_seconds}, false);
+
+        bool raw_passed{true};
+        for (const auto &entry: SUITE) {
+            raw_passed &= check_raw_moves(entry.fen);
+        }
+        for (const char *fen: RAW_POSITIONS) {
+            raw_passed &= check_raw_moves(fen);
+        }
+        std::cout << (raw_passed ? "[ OK ] " : "[FAIL] ")
+                << "raw move generator on " << SUITE.size() + RAW_POSITIONS.size()
+                << " positions\n";
+
+        const bool keys_passed{check_polyglot_keys()};
+        std::cout << (keys_passed ? "[ OK ] " : "[FAIL] ") << "polyglot keys on "
+                << POLYGLOT_KEYS.size() << " positions\n";
+
+        const bool repetitions_passed{check_repetitions()};
+        std::cout << (repetitions_passed ? "[ OK ] " : "[FAIL] ")
+                << "repetition detection\n";
+
+        const bool fens_passed{check_fen_validation()};
+        std::cout << (fens_passed ? "[ OK ] " : "[FAIL] ") << "invalid FENs rejected on "
+                << INVALID_FENS.size() << " positions\n";
+
+        const bool api_passed{check_c_api()};
+        std::cout << (api_passed ? "[ OK ] " : "[FAIL] ")
+                << "C interface rejects illegal positions\n";
+
+        const bool db_passed{check_position_db()};
+        std::cout << (db_passed ? "[ OK ] " : "[FAIL] ")
+                << "position database round trip\n";
+        return passed && raw_passed && keys_passed && repetitions_passed &&
+               fens_passed && api_passed && db_passed
+                   ? EXIT_SUCCESS
+                   : EXIT_FAILURE;
+    }
+
+    for (const std::string &fen: options.fens) {
+        try {
+            const Board board{fen};
+            std::cout << "fen: " << fen << "  depth: " << options.depth << '\n';
+            print_result(perft_divide(board, options.depth, options.threads,
+                                      table.get()), options.divide);
+        } catch (const std::invalid_argument &e) {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+#include <utility>
+
+#include "eval/psqt.h"
+#include "move_picker.h"
+
+namespace {
+    bool is_capture(const Board &board, const Move &move) {
+        return move.flag() == MoveFlag::EN_PASSANT ||
+               !board.piece_on(move.to()).is_empty();
+    }
+
+    // Whether the move belongs to the GenType::CAPTURES set.
+    bool is_tactical(const Board &board, const Move &move) {
+        return is_capture(board, move) ||
+               (move.flag() == MoveFlag::PROMOTION &&
+                move.promotion() == PieceType::QUEEN);
+    }
+}
+
+MovePicker::MovePicker(const Board &board, const Move &tt_move,
+                       const std::array<Move, 2> &killers,
+                       const HistoryTable &history)
+    : board{board}, history{history}, tt_move{tt_move}, killers{killers},
+      quiescence{false}, in_check{board.checkers() != EMPTY_BB} {
+    // A killer pair may be unset, or hold one move twice; never return a
+    // move twice.
+    if (this->killers[1] == this->killers[0]) {
+        this->killers[1] = Move::none();
+    }
+}
+
+MovePicker::MovePicker(const Board &board, const Move &tt_move,
+                       const HistoryTable &history)
+    : board{board}, history{history}, tt_move{tt_move}, quiescence{true},
+      in_check{board.checkers() != EMPTY_BB} {
+    // Out of check, quiescence only searches captures.
+    if (!in_check && !is_tactical(board, tt_move)) {
+        this->tt_move = Move::none();
+    }
+}
+
+Move MovePicker::next() {
+    while (true) {
+        switch (stage) {
+            case Stage::TT_MOVE:
+                stage = in_check ? Stage::GENERATE_EVASIONS
+                                 : Stage::GENERATE_CAPTURES;
+                if (board.is_legal(tt_move)) {
+                    return tt_move;
+                }
+                tt_move = Move::none();
+                break;
+
+            case Stage::GENERATE_CAPTURES:
+                board.generate_moves<GenType::CAPTURES>(moves);
+                for (std::size_t i = 0; i < moves.size(); ++i) {
+                    scores[i] = capture_score(moves[i]);
+                }
+                current = 0;
+                stage = Stage::GOOD_CAPTURES;
+                break;
+
+            case Stage::GOOD_CAPTURES:
+                while (current < moves.size()) {
+                    const Move move{pick_best()};
+                    if (move == tt_move) {
+                        continue;
+                    }
+                    // Taking a valuable piece may cost a little material
+                    // and still be worth trying early.
+                    if (board.see_ge(move, -scores[current - 1] / 32)) {
+                        return move;
+                    }
+                    bad_captures.push_back(move);
+                }
+                stage = quiescence ? Stage::BAD_CAPTURES : Stage::KILLERS;
+                break;
+
+            case Stage::KILLERS:
+                while (killer_index < killers.size()) {
+                    const Move killer{killers[killer_index++]};
+                    // Killers are only ever quiet moves, but the one stored
+                    // here may come from another position.
+                    if (killer != tt_move && !is_tactical(board, killer) &&
+                        board.is_legal(killer)) {
+                        return killer;
+                    }
+                }
+                stage = Stage::GENERATE_QUIETS;
+                break;
+
+            case Stage::GENERATE_QUIETS:
+                board.generate_moves<GenType::QUIETS>(moves);
+                for (std::size_t i = 0; i < moves.size(); ++i) {
+                    scores[i] = quiet_score(moves[i]);
+                }
+                current = 0;
+                stage = Stage::QUIETS;
+                break;
+
+            case Stage::QUIETS:
+                while (current < moves.size()) {
+                    if (const Move move{pick_best()};
+                        move != tt_move && move != killers[0] &&
+                        move != killers[1]) {
+                        return move;
+                    }
+                }
+                stage = Stage::BAD_CAPTURES;
+                break;
+
+            case Stage::BAD_CAPTURES:
+                if (bad_current < bad_captures.size()) {
+                    return bad_captures[bad_current++];
+                }
+                stage = Stage::DONE;
+                break;
+
+            case Stage::GENERATE_EVASIONS:
+                board.generate_moves<GenType::EVASIONS>(moves);
+                for (std::size_t i = 0; i < moves.size(); ++i) {
+                    // Captures of the checker come before killers, and
+                    // killers before the other king moves and blocks.
+                    const Move &move{moves[i]};
+                    if (is_tactical(board, move)) {
+                        scores[i] = (1 << 28) + capture_score(move);
+                    } else if (move == killers[0]) {
+                        scores[i] = (1 << 27) + 1;
+                    } else if (move == killers[1]) {
+                        scores[i] = 1 << 27;
+                    } else {
+                        scores[i] = quiet_score(move);
+                    }
+                }
+                current = 0;
+                stage = Stage::EVASIONS;
+                break;
+
+            case Stage::EVASIONS:
+                while (current < moves.size()) {
+                    if (const Move move{pick_best()}; move != tt_move) {
+                        return move;
+                    }
+                }
+                stage = Stage::DONE;
+                break;
+
+            case Stage::DONE:
+                return Move::none();
+        }
+    }
+}
+
+int MovePicker::capture_score(const Move &move) const {
+    // MVV-LVA: most valuable victim first, then least valuable attacker.
+    const PieceType victim{
+        move.flag() == MoveFlag::EN_PASSANT
+            ? PieceType::PAWN
+            : board.piece_on(move.to()).type
+    };
+    const PieceType attacker{board.piece_on(move.from()).type};
+    int score{
+        PIECE_VALUE[static_cast<int>(victim)] * 8 - static_cast<int>(attacker)
+    };
+    if (move.flag() == MoveFlag::PROMOTION) {
+        score += PIECE_VALUE[static_cast<int>(move.promotion())];
+    }
+    return score;
+}
+
+int MovePicker::quiet_score(const Move &move) const {
+    return history[color_index(board.is_white_turn())][move.from()][move.to()];
+}
+
+Move MovePicker::pick_best() {
+    std::size_t best{current};
+    for (std::size_t j = current + 1; j < moves.size(); ++j) {
+        if (scores[j] > scores[best]) {
+            best = j;
+        }
+    }
+    std::swap(moves[current], moves[best]);
+    std::swap(scores[current], scores[best]);
+    return moves[current++];
+}
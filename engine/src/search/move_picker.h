@@ -0,0 +1,80 @@
+#ifndef MOVE_PICKER_H
+#define MOVE_PICKER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "chess/board.h"
+#include "chess/move.h"
+
+// Butterfly history of quiet moves, indexed by [color][from][to].
+using HistoryTable = std::array<std::array<std::array<int, NUM_SQUARES>,
+    NUM_SQUARES>, NUM_COLORS>;
+
+// Hands out the legal moves of a position one at a time, roughly best first.
+// Moves come in stages, and a stage is only generated once the ones before
+// it are exhausted, so a node that cuts off early skips most of the work:
+//
+//  1. the transposition table move, if legal;
+//  2. captures and queen promotions that do not lose much material (SEE),
+//     by MVV-LVA;
+//  3. the two killer moves, if legal and quiet;
+//  4. the remaining quiet moves, by history;
+//  5. the captures that lose material, in the order they were deferred.
+//
+// In check, the TT move is followed by every evasion, scored like the stages
+// above. The quiescence picker skips the quiet stages.
+class MovePicker {
+public:
+    // Picker for the main search.
+    MovePicker(const Board &board, const Move &tt_move,
+               const std::array<Move, 2> &killers,
+               const HistoryTable &history);
+
+    // Picker for quiescence search: captures, or every evasion in check.
+    MovePicker(const Board &board, const Move &tt_move,
+               const HistoryTable &history);
+
+    // The next move, or Move::none() once every move has been returned.
+    [[nodiscard]] Move next();
+
+private:
+    enum class Stage : uint8_t {
+        TT_MOVE,
+        GENERATE_CAPTURES,
+        GOOD_CAPTURES,
+        KILLERS,
+        GENERATE_QUIETS,
+        QUIETS,
+        BAD_CAPTURES,
+        GENERATE_EVASIONS,
+        EVASIONS,
+        DONE
+    };
+
+    [[nodiscard]] int capture_score(const Move &move) const;
+
+    [[nodiscard]] int quiet_score(const Move &move) const;
+
+    // Moves the highest-scored remaining move to the front of the
+    // unpicked ones and returns it.
+    Move pick_best();
+
+    const Board &board;
+    const HistoryTable &history;
+    Move tt_move;
+    std::array<Move, 2> killers{Move::none(), Move::none()};
+    bool quiescence;
+    bool in_check;
+    Stage stage{Stage::TT_MOVE};
+    std::size_t killer_index{0};
+
+    MoveList moves;
+    std::array<int, MoveList::CAPACITY> scores;
+    std::size_t current{0};
+    MoveList bad_captures;
+    std::size_t bad_current{0};
+};
+
+#endif //MOVE_PICKER_H
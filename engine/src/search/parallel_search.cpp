@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "parallel_search.h"
+
+ParallelSearch::ParallelSearch(TranspositionTable &tt, const int &threads)
+    : tt{tt} {
+    set_threads(threads);
+}
+
+ParallelSearch::~ParallelSearch() {
+    stop();
+    static_cast<void>(wait());
+}
+
+void ParallelSearch::set_threads(const int &threads) {
+    if (threads < 1) {
+        const std::string error_msg{
+            "Thread count must be at least 1, got " + std::to_string(threads)
+        };
+        throw std::invalid_argument(error_msg);
+    }
+
+    workers.clear();
+    for (int id = 0; id < threads; ++id) {
+        workers.push_back(std::make_unique<Search>(tt, stopped, pondering, id));
+        workers.back()->set_tablebases(tablebases);
+        workers.back()->set_network(network);
+    }
+    // Extend the main thread's report to the whole pool.
+    workers.front()->set_info_callback([this](const SearchInfo &info) {
+        if (!info_callback) {
+            return;
+        }
+        SearchInfo total{info};
+        total.nodes = node_count();
+        total.tb_hits = tb_hit_count();
+        total.nps = total.nodes * 1000 /
+                    static_cast<uint64_t>(std::max<int64_t>(info.time_ms, 1));
+        info_callback(total);
+    });
+}
+
+int ParallelSearch::threads() const {
+    return static_cast<int>(workers.size());
+}
+
+SearchResult ParallelSearch::run(const Board &board,
+                                 const SearchLimits &limits) {
+    stopped = false;
+    pondering = limits.ponder;
+    return search(board, limits);
+}
+
+void ParallelSearch::start(const Board &board, const SearchLimits &limits,
+                           std::function<void(const SearchResult &)> on_done) {
+    // Set here rather than on the new thread, so that a stop() or
+    // ponderhit() right after this call cannot be lost.
+    stopped = false;
+    pondering = limits.ponder;
+    runner = std::thread{[this, board, limits, on_done = std::move(on_done)] {
+        const stats::Snapshot before{stats::thread_snapshot()};
+        background_result = search(board, limits);
+        add_thread_stats(stats::thread_snapshot() - before);
+        if (on_done) {
+            on_done(background_result);
+        }
+    }};
+}
+
+SearchResult ParallelSearch::wait() {
+    if (runner.joinable()) {
+        runner.join();
+    }
+    return background_result;
+}
+
+SearchResult ParallelSearch::search(const Board &board,
+                                    const SearchLimits &limits) {
+    // Helpers may start after the main thread's first report.
+    for (const auto &worker: workers) {
+        worker->reset_counts();
+    }
+    std::vector<SearchResult> results(workers.size());
+    {
+        // Board methods mutate in place, so each helper gets its own copy.
+        std::vector<std::jthread> helpers{};
+        helpers.reserve(workers.size() - 1);
+        for (std::size_t i = 1; i < workers.size(); ++i) {
+            helpers.emplace_back([this, &board, &limits, &results, i] {
+                const stats::Snapshot before{stats::thread_snapshot()};
+                Board copy{board};
+                results[i] = workers[i]->run(copy, limits);
+                add_thread_stats(stats::thread_snapshot() - before);
+            });
+        }
+
+        Board copy{board};
+        results[0] = workers[0]->run(copy, limits);
+
+        // The main thread decides when the search is over.
+        stopped = true;
+    }
+
+    // Prefer a helper only if it finished a deeper iteration than the main
+    // thread; shallower helper results are less reliable.
+    SearchResult best{results[0]};
+    for (std::size_t i = 1; i < results.size(); ++i) {
+        if (results[i].depth > best.depth && !results[i].best_move.is_none()) {
+            best = results[i];
+        }
+    }
+    best.nodes = node_count();
+    best.tb_hits = tb_hit_count();
+    return best;
+}
+
+void ParallelSearch::stop() {
+    stopped = true;
+}
+
+void ParallelSearch::ponderhit() {
+    pondering = false;
+}
+
+void ParallelSearch::set_info_callback(
+    std::function<void(const SearchInfo &)> callback) {
+    info_callback = std::move(callback);
+}
+
+void ParallelSearch::set_tablebases(const syzygy::Tablebases *tables) {
+    tablebases = tables;
+    for (const auto &worker: workers) {
+        worker->set_tablebases(tables);
+    }
+}
+
+void ParallelSearch::set_network(const nnue::Network *net) {
+    network = net;
+    for (const auto &worker: workers) {
+        worker->set_network(net);
+    }
+}
+
+void ParallelSearch::clear() {
+    for (const auto &worker: workers) {
+        worker->clear();
+    }
+}
+
+uint64_t ParallelSearch::node_count() const {
+    uint64_t total{0};
+    for (const auto &worker: workers) {
+        total += worker->node_count();
+    }
+    return total;
+}
+
+uint64_t ParallelSearch::tb_hit_count() const {
+    uint64_t total{0};
+    for (const auto &worker: workers) {
+        total += worker->tb_hit_count();
+    }
+    return total;
+}
+
+stats::Snapshot ParallelSearch::thread_stats() const {
+    const std::lock_guard lock{stats_mutex};
+    return finished_stats;
+}
+
+void ParallelSearch::add_thread_stats(const stats::Snapshot &used) {
+    if constexpr (stats::ENABLED) {
+        const std::lock_guard lock{stats_mutex};
+        finished_stats = finished_stats + used;
+    }
+}
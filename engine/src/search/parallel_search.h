@@ -0,0 +1,108 @@
+#ifndef PARALLEL_SEARCH_H
+#define PARALLEL_SEARCH_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "chess/board.h"
+#include "chess/tt.h"
+#include "search.h"
+#include "util/stats.h"
+
+// Lazy SMP: every thread runs its own iterative deepening on a private copy
+// of the board, with its own killers and history, and the threads
+// cooperate only through the shared transposition table. Helper threads
+// stagger their depths so that they fill the table with entries the main
+// thread is about to need.
+class ParallelSearch {
+public:
+    explicit ParallelSearch(TranspositionTable &tt, const int &threads = 1);
+
+    // Stops a search still running in the background.
+    ~ParallelSearch();
+
+    ParallelSearch(const ParallelSearch &) = delete;
+
+    ParallelSearch &operator=(const ParallelSearch &) = delete;
+
+    // Resizes the pool, discarding per-thread history. Must not be called
+    // while a search is running.
+    void set_threads(const int &threads);
+
+    [[nodiscard]] int threads() const;
+
+    // Searches the position on all threads until the main thread hits a
+    // limit or stop() is called, then returns the result of the thread
+    // that completed the deepest iteration.
+    SearchResult run(const Board &board, const SearchLimits &limits);
+
+    // Same as run(), on a thread of its own, returning at once; wait()
+    // collects the result, and `on_done`, if given, receives it on the
+    // search thread as soon as the search ends. For callers that go on while
+    // the search runs, such as pondering. A search started before must have
+    // been waited for.
+    void start(const Board &board, const SearchLimits &limits,
+               std::function<void(const SearchResult &)> on_done = {});
+
+    // Waits for the search start() began and returns its result.
+    SearchResult wait();
+
+    // Asks a running search to return as soon as possible. Safe to call
+    // from any thread.
+    void stop();
+
+    // Ends the pondering of a search started with SearchLimits::ponder: the
+    // expected move was played, and the limits apply from now on. Safe to
+    // call from any thread.
+    void ponderhit();
+
+    // Progress of the main thread, with node and tablebase hit counts
+    // summed over all threads.
+    void set_info_callback(std::function<void(const SearchInfo &)> callback);
+
+    // Tables probed by every thread, or none. They must outlive every run.
+    void set_tablebases(const syzygy::Tablebases *tables);
+
+    // Network every thread evaluates with, or none. It must outlive every
+    // run.
+    void set_network(const nnue::Network *net);
+
+    void clear();
+
+    // Nodes searched by all threads in the current or last run.
+    [[nodiscard]] uint64_t node_count() const;
+
+    // Tablebase hits of all threads in the current or last run.
+    [[nodiscard]] uint64_t tb_hit_count() const;
+
+    // Engine counters of the threads the pool starts, helpers and the
+    // search thread of start(), summed over every search so far. The
+    // thread calling run() keeps its own in stats::thread_snapshot().
+    [[nodiscard]] stats::Snapshot thread_stats() const;
+
+private:
+    // The search itself, once the flags are set for it.
+    SearchResult search(const Board &board, const SearchLimits &limits);
+
+    // Adds what a thread of the pool counted before it ends.
+    void add_thread_stats(const stats::Snapshot &used);
+
+    TranspositionTable &tt;
+    std::atomic<bool> stopped{false};
+    std::atomic<bool> pondering{false};
+    std::vector<std::unique_ptr<Search>> workers{};
+    std::function<void(const SearchInfo &)> info_callback{};
+    const syzygy::Tablebases *tablebases{nullptr};
+    const nnue::Network *network{nullptr};
+    // Runs the search of start(), and its result once it has finished.
+    std::thread runner{};
+    SearchResult background_result{};
+    mutable std::mutex stats_mutex{};
+    stats::Snapshot finished_stats{};
+};
+
+#endif //PARALLEL_SEARCH_H
@@ -0,0 +1,676 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "eval/evaluate.h"
+#include "search.h"
+#include "util/stats.h"
+
+namespace {
+    constexpr int MAX_HISTORY{16384};
+    constexpr int ASPIRATION_WINDOW{25};
+
+    // Late-move reductions by depth and move number, computed once.
+    const std::array<std::array<int, 64>, 64> REDUCTIONS{
+        [] {
+            std::array<std::array<int, 64>, 64> table{};
+            for (int depth = 1; depth < 64; ++depth) {
+                for (int move = 1; move < 64; ++move) {
+                    table[depth][move] = static_cast<int>(
+                        0.75 + std::log(depth) * std::log(move) / 2.25);
+                }
+            }
+            return table;
+        }()
+    };
+
+    bool is_capture(const Board &board, const Move &move) {
+        return move.flag() == MoveFlag::EN_PASSANT ||
+               !board.piece_on(move.to()).is_empty();
+    }
+
+    bool is_quiet(const Board &board, const Move &move) {
+        return move.flag() != MoveFlag::PROMOTION && !is_capture(board, move);
+    }
+
+    // Whether the side to move has anything besides pawns and king. Null-move
+    // pruning is unsound in pawn endings, where zugzwang is common.
+    bool has_non_pawn_material(const Board &board) {
+        const bool us{board.is_white_turn()};
+        return board.occupancy(us) &
+               ~(board.pieces(Piece{PieceType::PAWN, us}) |
+                 board.pieces(Piece{PieceType::KING, us}));
+    }
+
+    // Mate and tablebase scores are stored relative to the position rather
+    // than the root, so that they stay correct when reached through a
+    // different path.
+    int score_to_tt(const int &score, const int &ply) {
+        if (score >= VALUE_TB_WIN_IN_MAX_PLY) {
+            return score + ply;
+        }
+        if (score <= -VALUE_TB_WIN_IN_MAX_PLY) {
+            return score - ply;
+        }
+        return score;
+    }
+
+    int score_from_tt(const int &score, const int &ply) {
+        if (score >= VALUE_TB_WIN_IN_MAX_PLY) {
+            return score - ply;
+        }
+        if (score <= -VALUE_TB_WIN_IN_MAX_PLY) {
+            return score + ply;
+        }
+        return score;
+    }
+
+    // Score of a tablebase value at `ply`. Wins and losses that the
+    // fifty-move rule spoils score just off a draw.
+    int tb_score(const syzygy::Wdl &wdl, const int &ply) {
+        switch (wdl) {
+            case syzygy::Wdl::WIN:
+                return VALUE_TB_WIN - ply;
+            case syzygy::Wdl::LOSS:
+                return -VALUE_TB_WIN + ply;
+            default:
+                return VALUE_DRAW + static_cast<int>(wdl);
+        }
+    }
+
+    // Iteration skipping for helper threads, so that they spread over
+    // different depths instead of all searching the same tree in lockstep.
+    // Helper i skips a depth when ((depth + PHASE[i]) / SIZE[i]) is odd.
+    constexpr std::array<int, 20> SKIP_SIZE{
+        1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4
+    };
+    constexpr std::array<int, 20> SKIP_PHASE{
+        0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7
+    };
+}
+
+Search::Search(TranspositionTable &tt) : tt{tt} {}
+
+Search::Search(TranspositionTable &tt, std::atomic<bool> &stop_flag,
+               std::atomic<bool> &ponder_flag, const int &thread_id)
+    : tt{tt}, stopped{&stop_flag}, ponder_flag{&ponder_flag},
+      thread_id{thread_id} {}
+
+SearchResult Search::run(Board &board, const SearchLimits &search_limits) {
+    STATS_TIME(SEARCH);
+    const bool main_thread{thread_id == 0};
+    limits = search_limits;
+    // Shared flags are set by the pool before any helper starts.
+    if (stopped == &own_stop) {
+        own_stop = false;
+    }
+    if (ponder_flag == &own_ponder) {
+        own_ponder = limits.ponder;
+    }
+    ponder_pending = main_thread && limits.ponder;
+    nodes = 0;
+    tb_hits = 0;
+    root_depth = 0;
+    time.start(limits, board.is_white_turn());
+    // No search line is longer than MAX_PLY, null moves included.
+    board.reserve_history(MAX_PLY);
+    if (main_thread) {
+        tt.new_search();
+        reuse_pv(board);
+    }
+    last_pv.clear();
+    last_pv_keys.clear();
+
+    SearchResult result{};
+    MoveList root_moves;
+    board.generate_moves(root_moves);
+    if (root_moves.empty()) {
+        result.score = board.checkers() ? -VALUE_MATE : VALUE_DRAW;
+        return result;
+    }
+    result.best_move = root_moves[0];
+    // Analysis and pondering keep searching until told otherwise, tables or
+    // not.
+    if (!limits.infinite && !limits.ponder && probe_root(board, result)) {
+        return result;
+    }
+
+    const int max_depth{
+        limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1
+    };
+    int score{0};
+    for (root_depth = 1; root_depth <= max_depth; ++root_depth) {
+        if (!main_thread) {
+            const std::size_t i{static_cast<std::size_t>(thread_id - 1) %
+                                SKIP_SIZE.size()};
+            if ((root_depth + SKIP_PHASE[i]) / SKIP_SIZE[i] % 2) {
+                continue;
+            }
+        }
+        seldepth = 0;
+
+        // From a few plies on, search a narrow window around the previous
+        // score first, widening it on either side when the score falls out.
+        int delta{ASPIRATION_WINDOW};
+        int alpha{-VALUE_INFINITE}, beta{VALUE_INFINITE};
+        if (root_depth >= 5) {
+            alpha = std::max(score - delta, -VALUE_INFINITE);
+            beta = std::min(score + delta, VALUE_INFINITE);
+        }
+        while (true) {
+            score = negamax(board, alpha, beta, root_depth, 0, false);
+            if (*stopped) {
+                break;
+            }
+            if (score <= alpha) {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(score - delta, -VALUE_INFINITE);
+            } else if (score >= beta) {
+                beta = std::min(score + delta, VALUE_INFINITE);
+            } else {
+                break;
+            }
+            delta += delta / 2;
+        }
+
+        // An interrupted iteration is discarded in favour of the last
+        // complete one.
+        if (*stopped || pv_length[0] == 0) {
+            break;
+        }
+
+        result.best_move = pv[0][0];
+        result.ponder_move = pv_length[0] > 1 ? pv[0][1] : Move::none();
+        result.score = score;
+        result.depth = root_depth;
+        result.nodes = nodes;
+        result.tb_hits = tb_hits;
+        last_pv.assign(pv[0].begin(), pv[0].begin() + pv_length[0]);
+
+        if (main_thread && info_callback) {
+            const int64_t elapsed{time.elapsed_ms()};
+            info_callback(SearchInfo{
+                root_depth, seldepth, score, nodes, elapsed,
+                nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(
+                    elapsed, 1)),
+                tt.hashfull(), tb_hits,
+                {pv[0].begin(), pv[0].begin() + pv_length[0]}
+            });
+        }
+
+        if (main_thread && !pondering() && time.soft_limit_reached()) {
+            break;
+        }
+        // A mate that fits inside the completed depth will not get shorter.
+        if (!limits.infinite && !pondering() &&
+            std::abs(score) >= VALUE_MATE_IN_MAX_PLY &&
+            VALUE_MATE - std::abs(score) <= root_depth) {
+            break;
+        }
+    }
+
+    // Analysis returns only when stopped, and a ponder search only after its
+    // hit or when stopped, however early they are done.
+    while (main_thread && (limits.infinite || pondering()) && !*stopped) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    if (main_thread) {
+        save_pv_keys(board);
+    }
+
+    result.nodes = nodes;
+    result.tb_hits = tb_hits;
+    return result;
+}
+
+bool Search::probe_root(Board &board, SearchResult &result) {
+    if (!tablebases || !tablebases->covers(board)) {
+        return false;
+    }
+    const std::optional<syzygy::RootProbe> probe{tablebases->probe_root(board)};
+    if (!probe) {
+        return false;
+    }
+    tb_hits = 1;
+    result.best_move = probe->move;
+    result.score = tb_score(probe->wdl, 0);
+    result.depth = 1;
+
+    if (thread_id == 0 && info_callback) {
+        info_callback(SearchInfo{
+            1, 0, result.score, nodes, time.elapsed_ms(), 0, tt.hashfull(),
+            tb_hits, {probe->move}
+        });
+    }
+    return true;
+}
+
+void Search::stop() {
+    *stopped = true;
+}
+
+void Search::ponderhit() {
+    *ponder_flag = false;
+}
+
+uint64_t Search::node_count() const {
+    return nodes.load(std::memory_order_relaxed);
+}
+
+uint64_t Search::tb_hit_count() const {
+    return tb_hits.load(std::memory_order_relaxed);
+}
+
+void Search::reset_counts() {
+    nodes = 0;
+    tb_hits = 0;
+}
+
+void Search::set_info_callback(
+    std::function<void(const SearchInfo &)> callback) {
+    info_callback = std::move(callback);
+}
+
+void Search::set_tablebases(const syzygy::Tablebases *tables) {
+    tablebases = tables;
+}
+
+void Search::set_network(const nnue::Network *net) {
+    network = net;
+    accumulators.clear();
+}
+
+void Search::clear() {
+    killers = {};
+    history = {};
+    last_pv.clear();
+    last_pv_keys.clear();
+}
+
+int Search::negamax(Board &board, int alpha, int beta, int depth,
+                    const int &ply, const bool &allow_null) {
+    const bool pv_node{beta - alpha > 1};
+    const bool root{ply == 0};
+    pv_length[ply] = ply;
+
+    if (depth <= 0) {
+        return quiescence(board, alpha, beta, ply);
+    }
+
+    count_node();
+    check_limits();
+    if (*stopped) {
+        return 0;
+    }
+    seldepth = std::max(seldepth, ply);
+
+    if (!root) {
+        if (board.halfmove_clock() >= 100 || board.is_repetition(ply)) {
+            return VALUE_DRAW;
+        }
+        if (ply >= MAX_PLY - 1) {
+            return evaluate_position(board);
+        }
+        // Mate distance pruning: no line from here can beat a mate that has
+        // already been found closer to the root.
+        alpha = std::max(alpha, -VALUE_MATE + ply);
+        beta = std::min(beta, VALUE_MATE - ply - 1);
+        if (alpha >= beta) {
+            return alpha;
+        }
+    }
+
+    // ---------------------- Transposition Table ----------------------
+    TTEntry entry{};
+    const bool tt_hit{tt.probe(board.key(), entry)};
+    const Move tt_move{tt_hit ? entry.move : Move::none()};
+    if (tt_hit && !pv_node && entry.depth >= depth) {
+        const int tt_score{score_from_tt(entry.score, ply)};
+        if (entry.bound == Bound::EXACT ||
+            (entry.bound == Bound::LOWER && tt_score >= beta) ||
+            (entry.bound == Bound::UPPER && tt_score <= alpha)) {
+            return tt_score;
+        }
+    }
+
+    const bool in_check{board.checkers() != EMPTY_BB};
+
+    // ---------------------- Tablebase Probe ----------------------
+    // Tables only hold positions right after a capture or pawn move, where
+    // the fifty-move counter they assume is zero.
+    if (!root && tablebases && board.halfmove_clock() == 0 &&
+        tablebases->covers(board)) {
+        if (const std::optional<syzygy::Wdl> wdl{tablebases->probe_wdl(board)}) {
+            tb_hits.store(tb_hits.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+            const int score{tb_score(*wdl, ply)};
+            // A win may still be mated faster, and a loss may be a mate.
+            const Bound bound{
+                *wdl == syzygy::Wdl::WIN
+                    ? Bound::LOWER
+                    : *wdl == syzygy::Wdl::LOSS
+                          ? Bound::UPPER
+                          : Bound::EXACT
+            };
+            if (bound == Bound::EXACT ||
+                (bound == Bound::LOWER && score >= beta) ||
+                (bound == Bound::UPPER && score <= alpha)) {
+                tt.store(board.key(), Move::none(), score_to_tt(score, ply),
+                         in_check ? -VALUE_INFINITE : evaluate_position(board),
+                         std::min(MAX_PLY - 1, depth + 6), bound);
+                return score;
+            }
+        }
+    }
+
+    const int static_eval{
+        in_check
+            ? -VALUE_INFINITE
+            : tt_hit ? entry.eval : evaluate_position(board)
+    };
+
+    // ---------------------- Null-Move Pruning ----------------------
+    // If passing still leaves us above beta, a real move almost certainly
+    // would too, so a reduced search of the null move decides the node.
+    if (!pv_node && !in_check && allow_null && depth >= 3 &&
+        static_eval >= beta && has_non_pawn_material(board)) {
+        const int reduction{3 + depth / 6};
+        board.make_null_move();
+        const int score{
+            -negamax(board, -beta, -beta + 1, depth - 1 - reduction, ply + 1,
+                     false)
+        };
+        board.unmake_move();
+        if (*stopped) {
+            return 0;
+        }
+        if (score >= beta) {
+            // Unproven mates from a null-move search are not trusted.
+            return score >= VALUE_TB_WIN_IN_MAX_PLY ? beta : score;
+        }
+    }
+
+    MovePicker picker{board, tt_move, killers[ply], history};
+    MoveList quiets_tried;
+    const int original_alpha{alpha};
+    int best_score{-VALUE_INFINITE};
+    Move best_move{Move::none()};
+    std::size_t move_count{0};
+
+    for (Move move{picker.next()}; !move.is_none(); move = picker.next()) {
+        const std::size_t i{move_count++};
+        const bool quiet{is_quiet(board, move)};
+
+        board.make_move(move);
+        tt.prefetch(board.key());
+        const bool gives_check{board.checkers() != EMPTY_BB};
+        // Check extension.
+        const int new_depth{depth - 1 + (gives_check ? 1 : 0)};
+
+        int score;
+        if (i == 0) {
+            score = -negamax(board, -beta, -alpha, new_depth, ply + 1, true);
+        } else {
+            // Late quiet moves are searched to a reduced depth with a null
+            // window first and only re-searched if they look promising.
+            int reduction{0};
+            if (depth >= 3 && i >= 3 && quiet && !in_check && !gives_check) {
+                reduction = REDUCTIONS[std::min(depth, 63)]
+                                      [std::min<std::size_t>(i, 63)];
+                reduction -= pv_node ? 1 : 0;
+                reduction = std::clamp(reduction, 0, new_depth - 1);
+            }
+            score = -negamax(board, -alpha - 1, -alpha, new_depth - reduction,
+                             ply + 1, true);
+            if (score > alpha && reduction > 0) {
+                score = -negamax(board, -alpha - 1, -alpha, new_depth, ply + 1,
+                                 true);
+            }
+            if (score > alpha && score < beta) {
+                score = -negamax(board, -beta, -alpha, new_depth, ply + 1,
+                                 true);
+            }
+        }
+        board.unmake_move();
+
+        if (*stopped) {
+            return 0;
+        }
+
+        if (score > best_score) {
+            best_score = score;
+            if (score > alpha) {
+                alpha = score;
+                best_move = move;
+
+                pv[ply][ply] = move;
+                for (int j = ply + 1; j < pv_length[ply + 1]; ++j) {
+                    pv[ply][j] = pv[ply + 1][j];
+                }
+                pv_length[ply] = std::max(pv_length[ply + 1], ply + 1);
+
+                if (score >= beta) {
+                    STATS_COUNT(CUTOFFS);
+                    if (i == 0) {
+                        STATS_COUNT(FIRST_MOVE_CUTOFFS);
+                    }
+                    if (quiet) {
+                        update_quiet_stats(board, move, quiets_tried, depth,
+                                           ply);
+                    }
+                    break;
+                }
+            }
+        }
+        if (quiet) {
+            quiets_tried.push_back(move);
+        }
+    }
+
+    if (move_count == 0) {
+        return in_check ? -VALUE_MATE + ply : VALUE_DRAW;
+    }
+
+    const Bound bound{
+        best_score >= beta
+            ? Bound::LOWER
+            : alpha > original_alpha
+                  ? Bound::EXACT
+                  : Bound::UPPER
+    };
+    tt.store(board.key(), best_move, score_to_tt(best_score, ply), static_eval,
+             depth, bound);
+    return best_score;
+}
+
+int Search::quiescence(Board &board, int alpha, int beta, const int &ply) {
+    const bool pv_node{beta - alpha > 1};
+    pv_length[ply] = ply;
+
+    count_node();
+    STATS_COUNT(QNODES);
+    check_limits();
+    if (*stopped) {
+        return 0;
+    }
+    seldepth = std::max(seldepth, ply);
+
+    if (ply >= MAX_PLY - 1) {
+        return evaluate_position(board);
+    }
+
+    TTEntry entry{};
+    const bool tt_hit{tt.probe(board.key(), entry)};
+    if (tt_hit && !pv_node) {
+        const int tt_score{score_from_tt(entry.score, ply)};
+        if (entry.bound == Bound::EXACT ||
+            (entry.bound == Bound::LOWER && tt_score >= beta) ||
+            (entry.bound == Bound::UPPER && tt_score <= alpha)) {
+            return tt_score;
+        }
+    }
+
+    const bool in_check{board.checkers() != EMPTY_BB};
+    int best_score{-VALUE_INFINITE};
+    int static_eval{-VALUE_INFINITE};
+
+    // Stand pat: outside of check the side to move may decline every
+    // capture, so the static evaluation is a lower bound.
+    if (!in_check) {
+        static_eval = tt_hit ? entry.eval : evaluate_position(board);
+        if (static_eval >= beta) {
+            return static_eval;
+        }
+        alpha = std::max(alpha, static_eval);
+        best_score = static_eval;
+    }
+
+    // Out of check only captures and queen promotions are searched.
+    MovePicker picker{board, tt_hit ? entry.move : Move::none(), history};
+    const int original_alpha{alpha};
+    Move best_move{Move::none()};
+    std::size_t move_count{0};
+    for (Move move{picker.next()}; !move.is_none(); move = picker.next()) {
+        ++move_count;
+        board.make_move(move);
+        const int score{-quiescence(board, -beta, -alpha, ply + 1)};
+        board.unmake_move();
+
+        if (*stopped) {
+            return 0;
+        }
+
+        if (score > best_score) {
+            best_score = score;
+            if (score > alpha) {
+                alpha = score;
+                best_move = move;
+
+                pv[ply][ply] = move;
+                for (int j = ply + 1; j < pv_length[ply + 1]; ++j) {
+                    pv[ply][j] = pv[ply + 1][j];
+                }
+                pv_length[ply] = std::max(pv_length[ply + 1], ply + 1);
+
+                if (score >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (in_check && move_count == 0) {
+        return -VALUE_MATE + ply;
+    }
+
+    const Bound bound{
+        best_score >= beta
+            ? Bound::LOWER
+            : alpha > original_alpha
+                  ? Bound::EXACT
+                  : Bound::UPPER
+    };
+    tt.store(board.key(), best_move, score_to_tt(best_score, ply), static_eval,
+             0, bound);
+    return best_score;
+}
+
+int Search::evaluate_position(const Board &board) {
+    STATS_COUNT(EVALUATIONS);
+    STATS_TIME(EVALUATION);
+    if (!network) {
+        return evaluate(board);
+    }
+    // Keep the network clear of the tablebase and mate score ranges.
+    return std::clamp(network->evaluate(board, accumulators),
+                      -VALUE_TB_WIN_IN_MAX_PLY + 1, VALUE_TB_WIN_IN_MAX_PLY - 1);
+}
+
+void Search::count_node() {
+    STATS_COUNT(NODES);
+    // Only this thread writes the counter; other threads merely read it.
+    nodes.store(nodes.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+}
+
+void Search::check_limits() {
+    // Helpers run until the main thread stops them.
+    if (thread_id != 0 || pondering()) {
+        return;
+    }
+    const uint64_t count{nodes.load(std::memory_order_relaxed)};
+    if (limits.nodes > 0 && count >= limits.nodes) {
+        *stopped = true;
+    }
+    // Reading the clock is comparatively slow, so it is only done every few
+    // thousand nodes. The first iteration always completes, so there is
+    // always a move to play.
+    if ((count & 2047) == 0 && root_depth > 1 && time.hard_limit_reached()) {
+        *stopped = true;
+    }
+}
+
+bool Search::pondering() {
+    if (ponder_pending && !ponder_flag->load(std::memory_order_relaxed)) {
+        ponder_pending = false;
+        time.restart_budget();
+    }
+    return ponder_pending;
+}
+
+void Search::reuse_pv(Board &board) {
+    const auto found{std::ranges::find(last_pv_keys, board.key())};
+    if (found == last_pv_keys.end()) {
+        return;
+    }
+    std::size_t played{0};
+    for (auto i{static_cast<std::size_t>(found - last_pv_keys.begin())};
+         i < last_pv.size(); ++i) {
+        // Entries that survived are at least as good as a bare move.
+        if (TTEntry entry{}; !tt.probe(board.key(), entry)) {
+            tt.store(board.key(), last_pv[i], 0,
+                     board.checkers() ? -VALUE_INFINITE : evaluate_position(board),
+                     0, Bound::NONE);
+        }
+        board.make_move(last_pv[i]);
+        ++played;
+    }
+    for (; played > 0; --played) {
+        board.unmake_move();
+    }
+}
+
+void Search::save_pv_keys(Board &board) {
+    for (const Move &move: last_pv) {
+        last_pv_keys.push_back(board.key());
+        board.make_move(move);
+    }
+    for (std::size_t i = 0; i < last_pv.size(); ++i) {
+        board.unmake_move();
+    }
+}
+
+void Search::update_quiet_stats(const Board &board, const Move &move,
+                                const MoveList &quiets_tried,
+                                const int &depth, const int &ply) {
+    if (killers[ply][0] != move) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    // History gravity: each update moves the entry towards the bonus while
+    // keeping it bounded by MAX_HISTORY.
+    const int us{color_index(board.is_white_turn())};
+    const int bonus{std::min(depth * depth, MAX_HISTORY)};
+    auto update = [this, &us](const Move &m, const int &delta) {
+        int &entry{history[us][m.from()][m.to()]};
+        entry += delta - entry * std::abs(delta) / MAX_HISTORY;
+    };
+    update(move, bonus);
+    for (const Move &quiet: quiets_tried) {
+        update(quiet, -bonus);
+    }
+}
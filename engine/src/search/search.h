@@ -0,0 +1,178 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "chess/board.h"
+#include "chess/move.h"
+#include "chess/tt.h"
+#include "move_picker.h"
+#include "nnue/network.h"
+#include "tb/syzygy.h"
+#include "time_manager.h"
+
+constexpr int MAX_PLY{128};
+constexpr int VALUE_DRAW{0};
+constexpr int VALUE_MATE{32000};
+constexpr int VALUE_INFINITE{32001};
+// Scores beyond this bound are mate scores.
+constexpr int VALUE_MATE_IN_MAX_PLY{VALUE_MATE - MAX_PLY};
+// Tablebase wins rank below every mate but above any evaluation.
+constexpr int VALUE_TB_WIN{VALUE_MATE_IN_MAX_PLY - 1};
+// Scores beyond this bound are tablebase wins or mates.
+constexpr int VALUE_TB_WIN_IN_MAX_PLY{VALUE_TB_WIN - MAX_PLY};
+
+// Progress report, sent after every completed iteration.
+struct SearchInfo {
+    int depth{};
+    int seldepth{};
+    int score{};
+    uint64_t nodes{};
+    int64_t time_ms{};
+    uint64_t nps{};
+    int hashfull{};
+    uint64_t tb_hits{};
+    std::vector<Move> pv{};
+};
+
+struct SearchResult {
+    Move best_move{Move::none()};
+    // Expected reply, if the principal variation has one.
+    Move ponder_move{Move::none()};
+    int score{};
+    int depth{};
+    uint64_t nodes{};
+    uint64_t tb_hits{};
+};
+
+// Alpha-beta searcher: iterative deepening with aspiration windows,
+// principal variation search, quiescence search, null-move pruning and
+// late-move reductions. Moves come lazily from a MovePicker, ordered by
+// transposition table move, MVV-LVA and SEE for captures, killer moves and
+// the history heuristic. Leaves are evaluated by the network if one is set,
+// by the hand-crafted evaluation otherwise. With tablebases, positions they
+// cover are scored from the tables, and a covered root position is played
+// straight from them.
+//
+// One instance searches on one thread. ParallelSearch runs several of them
+// over a shared transposition table. Killers, history and the last
+// principal variation carry over from one run to the next, so that the
+// searches of a game build on each other.
+class Search {
+public:
+    explicit Search(TranspositionTable &tt);
+
+    // A thread of a parallel search, stopped and told of ponder hits
+    // through the pool's shared flags. Thread 0 is the main thread: it alone
+    // watches the limits and reports progress. Helpers skip iterations
+    // depending on their id.
+    Search(TranspositionTable &tt, std::atomic<bool> &stop_flag,
+           std::atomic<bool> &ponder_flag, const int &thread_id);
+
+    // Searches the position until a limit is hit or stop() is called. The
+    // board is returned unchanged.
+    SearchResult run(Board &board, const SearchLimits &limits);
+
+    // Asks a running search to return as soon as possible. Safe to call
+    // from any thread.
+    void stop();
+
+    // Tells a search started with SearchLimits::ponder that the expected
+    // move was played, so that its limits apply from now on. Safe to call
+    // from any thread.
+    void ponderhit();
+
+    void set_info_callback(std::function<void(const SearchInfo &)> callback);
+
+    // Tables to probe, or none. They must outlive every run.
+    void set_tablebases(const syzygy::Tablebases *tables);
+
+    // Network to evaluate with, or none for the hand-crafted evaluation. It
+    // must outlive every run.
+    void set_network(const nnue::Network *net);
+
+    // Nodes searched so far by the current or last run. Safe to call from
+    // any thread.
+    [[nodiscard]] uint64_t node_count() const;
+
+    // Successful tablebase probes of the current or last run. Safe to call
+    // from any thread.
+    [[nodiscard]] uint64_t tb_hit_count() const;
+
+    // Zeroes the node and tablebase hit counts ahead of a run, so that a
+    // caller summing them over threads never reads a previous run's.
+    void reset_counts();
+
+    // Forgets killer moves, history and the last principal variation, e.g.
+    // when a new game starts.
+    void clear();
+
+private:
+    int negamax(Board &board, int alpha, int beta, int depth, const int &ply,
+                const bool &allow_null);
+
+    int quiescence(Board &board, int alpha, int beta, const int &ply);
+
+    void count_node();
+
+    // Static evaluation from the side to move's point of view.
+    int evaluate_position(const Board &board);
+
+    // Plays a root position covered by the tablebases from the tables, if
+    // they hold it.
+    [[nodiscard]] bool probe_root(Board &board, SearchResult &result);
+
+    // Periodically checks the node and time limits.
+    void check_limits();
+
+    // Whether a ponder search still waits for its hit. Starts the clock when
+    // the hit has come. Per thread; always false on helpers.
+    bool pondering();
+
+    // Where the position lies on the last run's principal variation, stores
+    // the moves it expected from here on that the table has lost, so that
+    // the search starts out on the line found before.
+    void reuse_pv(Board &board);
+
+    // Keys of the positions along the principal variation, for reuse_pv().
+    void save_pv_keys(Board &board);
+
+    void update_quiet_stats(const Board &board, const Move &move,
+                            const MoveList &quiets_tried, const int &depth,
+                            const int &ply);
+
+    TranspositionTable &tt;
+    TimeManager time{};
+    SearchLimits limits{};
+    std::atomic<bool> own_stop{false};
+    std::atomic<bool> *stopped{&own_stop};
+    // Set while a ponder search waits for its hit.
+    std::atomic<bool> own_ponder{false};
+    std::atomic<bool> *ponder_flag{&own_ponder};
+    bool ponder_pending{false};
+    int thread_id{0};
+    std::function<void(const SearchInfo &)> info_callback{};
+    const syzygy::Tablebases *tablebases{nullptr};
+    const nnue::Network *network{nullptr};
+    nnue::AccumulatorStack accumulators{};
+
+    std::atomic<uint64_t> nodes{0};
+    std::atomic<uint64_t> tb_hits{0};
+    int root_depth{0};
+    int seldepth{0};
+    std::array<std::array<Move, 2>, MAX_PLY> killers{};
+    HistoryTable history{};
+    // Triangular principal variation table.
+    std::array<std::array<Move, MAX_PLY + 1>, MAX_PLY + 1> pv{};
+    std::array<int, MAX_PLY + 1> pv_length{};
+    // Principal variation of the last completed iteration, and the key of
+    // the position before each of its moves.
+    std::vector<Move> last_pv{};
+    std::vector<uint64_t> last_pv_keys{};
+};
+
+#endif //SEARCH_H
@@ -0,0 +1,71 @@
+#include <algorithm>
+
+#include "chess/piece.h"
+#include "time_manager.h"
+
+void TimeManager::start(const SearchLimits &limits, const bool &white) {
+    start_time = budget_start = std::chrono::steady_clock::now();
+    limited = false;
+
+    if (limits.infinite) {
+        return;
+    }
+
+    if (limits.movetime_ms > 0) {
+        limited = true;
+        optimum = maximum = std::max<int64_t>(
+            limits.movetime_ms - MOVE_OVERHEAD_MS, 1);
+        return;
+    }
+
+    const int64_t time{limits.time_ms[color_index(white)]};
+    if (time <= 0) {
+        return;
+    }
+
+    // Spread the clock over the moves left until the next time control, or
+    // assume a fixed horizon in sudden death, and spend most of the
+    // increment on top.
+    limited = true;
+    const int64_t increment{limits.increment_ms[color_index(white)]};
+    const int64_t remaining{std::max<int64_t>(time - MOVE_OVERHEAD_MS, 1)};
+    const int64_t horizon{
+        limits.moves_to_go > 0 ? std::min(limits.moves_to_go, 50) : 30
+    };
+
+    maximum = std::max<int64_t>(
+        std::min(remaining * 4 / 5,
+                 (remaining / horizon + increment * 3 / 4) * 5), 1);
+    optimum = std::clamp<int64_t>(remaining / horizon + increment * 3 / 4, 1,
+                                  maximum);
+}
+
+void TimeManager::restart_budget() {
+    budget_start = std::chrono::steady_clock::now();
+}
+
+int64_t TimeManager::elapsed_ms() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+}
+
+int64_t TimeManager::budget_elapsed_ms() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - budget_start).count();
+}
+
+bool TimeManager::soft_limit_reached() const {
+    return limited && budget_elapsed_ms() >= optimum;
+}
+
+bool TimeManager::hard_limit_reached() const {
+    return limited && budget_elapsed_ms() >= maximum;
+}
+
+int64_t TimeManager::optimum_ms() const {
+    return optimum;
+}
+
+int64_t TimeManager::maximum_ms() const {
+    return maximum;
+}
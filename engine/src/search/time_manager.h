@@ -0,0 +1,64 @@
+#ifndef TIME_MANAGER_H
+#define TIME_MANAGER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "chess/bitboard.h"
+
+// What the caller allows the search to spend. Unset (zero) limits are
+// ignored; with no limits at all the search runs until stopped or until it
+// reaches its maximum depth.
+struct SearchLimits {
+    int depth{0};
+    uint64_t nodes{0};
+    int64_t movetime_ms{0};
+    // Remaining clock time and increment per side, indexed by color_index().
+    std::array<int64_t, NUM_COLORS> time_ms{};
+    std::array<int64_t, NUM_COLORS> increment_ms{};
+    int moves_to_go{0};
+    bool infinite{false};
+    // Searching the expected reply during the opponent's time: no limit
+    // applies until the search is told of a ponder hit, from when on the
+    // other limits do.
+    bool ponder{false};
+};
+
+// Decides how long a search may run. The soft limit is checked between
+// iterations, to avoid starting one that cannot finish; the hard limit
+// aborts an iteration in progress.
+class TimeManager {
+public:
+    void start(const SearchLimits &limits, const bool &white);
+
+    // Grants the budget start() allotted afresh from now, as on a ponder
+    // hit. elapsed_ms() still counts from start().
+    void restart_budget();
+
+    // Time since start(), as reported in search info.
+    [[nodiscard]] int64_t elapsed_ms() const;
+
+    [[nodiscard]] bool soft_limit_reached() const;
+
+    [[nodiscard]] bool hard_limit_reached() const;
+
+    [[nodiscard]] int64_t optimum_ms() const;
+
+    [[nodiscard]] int64_t maximum_ms() const;
+
+private:
+    // Time kept in reserve for communication and process scheduling delays.
+    static constexpr int64_t MOVE_OVERHEAD_MS{30};
+
+    [[nodiscard]] int64_t budget_elapsed_ms() const;
+
+    std::chrono::steady_clock::time_point start_time{};
+    // What the limits are measured from: start_time, or the last ponder hit.
+    std::chrono::steady_clock::time_point budget_start{};
+    int64_t optimum{0};
+    int64_t maximum{0};
+    bool limited{false};
+};
+
+#endif //TIME_MANAGER_H
@@ -0,0 +1,174 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chess/board.h"
+#include "chess/tt.h"
+#include "nnue/network.h"
+#include "nnue/simd.h"
+#include "search/parallel_search.h"
+
+namespace {
+    // Middlegame and endgame positions of varied character, searched to a
+    // fixed depth for every thread count.
+    constexpr std::array<const char *, 8> POSITIONS{
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 8",
+        "2r3k1/pp3ppp/4p3/3pP3/3P1P2/1P3K2/P5PP/2R5 w - - 0 30",
+        "r2q1rk1/pb1nbppp/1p2pn2/2pp4/3P4/1P1BPN2/PBPN1PPP/R2Q1RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "6k1/1p3pp1/p1b1p2p/q3P3/2pP4/2P2N1P/P4PP1/3Q2K1 w - - 0 25"
+    };
+
+    struct Options {
+        std::vector<std::string> fens{};
+        int depth{11};
+        std::size_t hash_mb{64};
+        std::vector<int> threads{};
+        std::string nnue_path{};
+    };
+
+    void print_usage() {
+        std::cout
+                << "Usage: engine_search_bench [options]\n"
+                << "  --fen <FEN>        position to search (repeatable, default: built-in set)\n"
+                << "  --depth <N>        search depth (default: 11)\n"
+                << "  --hash <MB>        transposition table size (default: 64)\n"
+                << "  --threads <list>   comma separated thread counts\n"
+                << "                     (default: 1, 2, 4, ... up to the core count)\n"
+                << "  --nnue <path>      evaluate with a network instead of the hand-crafted eval\n";
+    }
+
+    Options parse_options(const int argc, char **argv) {
+        Options options{};
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg{argv[i]};
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--fen") {
+                options.fens.push_back(value());
+            } else if (arg == "--depth") {
+                options.depth = std::stoi(value());
+            } else if (arg == "--hash") {
+                options.hash_mb = std::stoul(value());
+            } else if (arg == "--nnue") {
+                options.nnue_path = value();
+            } else if (arg == "--threads") {
+                std::istringstream list{value()};
+                for (std::string count; std::getline(list, count, ',');) {
+                    options.threads.push_back(std::max(1, std::stoi(count)));
+                }
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+        if (options.fens.empty()) {
+            options.fens.assign(POSITIONS.begin(), POSITIONS.end());
+        }
+        if (options.threads.empty()) {
+            const int cores{
+                static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))
+            };
+            for (int threads = 1; threads < cores; threads *= 2) {
+                options.threads.push_back(threads);
+            }
+            options.threads.push_back(cores);
+        }
+        return options;
+    }
+}
+
+int main(const int argc, char **argv) {
+    Options options{};
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Board> boards{};
+    try {
+        for (const std::string &fen: options.fens) {
+            boards.emplace_back(fen);
+        }
+    } catch (const std::invalid_argument &e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::optional<nnue::Network> network{};
+    if (!options.nnue_path.empty()) {
+        try {
+            network.emplace(options.nnue_path);
+        } catch (const std::invalid_argument &e) {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        std::cout << "network " << options.nnue_path << " ("
+                << nnue::simd::kernels().name << " kernels)\n";
+    }
+
+    TranspositionTable tt{options.hash_mb};
+    double base_seconds{0};
+    double base_nps{0};
+
+    std::cout << "depth " << options.depth << ", " << boards.size()
+            << " positions, " << options.hash_mb << " MB hash\n"
+            << std::setw(8) << "threads" << std::setw(14) << "nodes"
+            << std::setw(10) << "time" << std::setw(12) << "nps"
+            << std::setw(12) << "nps-gain" << std::setw(12) << "speedup"
+            << '\n';
+
+    for (const int &threads: options.threads) {
+        ParallelSearch search{tt, threads};
+        search.set_network(network ? &*network : nullptr);
+        SearchLimits limits{};
+        limits.depth = options.depth;
+
+        uint64_t nodes{0};
+        double seconds{0};
+        for (const Board &board: boards) {
+            // Every position starts cold, so that runs are comparable.
+            tt.clear();
+            search.clear();
+            const auto start{std::chrono::steady_clock::now()};
+            nodes += search.run(board, limits).nodes;
+            seconds += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+
+        const double nps{nodes / std::max(seconds, 1e-9)};
+        if (base_seconds == 0) {
+            base_seconds = seconds;
+            base_nps = nps;
+        }
+        // Speedup is time to depth relative to the first row; with Lazy SMP
+        // it trails the raw nps gain, as helpers search overlapping trees.
+        std::cout << std::fixed << std::setprecision(2)
+                << std::setw(8) << threads << std::setw(14) << nodes
+                << std::setw(9) << seconds << 's'
+                << std::setw(12) << static_cast<uint64_t>(nps)
+                << std::setw(11) << nps / base_nps << 'x'
+                << std::setw(11) << base_seconds / std::max(seconds, 1e-9) << 'x'
+                << '\n';
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,1126 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include "syzygy.h"
+#include "chess/attacks.h"
+#include "util/mapped_file.h"
+
+// Decoder for the Syzygy format as described by its author, Ronald de Man,
+// following the structure of the reference probing code.
+namespace syzygy {
+    namespace {
+        constexpr int TB_PIECES{7};
+        constexpr int MAX_DTZ{1 << 18};
+
+        constexpr std::array<uint8_t, 4> WDL_MAGIC{0x71, 0xE8, 0x23, 0x5D};
+        constexpr std::array<uint8_t, 4> DTZ_MAGIC{0xD7, 0x66, 0x0C, 0xA5};
+
+        // Flags of a PairsData block.
+        constexpr uint8_t FLAG_STM{1};
+        constexpr uint8_t FLAG_MAPPED{2};
+        constexpr uint8_t FLAG_WIN_PLIES{4};
+        constexpr uint8_t FLAG_LOSS_PLIES{8};
+        constexpr uint8_t FLAG_WIDE{16};
+        constexpr uint8_t FLAG_SINGLE_VALUE{128};
+
+        using Sym = uint16_t;
+
+        uint16_t read_le16(const uint8_t *data) {
+            return static_cast<uint16_t>(data[0] | data[1] << 8);
+        }
+
+        uint32_t read_le32(const uint8_t *data) {
+            return static_cast<uint32_t>(data[0]) |
+                   static_cast<uint32_t>(data[1]) << 8 |
+                   static_cast<uint32_t>(data[2]) << 16 |
+                   static_cast<uint32_t>(data[3]) << 24;
+        }
+
+        uint32_t read_be32(const uint8_t *data) {
+            return static_cast<uint32_t>(data[0]) << 24 |
+                   static_cast<uint32_t>(data[1]) << 16 |
+                   static_cast<uint32_t>(data[2]) << 8 |
+                   static_cast<uint32_t>(data[3]);
+        }
+
+        uint64_t read_be64(const uint8_t *data) {
+            return static_cast<uint64_t>(read_be32(data)) << 32 | read_be32(data + 4);
+        }
+
+        // Pieces as stored in the files: type 1-6 for white, plus 8 for black.
+        int tb_piece(const Piece &piece) {
+            return static_cast<int>(piece.type) + (piece.isWhite ? 0 : 8);
+        }
+
+        // Signed distance of a square from the a1-h8 diagonal.
+        int off_a1h8(const int &sq) {
+            return rank_of(sq) - file_of(sq);
+        }
+
+        int flip_file(const int &sq) {
+            return sq ^ 7;
+        }
+
+        int flip_rank(const int &sq) {
+            return sq ^ 56;
+        }
+
+        // ---------------------- Index Tables ----------------------
+
+        struct IndexTables {
+            // Squares a2-h7 to 0-47, highest for the square nearest to the
+            // edge and lowest rank, which makes that pawn the leading one.
+            std::array<int, NUM_SQUARES> map_pawns{};
+            // Squares below the a1-h8 diagonal to 0-27.
+            std::array<int, NUM_SQUARES> map_b1h1h7{};
+            // Squares of the a1-d1-d4 triangle to 0-9, diagonal last.
+            std::array<int, NUM_SQUARES> map_a1d1d4{};
+            // The 462 placements of two kings with the first one in the
+            // a1-d1-d4 triangle.
+            std::array<std::array<int, NUM_SQUARES>, 10> map_kk{};
+            // binomial[k][n]: ways to choose k of n.
+            std::array<std::array<int, NUM_SQUARES>, TB_PIECES - 1> binomial{};
+            std::array<std::array<int, NUM_SQUARES>, TB_PIECES - 1> lead_pawn_idx{};
+            std::array<std::array<int, 4>, TB_PIECES - 1> lead_pawns_size{};
+
+            IndexTables() {
+                int code{0};
+                for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+                    if (off_a1h8(sq) < 0) {
+                        map_b1h1h7[sq] = code++;
+                    }
+                }
+
+                code = 0;
+                std::vector<int> diagonal{};
+                for (const int sq: {0, 1, 2, 3, 8, 9, 10, 11,
+                                    16, 17, 18, 19, 24, 25, 26, 27}) {
+                    if (off_a1h8(sq) < 0) {
+                        map_a1d1d4[sq] = code++;
+                    } else if (off_a1h8(sq) == 0) {
+                        diagonal.push_back(sq);
+                    }
+                }
+                for (const int sq: diagonal) {
+                    map_a1d1d4[sq] = code++;
+                }
+
+                // If the first king is on the diagonal, the second one is
+                // not above it; positions with both on the diagonal go last.
+                std::vector<std::pair<int, int> > both_on_diagonal{};
+                code = 0;
+                for (int idx = 0; idx < 10; ++idx) {
+                    for (int s1 = 0; s1 <= 27; ++s1) {
+                        if (map_a1d1d4[s1] != idx || (idx == 0 && s1 != 1)) {
+                            continue;
+                        }
+                        for (int s2 = 0; s2 < NUM_SQUARES; ++s2) {
+                            if ((king_attacks(s1) | square_bb(s1)) & square_bb(s2)) {
+                                continue;
+                            }
+                            if (off_a1h8(s1) == 0 && off_a1h8(s2) > 0) {
+                                continue;
+                            }
+                            if (off_a1h8(s1) == 0 && off_a1h8(s2) == 0) {
+                                both_on_diagonal.emplace_back(idx, s2);
+                            } else {
+                                map_kk[idx][s2] = code++;
+                            }
+                        }
+                    }
+                }
+                for (const auto &[idx, sq]: both_on_diagonal) {
+                    map_kk[idx][sq] = code++;
+                }
+
+                binomial[0][0] = 1;
+                for (int n = 1; n < NUM_SQUARES; ++n) {
+                    for (int k = 0; k < TB_PIECES - 1 && k <= n; ++k) {
+                        binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) +
+                                         (k < n ? binomial[k][n - 1] : 0);
+                    }
+                }
+
+                int available{47};
+                for (int lead = 1; lead < TB_PIECES - 1; ++lead) {
+                    for (int file = 0; file < 4; ++file) {
+                        int idx{0};
+                        for (int rank = 1; rank <= 6; ++rank) {
+                            const int sq{rank * 8 + file};
+                            if (lead == 1) {
+                                map_pawns[sq] = available--;
+                                map_pawns[flip_file(sq)] = available--;
+                            }
+                            lead_pawn_idx[lead][sq] = idx;
+                            idx += binomial[lead - 1][map_pawns[sq]];
+                        }
+                        lead_pawns_size[lead][file] = idx;
+                    }
+                }
+            }
+        };
+
+        const IndexTables &index_tables() {
+            static const IndexTables tables{};
+            return tables;
+        }
+
+        // ---------------------- Material Keys ----------------------
+
+        // Four bits per piece count, white pawn to black king.
+        using Counts = std::array<int, NUM_PIECE_BBS>;
+
+        uint64_t material_key(const Counts &counts) {
+            uint64_t key{0};
+            for (int i = 0; i < NUM_PIECE_BBS; ++i) {
+                key |= static_cast<uint64_t>(counts[i]) << (4 * i);
+            }
+            return key;
+        }
+
+        Counts board_counts(const Board &board) {
+            Counts counts{};
+            for (const bool white: {true, false}) {
+                for (int type = 1; type <= 6; ++type) {
+                    const Piece piece{static_cast<PieceType>(type), white};
+                    counts[piece_index(piece)] = popcount(board.pieces(piece));
+                }
+            }
+            return counts;
+        }
+
+        Counts swap_colors(const Counts &counts) {
+            Counts swapped{};
+            for (int i = 0; i < 6; ++i) {
+                swapped[i] = counts[i + 6];
+                swapped[i + 6] = counts[i];
+            }
+            return swapped;
+        }
+
+        // Parses a table name such as "KRPvKR" into piece counts.
+        std::optional<Counts> parse_name(const std::string &name) {
+            constexpr std::string_view LETTERS{"PNBRQK"};
+            Counts counts{};
+            bool white{true};
+            int pieces{0};
+            for (const char c: name) {
+                if (c == 'v' && white) {
+                    white = false;
+                    continue;
+                }
+                const auto type{LETTERS.find(c)};
+                if (type == std::string_view::npos) {
+                    return std::nullopt;
+                }
+                ++counts[(white ? 0 : 6) + static_cast<int>(type)];
+                ++pieces;
+            }
+            if (white || counts[5] != 1 || counts[11] != 1 ||
+                pieces > TB_PIECES) {
+                return std::nullopt;
+            }
+            return counts;
+        }
+
+        bool is_capture(const Board &board, const Move &move) {
+            return move.flag() == MoveFlag::EN_PASSANT ||
+                   !board.piece_on(move.to()).is_empty();
+        }
+
+        bool is_zeroing(const Board &board, const Move &move) {
+            return is_capture(board, move) ||
+                   board.piece_on(move.from()).type == PieceType::PAWN;
+        }
+
+        int sign_of(const int &value) {
+            return (value > 0) - (value < 0);
+        }
+
+        // DTZ of the move before a zeroing move with the given outcome.
+        int dtz_before_zeroing(const Wdl &wdl) {
+            switch (wdl) {
+                case Wdl::WIN:
+                    return 1;
+                case Wdl::CURSED_WIN:
+                    return 101;
+                case Wdl::BLESSED_LOSS:
+                    return -101;
+                case Wdl::LOSS:
+                    return -1;
+                default:
+                    return 0;
+            }
+        }
+
+        Wdl negate(const Wdl &wdl) {
+            return static_cast<Wdl>(-static_cast<int>(wdl));
+        }
+    }
+
+    // ---------------------- Table Data ----------------------
+
+    struct PairsData {
+        uint8_t flags{};
+        std::size_t block_size{};
+        std::size_t span{};
+        uint32_t num_blocks{};
+        int max_sym_len{};
+        int min_sym_len{};
+        const uint8_t *lowest_sym{};
+        // Pairs of 12-bit child symbols, 3 bytes each.
+        const uint8_t *btree{};
+        const uint8_t *block_length{};
+        uint32_t block_length_size{};
+        // Entries of a 4-byte block index and a 2-byte offset.
+        const uint8_t *sparse_index{};
+        std::size_t sparse_index_size{};
+        const uint8_t *data{};
+        std::vector<uint64_t> base64{};
+        std::vector<uint8_t> symlen{};
+        std::array<int, TB_PIECES> pieces{};
+        std::array<uint64_t, TB_PIECES + 1> group_idx{};
+        std::array<int, TB_PIECES + 1> group_len{};
+        std::array<uint16_t, 4> map_idx{};
+
+        [[nodiscard]] Sym left(const Sym &sym) const {
+            const uint8_t *lr{btree + 3 * sym};
+            return static_cast<Sym>((lr[1] & 0xF) << 8 | lr[0]);
+        }
+
+        [[nodiscard]] Sym right(const Sym &sym) const {
+            const uint8_t *lr{btree + 3 * sym};
+            return static_cast<Sym>(lr[2] << 4 | lr[1] >> 4);
+        }
+    };
+
+    struct TableFile {
+        std::string path{};
+        bool dtz{false};
+        std::mutex mutex{};
+        std::atomic<bool> ready{false};
+        bool available{false};
+        MappedFile file{};
+        // [side to move][leading pawn file]; one side for DTZ tables.
+        std::array<std::array<PairsData, 4>, 2> items{};
+        // DTZ value remapping, if the table uses it.
+        const uint8_t *map{nullptr};
+    };
+
+    struct Table {
+        std::string name{};
+        // Material key with the first side of the name as white, and with
+        // colors swapped; equal for symmetric tables.
+        uint64_t key{};
+        uint64_t key2{};
+        int piece_count{};
+        bool has_pawns{};
+        bool has_unique_pieces{};
+        // Pawns of the leading color, then of the other color.
+        std::array<int, 2> pawn_count{};
+        TableFile wdl{};
+        TableFile dtz{};
+
+        PairsData *get(TableFile &file, const int &stm, const int &f) {
+            return &file.items[file.dtz ? 0 : stm % 2][has_pawns ? f : 0];
+        }
+    };
+
+    namespace {
+        uint8_t set_symlen(PairsData &d, const Sym &s, std::vector<bool> &visited) {
+            visited[s] = true;
+            const Sym sr{d.right(s)};
+            if (sr == 0xFFF) {
+                return 0;
+            }
+            const Sym sl{d.left(s)};
+            if (!visited[sl]) {
+                d.symlen[sl] = set_symlen(d, sl, visited);
+            }
+            if (!visited[sr]) {
+                d.symlen[sr] = set_symlen(d, sr, visited);
+            }
+            return static_cast<uint8_t>(d.symlen[sl] + d.symlen[sr] + 1);
+        }
+
+        // Reads the canonical Huffman code and the pair tree of one block.
+        const uint8_t *set_sizes(PairsData &d, const uint8_t *data) {
+            d.flags = *data++;
+
+            if (d.flags & FLAG_SINGLE_VALUE) {
+                d.num_blocks = 0;
+                d.span = 0;
+                d.block_length_size = 0;
+                d.sparse_index_size = 0;
+                // The single value every position has.
+                d.min_sym_len = *data++;
+                return data;
+            }
+
+            // group_len is zero-terminated; the matching group_idx entry is
+            // the size of the table.
+            const auto end{std::find(d.group_len.begin(), d.group_len.end(), 0)};
+            const uint64_t tb_size{d.group_idx[end - d.group_len.begin()]};
+
+            d.block_size = std::size_t{1} << *data++;
+            d.span = std::size_t{1} << *data++;
+            d.sparse_index_size = static_cast<std::size_t>(
+                (tb_size + d.span - 1) / d.span);
+            const uint8_t padding{*data++};
+            d.num_blocks = read_le32(data);
+            data += 4;
+            // Padded so that the sparse index never points past the end.
+            d.block_length_size = d.num_blocks + padding;
+            d.max_sym_len = *data++;
+            d.min_sym_len = *data++;
+            d.lowest_sym = data;
+            d.base64.assign(static_cast<std::size_t>(d.max_sym_len - d.min_sym_len + 1), 0);
+
+            // Longer codes have lower values in a canonical Huffman code, so
+            // base64[i] holds the lowest code of length min_sym_len + i,
+            // left-aligned in 64 bits.
+            for (int i = static_cast<int>(d.base64.size()) - 2; i >= 0; --i) {
+                d.base64[i] = (d.base64[i + 1] + read_le16(d.lowest_sym + 2 * i) -
+                               read_le16(d.lowest_sym + 2 * (i + 1))) / 2;
+            }
+            for (std::size_t i = 0; i < d.base64.size(); ++i) {
+                d.base64[i] <<= 64 - i - static_cast<std::size_t>(d.min_sym_len);
+            }
+
+            data += d.base64.size() * sizeof(Sym);
+            d.symlen.assign(read_le16(data), 0);
+            data += 2;
+            d.btree = data;
+
+            // Symbols expand recursively into pairs of symbols ("Recursive
+            // Pairing"); symlen is the number of values a symbol stands
+            // for, minus one.
+            std::vector<bool> visited(d.symlen.size());
+            for (Sym sym = 0; sym < d.symlen.size(); ++sym) {
+                if (!visited[sym]) {
+                    d.symlen[sym] = set_symlen(d, sym, visited);
+                }
+            }
+            return data + d.symlen.size() * 3 + (d.symlen.size() & 1);
+        }
+
+        void set_groups(const Table &table, PairsData &d, const std::array<int, 2> &order,
+                        const int &f) {
+            const IndexTables &t{index_tables()};
+            int n{0};
+            int first_len{table.has_pawns ? 0 : table.has_unique_pieces ? 3 : 2};
+            d.group_len[n] = 1;
+
+            // Pieces of the same kind form a group; the leading group has
+            // the first two or three pieces when there are no pawns.
+            for (int i = 1; i < table.piece_count; ++i) {
+                if (--first_len > 0 || d.pieces[i] == d.pieces[i - 1]) {
+                    d.group_len[n]++;
+                } else {
+                    d.group_len[++n] = 1;
+                }
+            }
+            d.group_len[++n] = 0;
+
+            // The groups are combined in a per-table order: the index is
+            // g1 * N(g2) * N(g3) + g2 * N(g3) + g3, where N(g) counts the
+            // placements of group g.
+            const bool pp{table.has_pawns && table.pawn_count[1] > 0};
+            int next{pp ? 2 : 1};
+            int free_squares{64 - d.group_len[0] - (pp ? d.group_len[1] : 0)};
+            uint64_t idx{1};
+
+            for (int k = 0; next < n || k == order[0] || k == order[1]; ++k) {
+                if (k == order[0]) {
+                    d.group_idx[0] = idx;
+                    idx *= table.has_pawns
+                               ? t.lead_pawns_size[d.group_len[0]][f]
+                               : table.has_unique_pieces ? 31332 : 462;
+                } else if (k == order[1]) {
+                    d.group_idx[1] = idx;
+                    idx *= t.binomial[d.group_len[1]][48 - d.group_len[0]];
+                } else {
+                    d.group_idx[next] = idx;
+                    idx *= t.binomial[d.group_len[next]][free_squares];
+                    free_squares -= d.group_len[next++];
+                }
+            }
+            d.group_idx[n] = idx;
+        }
+
+        const uint8_t *set_dtz_map(Table &table, TableFile &file,
+                                   const uint8_t *data, const int &max_file) {
+            file.map = data;
+            for (int f = 0; f <= max_file; ++f) {
+                PairsData &d{*table.get(file, 0, f)};
+                if (!(d.flags & FLAG_MAPPED)) {
+                    continue;
+                }
+                if (d.flags & FLAG_WIDE) {
+                    // Word alignment; a table may mix both kinds of maps.
+                    data += reinterpret_cast<uintptr_t>(data) & 1;
+                    for (int i = 0; i < 4; ++i) {
+                        d.map_idx[i] = static_cast<uint16_t>(
+                            (data - file.map) / 2 + 1);
+                        data += 2 * read_le16(data) + 2;
+                    }
+                } else {
+                    for (int i = 0; i < 4; ++i) {
+                        d.map_idx[i] = static_cast<uint16_t>(data - file.map + 1);
+                        data += *data + 1;
+                    }
+                }
+            }
+            return data + (reinterpret_cast<uintptr_t>(data) & 1);
+        }
+
+        // Decodes the header of a mapped file, past its magic.
+        void set(Table &table, TableFile &file, const uint8_t *data) {
+            ++data; // Split and has-pawns flags, known from the name.
+
+            const int sides{!file.dtz && table.key != table.key2 ? 2 : 1};
+            const int max_file{table.has_pawns ? 3 : 0};
+            const bool pp{table.has_pawns && table.pawn_count[1] > 0};
+
+            for (int f = 0; f <= max_file; ++f) {
+                for (int i = 0; i < sides; ++i) {
+                    *table.get(file, i, f) = PairsData{};
+                }
+                const std::array<std::array<int, 2>, 2> order{
+                    {
+                        {*data & 0xF, pp ? *(data + 1) & 0xF : 0xF},
+                        {*data >> 4, pp ? *(data + 1) >> 4 : 0xF}
+                    }
+                };
+                data += 1 + (pp ? 1 : 0);
+
+                for (int k = 0; k < table.piece_count; ++k, ++data) {
+                    for (int i = 0; i < sides; ++i) {
+                        table.get(file, i, f)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+                    }
+                }
+                for (int i = 0; i < sides; ++i) {
+                    set_groups(table, *table.get(file, i, f), order[i], f);
+                }
+            }
+
+            data += reinterpret_cast<uintptr_t>(data) & 1;
+
+            for (int f = 0; f <= max_file; ++f) {
+                for (int i = 0; i < sides; ++i) {
+                    data = set_sizes(*table.get(file, i, f), data);
+                }
+            }
+            if (file.dtz) {
+                data = set_dtz_map(table, file, data, max_file);
+            }
+            for (int f = 0; f <= max_file; ++f) {
+                for (int i = 0; i < sides; ++i) {
+                    PairsData &d{*table.get(file, i, f)};
+                    d.sparse_index = data;
+                    data += d.sparse_index_size * 6;
+                }
+            }
+            for (int f = 0; f <= max_file; ++f) {
+                for (int i = 0; i < sides; ++i) {
+                    PairsData &d{*table.get(file, i, f)};
+                    d.block_length = data;
+                    data += d.block_length_size * 2;
+                }
+            }
+            for (int f = 0; f <= max_file; ++f) {
+                for (int i = 0; i < sides; ++i) {
+                    // Blocks are 64-byte aligned.
+                    data = reinterpret_cast<const uint8_t *>(
+                        (reinterpret_cast<uintptr_t>(data) + 0x3F) & ~uintptr_t{0x3F});
+                    PairsData &d{*table.get(file, i, f)};
+                    d.data = data;
+                    data += static_cast<std::size_t>(d.num_blocks) * d.block_size;
+                }
+            }
+        }
+
+        // Value stored at position `idx` of the table.
+        int decompress_pairs(const PairsData &d, const uint64_t &idx) {
+            if (d.flags & FLAG_SINGLE_VALUE) {
+                return d.min_sym_len;
+            }
+
+            // The sparse index records, for every span-th value, the block
+            // that holds it and the offset within the block; from there the
+            // block lengths lead to the block holding idx.
+            const auto k{static_cast<uint32_t>(idx / d.span)};
+            uint32_t block{read_le32(d.sparse_index + 6 * k)};
+            int offset{read_le16(d.sparse_index + 6 * k + 4)};
+            offset += static_cast<int>(idx % d.span) - static_cast<int>(d.span / 2);
+
+            while (offset < 0) {
+                offset += read_le16(d.block_length + 2 * --block) + 1;
+            }
+            while (offset > read_le16(d.block_length + 2 * block)) {
+                offset -= read_le16(d.block_length + 2 * block++) + 1;
+            }
+
+            // Walk the Huffman-coded symbols of the block until reaching the
+            // one that covers the offset.
+            const uint8_t *ptr{d.data + static_cast<std::size_t>(block) * d.block_size};
+            uint64_t buf64{read_be64(ptr)};
+            ptr += 8;
+            int buf64_size{64};
+            Sym sym;
+
+            while (true) {
+                int len{0};
+                while (buf64 < d.base64[len]) {
+                    ++len;
+                }
+                sym = static_cast<Sym>((buf64 - d.base64[len]) >> (64 - len - d.min_sym_len));
+                sym = static_cast<Sym>(sym + read_le16(d.lowest_sym + 2 * len));
+
+                if (offset < d.symlen[sym] + 1) {
+                    break;
+                }
+                offset -= d.symlen[sym] + 1;
+                len += d.min_sym_len;
+                buf64 <<= len;
+                buf64_size -= len;
+
+                if (buf64_size <= 32) {
+                    buf64_size += 32;
+                    buf64 |= static_cast<uint64_t>(read_be32(ptr)) << (64 - buf64_size);
+                    ptr += 4;
+                }
+            }
+
+            // Expand the symbol down to the single value at the offset.
+            while (d.symlen[sym]) {
+                const Sym left{d.left(sym)};
+                if (offset < d.symlen[left] + 1) {
+                    sym = left;
+                } else {
+                    offset -= d.symlen[left] + 1;
+                    sym = d.right(sym);
+                }
+            }
+            return d.left(sym);
+        }
+
+        int map_score(Table &table, TableFile &file, const int &f, int value,
+                      const Wdl &wdl) {
+            if (!file.dtz) {
+                return value - 2;
+            }
+
+            constexpr std::array<int, 5> WDL_MAP{1, 3, 0, 2, 0};
+            const PairsData &d{*table.get(file, 0, f)};
+            if (d.flags & FLAG_MAPPED) {
+                const int index{d.map_idx[WDL_MAP[static_cast<int>(wdl) + 2]] + value};
+                value = d.flags & FLAG_WIDE
+                            ? read_le16(file.map + 2 * index)
+                            : file.map[index];
+            }
+
+            // DTZ may be stored in moves rather than plies.
+            if ((wdl == Wdl::WIN && !(d.flags & FLAG_WIN_PLIES)) ||
+                (wdl == Wdl::LOSS && !(d.flags & FLAG_LOSS_PLIES)) ||
+                wdl == Wdl::CURSED_WIN || wdl == Wdl::BLESSED_LOSS) {
+                value *= 2;
+            }
+            return value + 1;
+        }
+    }
+
+    // ---------------------- Tablebases ----------------------
+
+    Tablebases::Tablebases() = default;
+
+    Tablebases::Tablebases(const std::string &paths) {
+        init(paths);
+    }
+
+    Tablebases::~Tablebases() = default;
+
+    void Tablebases::init(const std::string &paths) {
+        tables.clear();
+        by_key.clear();
+        largest = 0;
+        if constexpr (!ENABLED) {
+            return;
+        }
+
+#ifdef _WIN32
+        constexpr char SEPARATOR{';'};
+#else
+        constexpr char SEPARATOR{':'};
+#endif
+        std::istringstream list{paths};
+        for (std::string directory; std::getline(list, directory, SEPARATOR);) {
+            std::error_code error{};
+            for (const auto &entry: std::filesystem::directory_iterator{directory, error}) {
+                const std::filesystem::path &path{entry.path()};
+                if (path.extension() != ".rtbw") {
+                    continue;
+                }
+                const std::string name{path.stem().string()};
+                const std::optional<Counts> counts{parse_name(name)};
+                if (!counts || by_key.contains(material_key(*counts))) {
+                    continue;
+                }
+
+                auto table{std::make_unique<Table>()};
+                table->name = name;
+                table->key = material_key(*counts);
+                table->key2 = material_key(swap_colors(*counts));
+                for (int i = 0; i < NUM_PIECE_BBS; ++i) {
+                    table->piece_count += (*counts)[i];
+                    // Kings are at index 5 and 11.
+                    if (i % 6 != 5 && (*counts)[i] == 1) {
+                        table->has_unique_pieces = true;
+                    }
+                }
+                const int white_pawns{(*counts)[0]}, black_pawns{(*counts)[6]};
+                table->has_pawns = white_pawns + black_pawns > 0;
+                // The leading color is the one with fewer pawns, if both have
+                // some, because that compresses better.
+                const bool white_leads{
+                    black_pawns == 0 ||
+                    (white_pawns > 0 && black_pawns >= white_pawns)
+                };
+                table->pawn_count = white_leads
+                                        ? std::array{white_pawns, black_pawns}
+                                        : std::array{black_pawns, white_pawns};
+
+                table->wdl.path = path.string();
+                table->dtz.path = (path.parent_path() / (name + ".rtbz")).string();
+                table->dtz.dtz = true;
+
+                largest = std::max(largest, table->piece_count);
+                by_key[table->key] = table.get();
+                by_key[table->key2] = table.get();
+                tables.push_back(std::move(table));
+            }
+        }
+    }
+
+    std::size_t Tablebases::size() const {
+        return tables.size();
+    }
+
+    int Tablebases::max_pieces() const {
+        return largest;
+    }
+
+    bool Tablebases::covers(const Board &board) const {
+        return popcount(board.occupancy()) <= largest &&
+               board.castling_rights() == 0;
+    }
+
+    bool Tablebases::map_file(Table &table, TableFile &file) const {
+        if (file.ready.load(std::memory_order_acquire)) {
+            return file.available;
+        }
+        std::lock_guard lock{file.mutex};
+        if (file.ready.load(std::memory_order_relaxed)) {
+            return file.available;
+        }
+
+        try {
+            file.file = MappedFile{file.path, MappedFile::Access::RANDOM};
+            const auto *data{reinterpret_cast<const uint8_t *>(file.file.data())};
+            const std::array<uint8_t, 4> &magic{file.dtz ? DTZ_MAGIC : WDL_MAGIC};
+            // Files consist of a 16-byte header and 64-byte aligned blocks.
+            if (file.file.size() % 64 == 16 &&
+                std::memcmp(data, magic.data(), magic.size()) == 0) {
+                set(table, file, data + magic.size());
+                file.available = true;
+            }
+        } catch (const std::invalid_argument &) {
+            // A missing file, typically DTZ tables that were not installed.
+        }
+        file.ready.store(true, std::memory_order_release);
+        return file.available;
+    }
+
+    int Tablebases::probe_table(Board &board, ProbeState &state, const bool &dtz,
+                                const Wdl &wdl) const {
+        const Counts counts{board_counts(board)};
+        const uint64_t key{material_key(counts)};
+        if (popcount(board.occupancy()) == 2) {
+            return static_cast<int>(Wdl::DRAW);
+        }
+        const auto found{by_key.find(key)};
+        if (found == by_key.end()) {
+            state = ProbeState::FAIL;
+            return 0;
+        }
+        Table &table{*found->second};
+        TableFile &file{dtz ? table.dtz : table.wdl};
+        if (!map_file(table, file)) {
+            state = ProbeState::FAIL;
+            return 0;
+        }
+
+        const IndexTables &t{index_tables()};
+        std::array<int, TB_PIECES> squares{};
+        std::array<int, TB_PIECES> pieces{};
+        int size{0}, lead_pawns_count{0};
+        Bitboard lead_pawns{EMPTY_BB};
+        int tb_file{0};
+
+        // Tables store the stronger side as white, and symmetric tables
+        // only white to move, so the position may need its colors swapped
+        // and the board flipped vertically.
+        const bool symmetric_black_to_move{table.key == table.key2 && !board.is_white_turn()};
+        const bool black_stronger{key != table.key};
+        const bool flip{symmetric_black_to_move || black_stronger};
+        const int flip_color{flip ? 8 : 0};
+        const int flip_squares{flip ? 56 : 0};
+        const int stm{(flip ? 1 : 0) ^ (board.is_white_turn() ? 0 : 1)};
+
+        auto pawns_less = [&t](const int &a, const int &b) {
+            return t.map_pawns[a] < t.map_pawns[b];
+        };
+
+        // With pawns there is one table per file of the leading pawn.
+        if (table.has_pawns) {
+            const int pawn{table.get(file, 0, 0)->pieces[0] ^ flip_color};
+            const bool white{pawn < 8};
+            Bitboard b{board.pieces(Piece{PieceType::PAWN, white})};
+            lead_pawns = b;
+            while (b) {
+                squares[size++] = pop_lsb(b) ^ flip_squares;
+            }
+            lead_pawns_count = size;
+            std::swap(squares[0], *std::max_element(
+                          squares.begin(), squares.begin() + lead_pawns_count, pawns_less));
+            tb_file = std::min(file_of(squares[0]), 7 - file_of(squares[0]));
+        }
+
+        // DTZ tables store only one side to move.
+        if (file.dtz) {
+            const uint8_t flags{table.get(file, stm, tb_file)->flags};
+            if ((flags & FLAG_STM) != stm && !(table.key == table.key2 && !table.has_pawns)) {
+                state = ProbeState::CHANGE_STM;
+                return 0;
+            }
+        }
+
+        Bitboard b{board.occupancy() ^ lead_pawns};
+        while (b) {
+            const int sq{pop_lsb(b)};
+            squares[size] = sq ^ flip_squares;
+            pieces[size++] = tb_piece(board.piece_on(sq)) ^ flip_color;
+        }
+
+        const PairsData &d{*table.get(file, stm, tb_file)};
+
+        // Order the pieces as the table does.
+        for (int i = lead_pawns_count; i < size - 1; ++i) {
+            for (int j = i + 1; j < size; ++j) {
+                if (d.pieces[i] == pieces[j]) {
+                    std::swap(pieces[i], pieces[j]);
+                    std::swap(squares[i], squares[j]);
+                    break;
+                }
+            }
+        }
+
+        // Mirror so that the leading piece is on files a-d.
+        if (file_of(squares[0]) > 3) {
+            for (int i = 0; i < size; ++i) {
+                squares[i] = flip_file(squares[i]);
+            }
+        }
+
+        uint64_t idx{};
+        if (table.has_pawns) {
+            idx = static_cast<uint64_t>(t.lead_pawn_idx[lead_pawns_count][squares[0]]);
+            std::stable_sort(squares.begin() + 1, squares.begin() + lead_pawns_count,
+                             pawns_less);
+            for (int i = 1; i < lead_pawns_count; ++i) {
+                idx += static_cast<uint64_t>(t.binomial[i][t.map_pawns[squares[i]]]);
+            }
+        } else {
+            // Without pawns, further mirror the leading piece below the
+            // 5th rank and below the a1-h8 diagonal.
+            if (rank_of(squares[0]) > 3) {
+                for (int i = 0; i < size; ++i) {
+                    squares[i] = flip_rank(squares[i]);
+                }
+            }
+            for (int i = 0; i < d.group_len[0]; ++i) {
+                if (!off_a1h8(squares[i])) {
+                    continue;
+                }
+                if (off_a1h8(squares[i]) > 0) {
+                    for (int j = i; j < size; ++j) {
+                        squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                    }
+                }
+                break;
+            }
+
+            if (table.has_unique_pieces) {
+                // Three unique pieces, kings included, are encoded together.
+                const int adjust1{squares[1] > squares[0]};
+                const int adjust2{(squares[2] > squares[0]) + (squares[2] > squares[1])};
+                if (off_a1h8(squares[0])) {
+                    idx = static_cast<uint64_t>(
+                        (t.map_a1d1d4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 +
+                        squares[2] - adjust2);
+                } else if (off_a1h8(squares[1])) {
+                    idx = static_cast<uint64_t>(
+                        (6 * 63 + rank_of(squares[0]) * 28 + t.map_b1h1h7[squares[1]]) * 62 +
+                        squares[2] - adjust2);
+                } else if (off_a1h8(squares[2])) {
+                    idx = static_cast<uint64_t>(
+                        6 * 63 * 62 + 4 * 28 * 62 + rank_of(squares[0]) * 7 * 28 +
+                        (rank_of(squares[1]) - adjust1) * 28 + t.map_b1h1h7[squares[2]]);
+                } else {
+                    idx = static_cast<uint64_t>(
+                        6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 +
+                        rank_of(squares[0]) * 7 * 6 + (rank_of(squares[1]) - adjust1) * 6 +
+                        (rank_of(squares[2]) - adjust2));
+                }
+            } else {
+                idx = static_cast<uint64_t>(t.map_kk[t.map_a1d1d4[squares[0]]][squares[1]]);
+            }
+        }
+
+        // Remaining groups, each by the combination of its squares, with
+        // squares taken by earlier groups skipped.
+        idx *= d.group_idx[0];
+        int group_start{d.group_len[0]};
+        bool remaining_pawns{table.has_pawns && table.pawn_count[1] > 0};
+        for (int next = 1; d.group_len[next]; ++next) {
+            const int len{d.group_len[next]};
+            std::stable_sort(squares.begin() + group_start,
+                             squares.begin() + group_start + len);
+            uint64_t n{0};
+            for (int i = 0; i < len; ++i) {
+                const int sq{squares[group_start + i]};
+                const auto adjust{
+                    std::count_if(squares.begin(), squares.begin() + group_start,
+                                  [&sq](const int &other) { return sq > other; })
+                };
+                n += static_cast<uint64_t>(
+                    t.binomial[i + 1][sq - adjust - (remaining_pawns ? 8 : 0)]);
+            }
+            remaining_pawns = false;
+            idx += n * d.group_idx[next];
+            group_start += len;
+        }
+
+        return map_score(table, file, tb_file, decompress_pairs(d, idx), wdl);
+    }
+
+    // Tables assume that captures are not the best moves, so captures (and,
+    // for DTZ, pawn moves) are searched explicitly first.
+    Wdl Tablebases::search(Board &board, ProbeState &state,
+                           const bool &check_zeroing_moves) const {
+        Wdl best{Wdl::LOSS};
+        MoveList moves;
+        board.generate_moves(moves);
+        std::size_t searched{0};
+
+        for (const Move &move: moves) {
+            if (!is_capture(board, move) &&
+                (!check_zeroing_moves ||
+                 board.piece_on(move.from()).type != PieceType::PAWN)) {
+                continue;
+            }
+            ++searched;
+            board.make_move(move);
+            const Wdl value{negate(search(board, state, false))};
+            board.unmake_move();
+
+            if (state == ProbeState::FAIL) {
+                return Wdl::DRAW;
+            }
+            if (value > best) {
+                best = value;
+                if (value >= Wdl::WIN) {
+                    state = ProbeState::ZEROING_BEST_MOVE;
+                    return value;
+                }
+            }
+        }
+
+        // With every legal move searched the table is not needed, which
+        // also covers en passant positions that tables do not store.
+        const bool no_more_moves{searched > 0 && searched == moves.size()};
+        Wdl value;
+        if (no_more_moves) {
+            value = best;
+        } else {
+            value = static_cast<Wdl>(probe_table(board, state, false, Wdl::DRAW));
+            if (state == ProbeState::FAIL) {
+                return Wdl::DRAW;
+            }
+        }
+
+        if (best >= value) {
+            state = best > Wdl::DRAW || no_more_moves
+                        ? ProbeState::ZEROING_BEST_MOVE
+                        : ProbeState::OK;
+            return best;
+        }
+        state = ProbeState::OK;
+        return value;
+    }
+
+    std::optional<Wdl> Tablebases::probe_wdl(Board &board) const {
+        if (!covers(board)) {
+            return std::nullopt;
+        }
+        ProbeState state{ProbeState::OK};
+        const Wdl wdl{search(board, state, false)};
+        if (state == ProbeState::FAIL) {
+            return std::nullopt;
+        }
+        return wdl;
+    }
+
+    int Tablebases::probe_dtz_internal(Board &board, ProbeState &state) const {
+        state = ProbeState::OK;
+        const Wdl wdl{search(board, state, true)};
+        if (state == ProbeState::FAIL || wdl == Wdl::DRAW) {
+            return 0;
+        }
+        if (state == ProbeState::ZEROING_BEST_MOVE) {
+            return dtz_before_zeroing(wdl);
+        }
+
+        const int dtz{probe_table(board, state, true, wdl)};
+        if (state == ProbeState::FAIL) {
+            return 0;
+        }
+        if (state != ProbeState::CHANGE_STM) {
+            const bool fifty_move{wdl == Wdl::BLESSED_LOSS || wdl == Wdl::CURSED_WIN};
+            return (dtz + (fifty_move ? 100 : 0)) * sign_of(static_cast<int>(wdl));
+        }
+
+        // The table stores the other side to move: search one ply and take
+        // the quickest win.
+        int min_dtz{0xFFFF};
+        MoveList moves;
+        board.generate_moves(moves);
+        for (const Move &move: moves) {
+            const bool zeroing{is_zeroing(board, move)};
+            board.make_move(move);
+
+            int value{
+                zeroing
+                    ? -dtz_before_zeroing(search(board, state, false))
+                    : -probe_dtz_internal(board, state)
+            };
+            if (value == 1 && board.checkers()) {
+                MoveList replies;
+                board.generate_moves(replies);
+                if (replies.empty()) {
+                    min_dtz = 1;
+                }
+            }
+            if (!zeroing) {
+                value += sign_of(value);
+            }
+            if (value < min_dtz && sign_of(value) == sign_of(static_cast<int>(wdl))) {
+                min_dtz = value;
+            }
+            board.unmake_move();
+
+            if (state == ProbeState::FAIL) {
+                return 0;
+            }
+        }
+        // Without legal moves, the side to move is mated.
+        return min_dtz == 0xFFFF ? -1 : min_dtz;
+    }
+
+    std::optional<int> Tablebases::probe_dtz(Board &board) const {
+        if (!covers(board)) {
+            return std::nullopt;
+        }
+        ProbeState state{ProbeState::OK};
+        const int dtz{probe_dtz_internal(board, state)};
+        if (state == ProbeState::FAIL) {
+            return std::nullopt;
+        }
+        return dtz;
+    }
+
+    std::optional<RootProbe> Tablebases::probe_root(Board &board) const {
+        if (!covers(board)) {
+            return std::nullopt;
+        }
+        const int halfmove{board.halfmove_clock()};
+        MoveList moves;
+        board.generate_moves(moves);
+        if (moves.empty()) {
+            return std::nullopt;
+        }
+
+        std::optional<RootProbe> best{};
+        int best_rank{0};
+        for (const Move &move: moves) {
+            board.make_move(move);
+            ProbeState state{ProbeState::OK};
+            int dtz;
+            if (board.halfmove_clock() == 0) {
+                // A zeroing move: only the outcome after it matters.
+                dtz = dtz_before_zeroing(negate(search(board, state, false)));
+            } else {
+                dtz = -probe_dtz_internal(board, state);
+                dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : 0;
+            }
+            if (dtz == 2 && board.checkers()) {
+                MoveList replies;
+                board.generate_moves(replies);
+                if (replies.empty()) {
+                    dtz = 1;
+                }
+            }
+            board.unmake_move();
+            if (state == ProbeState::FAIL) {
+                return std::nullopt;
+            }
+
+            // Rank moves by outcome under the fifty-move rule, preferring
+            // quick wins and slow losses.
+            const int rank{
+                dtz > 0
+                    ? (dtz + halfmove <= 99 ? MAX_DTZ : MAX_DTZ - (dtz + halfmove))
+                    : dtz < 0
+                          ? (-dtz * 2 + halfmove < 100 ? -MAX_DTZ : -MAX_DTZ + (-dtz + halfmove))
+                          : 0
+            };
+            const bool better{
+                !best || rank > best_rank ||
+                (rank == best_rank && rank > 0 && dtz < best->dtz) ||
+                (rank == best_rank && rank < 0 && dtz < best->dtz)
+            };
+            if (better) {
+                const Wdl wdl{
+                    rank == MAX_DTZ
+                        ? Wdl::WIN
+                        : rank > 0
+                              ? Wdl::CURSED_WIN
+                              : rank == 0
+                                    ? Wdl::DRAW
+                                    : rank == -MAX_DTZ
+                                          ? Wdl::LOSS
+                                          : Wdl::BLESSED_LOSS
+                };
+                best = RootProbe{move, wdl, dtz};
+                best_rank = rank;
+            }
+        }
+        return best;
+    }
+}
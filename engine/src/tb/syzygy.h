@@ -0,0 +1,128 @@
+#ifndef SYZYGY_H
+#define SYZYGY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "chess/board.h"
+#include "chess/move.h"
+
+namespace syzygy {
+    // Whether probing is built in, see the ENGINE_SYZYGY option. Without it,
+    // no table is ever registered.
+#ifdef ENGINE_SYZYGY
+    constexpr bool ENABLED{true};
+#else
+    constexpr bool ENABLED{false};
+#endif
+
+    // Game-theoretic value for the side to move. Cursed wins and blessed
+    // losses are wins and losses that the fifty-move rule turns into draws.
+    enum class Wdl : int8_t {
+        LOSS = -2,
+        BLESSED_LOSS = -1,
+        DRAW = 0,
+        CURSED_WIN = 1,
+        WIN = 2
+    };
+
+    struct RootProbe {
+        Move move;
+        // Value after `move` under the fifty-move rule, for the side to move.
+        Wdl wdl;
+        // Plies to the next capture or pawn move along the optimal line,
+        // positive when winning, negative when losing, 0 for draws.
+        int dtz;
+    };
+
+    // Compressed data of one table for one side to move and one leading
+    // pawn file.
+    struct PairsData;
+
+    // A WDL (.rtbw) or DTZ (.rtbz) file, mapped and decoded on first use.
+    struct TableFile;
+
+    // One material configuration, such as KRvK, covering both colors.
+    struct Table;
+
+    // Probing of Syzygy endgame tablebases. Tables are registered by name
+    // when the directories are scanned, but each file is only mapped and
+    // its header decoded when a position first needs it, so that startup
+    // stays cheap even with thousands of tables. Probing is thread-safe
+    // and, after a table is first used, does not allocate. engine_tbcheck
+    // compares the probes with solved 3-piece endgames and reference
+    // positions.
+    class Tablebases {
+    public:
+        Tablebases();
+
+        // Registers every table found in the given directories, separated
+        // by ':' (';' on Windows). Registers nothing unless ENABLED.
+        explicit Tablebases(const std::string &paths);
+
+        Tablebases(const Tablebases &) = delete;
+
+        Tablebases &operator=(const Tablebases &) = delete;
+
+        ~Tablebases();
+
+        // Replaces the registered tables. Must not be called while another
+        // thread is probing.
+        void init(const std::string &paths);
+
+        // Number of registered WDL tables.
+        [[nodiscard]] std::size_t size() const;
+
+        // Most pieces, kings included, in any registered table; positions
+        // with more pieces cannot be probed.
+        [[nodiscard]] int max_pieces() const;
+
+        // Whether the position is small enough and has no castling rights.
+        [[nodiscard]] bool covers(const Board &board) const;
+
+        // WDL value for the side to move, or nothing if a table is missing.
+        // The board is searched through captures and returned unchanged.
+        std::optional<Wdl> probe_wdl(Board &board) const;
+
+        // Distance to zeroing in plies, signed like RootProbe::dtz, or
+        // nothing if a table is missing. Needs the DTZ tables.
+        std::optional<int> probe_dtz(Board &board) const;
+
+        // The move that wins fastest or loses slowest, respecting the
+        // fifty-move rule, or nothing if the position cannot be probed.
+        std::optional<RootProbe> probe_root(Board &board) const;
+
+    private:
+        enum class ProbeState {
+            FAIL,
+            OK,
+            // The DTZ table only stores the other side to move.
+            CHANGE_STM,
+            // The best move is a capture or pawn move, whose value the
+            // table does not store.
+            ZEROING_BEST_MOVE
+        };
+
+        Wdl search(Board &board, ProbeState &state,
+                   const bool &check_zeroing_moves) const;
+
+        int probe_dtz_internal(Board &board, ProbeState &state) const;
+
+        int probe_table(Board &board, ProbeState &state, const bool &dtz,
+                        const Wdl &wdl) const;
+
+        bool map_file(Table &table, TableFile &file) const;
+
+        std::vector<std::unique_ptr<Table> > tables{};
+        // Both material keys of every table.
+        std::unordered_map<uint64_t, Table *> by_key{};
+        int largest{0};
+    };
+}
+
+#endif //SYZYGY_H
@@ -0,0 +1,450 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "chess/board.h"
+#include "tb/syzygy.h"
+
+namespace {
+    constexpr uint32_t NUM_STATES{NUM_SQUARES * NUM_SQUARES * NUM_SQUARES * 2};
+    constexpr uint32_t NO_TARGET{UINT32_MAX};
+
+    // Values of a state for its side to move.
+    constexpr int8_t LOSS{-1};
+    constexpr int8_t DRAW{0};
+    constexpr int8_t WIN{1};
+    constexpr int8_t UNKNOWN{2};
+    constexpr int8_t ILLEGAL{3};
+
+    constexpr uint8_t NO_DTZ{UINT8_MAX};
+
+    // Mismatches printed per endgame; the rest are only counted.
+    constexpr uint64_t MAX_REPORTS{10};
+
+    // A position of a 3-piece endgame: both kings and one white piece, with
+    // either side to move.
+    struct State {
+        int white_king;
+        int black_king;
+        int piece;
+        bool white;
+    };
+
+    uint32_t index_of(const State &state) {
+        return ((state.white_king * NUM_SQUARES + state.black_king) * NUM_SQUARES +
+                state.piece) * 2 + (state.white ? 0 : 1);
+    }
+
+    State state_of(const uint32_t &index) {
+        return {
+            static_cast<int>(index / 2 / NUM_SQUARES / NUM_SQUARES),
+            static_cast<int>(index / 2 / NUM_SQUARES % NUM_SQUARES),
+            static_cast<int>(index / 2 % NUM_SQUARES),
+            index % 2 == 0
+        };
+    }
+
+    // FEN of the state. Mirrored swaps the colors and flips the ranks, which
+    // leaves every value unchanged.
+    std::string fen_of(const State &state, const PieceType &type,
+                       const bool &mirrored) {
+        std::array<char, NUM_SQUARES> cells{};
+        cells.fill(' ');
+        const char piece{
+            type == PieceType::QUEEN ? 'Q' : type == PieceType::ROOK ? 'R' : 'P'
+        };
+        const int flip{mirrored ? 56 : 0};
+        cells[state.white_king ^ flip] = mirrored ? 'k' : 'K';
+        cells[state.black_king ^ flip] = mirrored ? 'K' : 'k';
+        cells[state.piece ^ flip] = mirrored ? static_cast<char>(piece + 'a' - 'A') : piece;
+
+        std::string fen{};
+        for (int rank = 7; rank >= 0; --rank) {
+            int empty{0};
+            for (int file = 0; file < 8; ++file) {
+                const char cell{cells[rank * 8 + file]};
+                if (cell == ' ') {
+                    ++empty;
+                    continue;
+                }
+                if (empty > 0) {
+                    fen += static_cast<char>('0' + empty);
+                    empty = 0;
+                }
+                fen += cell;
+            }
+            if (empty > 0) {
+                fen += static_cast<char>('0' + empty);
+            }
+            if (rank > 0) {
+                fen += '/';
+            }
+        }
+        fen += state.white != mirrored ? " w - - 0 1" : " b - - 0 1";
+        return fen;
+    }
+
+    // KQvK, KRvK or KPvK, solved by retrograde analysis: the value of every
+    // state, and its distance to zeroing in plies, counting mate as zeroing.
+    struct Endgame {
+        std::string name;
+        PieceType type;
+        std::vector<int8_t> wdl{};
+        std::vector<uint8_t> dtz{};
+    };
+
+    // One move of a state: the state it leads to, or its value if it leaves
+    // the endgame by a capture or promotion.
+    struct Edge {
+        uint32_t target;
+        int8_t value;
+        bool zeroing;
+    };
+
+    // The board after a move of a state of `endgame`, as seen by its side
+    // to move. Promotions are looked up in the endgames already solved.
+    Edge classify(const Board &board, const Endgame &endgame,
+                  const std::vector<const Endgame *> &solved,
+                  const bool &zeroing) {
+        if (popcount(board.occupancy()) == 2) {
+            return {NO_TARGET, DRAW, zeroing};
+        }
+        const int white_king{board.king_square(true)};
+        const int sq{lsb(board.occupancy(true) & ~square_bb(white_king))};
+        const uint32_t index{
+            index_of({white_king, board.king_square(false), sq, board.is_white_turn()})
+        };
+        const PieceType type{board.piece_on(sq).type};
+        if (type == endgame.type) {
+            return {index, UNKNOWN, zeroing};
+        }
+        const auto found{std::ranges::find_if(solved, [&](const Endgame *other) {
+            return other->type == type;
+        })};
+        // Promotions to a bishop or knight cannot win.
+        return {NO_TARGET, found != solved.end() ? (*found)->wdl[index] : DRAW, true};
+    }
+
+    Endgame solve(const std::string &name, const PieceType &type,
+                  const std::vector<const Endgame *> &solved) {
+        Endgame endgame{name, type};
+        endgame.wdl.assign(NUM_STATES, ILLEGAL);
+        endgame.dtz.assign(NUM_STATES, NO_DTZ);
+
+        // Moves of every state, in one array.
+        std::vector<uint32_t> first{};
+        std::vector<Edge> edges{};
+        first.reserve(NUM_STATES + 1);
+
+        Board board{};
+        MoveList moves;
+        for (uint32_t index = 0; index < NUM_STATES; ++index) {
+            first.push_back(static_cast<uint32_t>(edges.size()));
+            const State state{state_of(index)};
+            if (state.white_king == state.black_king || state.piece == state.white_king ||
+                state.piece == state.black_king) {
+                continue;
+            }
+            if (type == PieceType::PAWN &&
+                (rank_of(state.piece) == 0 || rank_of(state.piece) == 7)) {
+                continue;
+            }
+            if (!board.set_fen(fen_of(state, type, false)) ||
+                board.in_check(!state.white)) {
+                continue;
+            }
+
+            board.generate_moves(moves);
+            if (moves.empty()) {
+                endgame.wdl[index] = board.in_check(state.white) ? LOSS : DRAW;
+                endgame.dtz[index] = 0;
+                continue;
+            }
+            endgame.wdl[index] = UNKNOWN;
+            for (const Move &move: moves) {
+                board.make_move(move);
+                edges.push_back(classify(board, endgame, solved,
+                                         board.halfmove_clock() == 0));
+                board.unmake_move();
+            }
+        }
+        first.push_back(static_cast<uint32_t>(edges.size()));
+
+        auto value = [&](const Edge &edge) {
+            return edge.target == NO_TARGET ? edge.value : endgame.wdl[edge.target];
+        };
+
+        // A state is won if a move reaches a lost state, and lost if every
+        // move reaches a won one; what remains is drawn.
+        for (bool changed{true}; changed;) {
+            changed = false;
+            for (uint32_t index = 0; index < NUM_STATES; ++index) {
+                if (endgame.wdl[index] != UNKNOWN) {
+                    continue;
+                }
+                bool win{false};
+                bool loss{true};
+                for (uint32_t i = first[index]; i < first[index + 1]; ++i) {
+                    const int8_t after{value(edges[i])};
+                    win |= after == LOSS;
+                    loss &= after == WIN;
+                }
+                if (win || loss) {
+                    endgame.wdl[index] = win ? WIN : LOSS;
+                    changed = true;
+                }
+            }
+        }
+        std::ranges::replace(endgame.wdl, UNKNOWN, DRAW);
+
+        // Distances one ply at a time: a win takes the quickest move to a
+        // lost state, a loss the slowest move. Zeroing moves end the count.
+        for (int ply = 1; ply < NO_DTZ; ++ply) {
+            std::vector<uint32_t> reached{};
+            for (uint32_t index = 0; index < NUM_STATES; ++index) {
+                const int8_t wdl{endgame.wdl[index]};
+                if ((wdl != WIN && wdl != LOSS) || endgame.dtz[index] != NO_DTZ) {
+                    continue;
+                }
+                bool any{false};
+                bool all{true};
+                for (uint32_t i = first[index]; i < first[index + 1]; ++i) {
+                    const Edge &edge{edges[i]};
+                    const bool near{edge.zeroing || endgame.dtz[edge.target] < ply};
+                    any |= near && value(edge) == LOSS;
+                    all &= near;
+                }
+                if (wdl == WIN ? any : all) {
+                    reached.push_back(index);
+                }
+            }
+            if (reached.empty()) {
+                break;
+            }
+            for (const uint32_t &index: reached) {
+                endgame.dtz[index] = static_cast<uint8_t>(ply);
+            }
+        }
+        return endgame;
+    }
+
+    void print_solution(const Endgame &endgame) {
+        std::array<uint64_t, 3> counts{};
+        int longest{0};
+        for (uint32_t index = 0; index < NUM_STATES; index += 2) {
+            const int8_t wdl{endgame.wdl[index]};
+            if (wdl == ILLEGAL) {
+                continue;
+            }
+            ++counts[wdl + 1];
+            if (wdl == WIN) {
+                longest = std::max<int>(longest, endgame.dtz[index]);
+            }
+        }
+        std::cout << endgame.name << " with white to move: " << counts[2] << " wins, "
+                << counts[1] << " draws, " << counts[0] << " losses, longest win "
+                << longest << " plies to zeroing\n";
+    }
+
+    // Probes every state of the endgame, in both colors, and compares WDL,
+    // DTZ and the root move with the solution. DTZ may be one ply longer
+    // than the solution for tables that store it in moves.
+    bool check(const Endgame &endgame, const std::vector<const Endgame *> &solved,
+               const syzygy::Tablebases &tablebases) {
+        Board board{};
+        uint64_t probed{0};
+        uint64_t failed{0};
+        bool has_dtz{true};
+        auto report = [&](const std::string &fen, const std::string &what) {
+            if (++failed <= MAX_REPORTS) {
+                std::cout << "[FAIL] " << endgame.name << ' ' << what << " in " << fen
+                        << '\n';
+            }
+        };
+
+        for (uint32_t index = 0; index < NUM_STATES; ++index) {
+            const int8_t expected{endgame.wdl[index]};
+            if (expected == ILLEGAL) {
+                continue;
+            }
+            const int plies{endgame.dtz[index]};
+            for (const bool mirrored: {false, true}) {
+                const std::string fen{fen_of(state_of(index), endgame.type, mirrored)};
+                board.set_fen(fen);
+
+                const std::optional<syzygy::Wdl> wdl{tablebases.probe_wdl(board)};
+                if (!wdl) {
+                    if (probed == 0) {
+                        std::cout << "[SKIP] " << endgame.name << ": no WDL table\n";
+                        return true;
+                    }
+                    report(fen, "WDL probe failed");
+                    continue;
+                }
+                ++probed;
+                if (static_cast<int>(*wdl) != 2 * expected) {
+                    report(fen, "WDL " + std::to_string(static_cast<int>(*wdl)) +
+                                " (expected " + std::to_string(2 * expected) + ")");
+                }
+                // Mates and stalemates have no move to measure.
+                if (plies == 0) {
+                    continue;
+                }
+
+                if (has_dtz) {
+                    const std::optional<int> dtz{tablebases.probe_dtz(board)};
+                    if (!dtz) {
+                        std::cout << "[SKIP] " << endgame.name << ": no DTZ table\n";
+                        has_dtz = false;
+                    } else if (expected == DRAW
+                                   ? *dtz != 0
+                                   : *dtz * expected < plies || *dtz * expected > plies + 1) {
+                        report(fen, "DTZ " + std::to_string(*dtz) + " (expected " +
+                                    std::to_string(expected * plies) + ")");
+                    }
+                }
+
+                if (!has_dtz || mirrored || expected == DRAW) {
+                    continue;
+                }
+                const std::optional<syzygy::RootProbe> root{tablebases.probe_root(board)};
+                if (!root) {
+                    report(fen, "root probe failed");
+                    continue;
+                }
+                board.make_move(root->move);
+                const Edge edge{classify(board, endgame, solved, false)};
+                const int8_t after{
+                    edge.target == NO_TARGET ? edge.value : endgame.wdl[edge.target]
+                };
+                if (after != -expected || static_cast<int>(root->wdl) != 2 * expected) {
+                    report(fen, "root move " + root->move.to_string());
+                }
+            }
+        }
+
+        std::cout << (failed == 0 ? "[ OK ] " : "[FAIL] ") << endgame.name << ": "
+                << failed << " mismatches in " << probed << " positions\n";
+        return failed == 0;
+    }
+
+    // A probe whose value follows from the position alone: a capture that
+    // wins, or one that leaves bare kings.
+    struct ReferenceProbe {
+        const char *fen;
+        syzygy::Wdl wdl;
+        // Expected DTZ, if the first move decides it.
+        std::optional<int> dtz;
+    };
+
+    // The KQvKR positions need the 4-piece tables. The KRvK ones are also
+    // covered by the solution, but are checked here independently of it.
+    const std::array<ReferenceProbe, 7> REFERENCE_PROBES{
+        {
+            // Qxa8+ and Rxa1+ each win with the lone king far away.
+            {"r3k3/8/8/8/8/8/8/Q3K3 w - - 0 1", syzygy::Wdl::WIN, 1},
+            {"r3k3/8/8/8/8/8/8/Q3K3 b - - 0 1", syzygy::Wdl::WIN, 1},
+            // Kxd2 wins; Rxd1+ Kxd1 leaves bare kings.
+            {"4k3/8/8/8/8/8/3r4/3QK3 w - - 0 1", syzygy::Wdl::WIN, 1},
+            {"4k3/8/8/8/8/8/3r4/3QK3 b - - 0 1", syzygy::Wdl::DRAW, 0},
+            // Kxh2 draws at once; Rh8 mates.
+            {"8/8/8/8/8/8/6kR/K7 b - - 0 1", syzygy::Wdl::DRAW, 0},
+            {"k7/8/1K6/8/8/8/8/7R w - - 0 1", syzygy::Wdl::WIN, std::nullopt},
+            {"k7/8/1K6/8/8/8/8/7R b - - 0 1", syzygy::Wdl::LOSS, std::nullopt},
+        }
+    };
+
+    // Probes the reference positions, skipping those without a table.
+    bool check_references(const syzygy::Tablebases &tablebases) {
+        Board board{};
+        int probed{0};
+        bool passed{true};
+        for (const auto &[fen, expected_wdl, expected_dtz]: REFERENCE_PROBES) {
+            board.set_fen(fen);
+            const std::optional<syzygy::Wdl> wdl{tablebases.probe_wdl(board)};
+            if (!wdl) {
+                std::cout << "[SKIP] reference " << fen << ": no WDL table\n";
+                continue;
+            }
+            ++probed;
+            if (*wdl != expected_wdl) {
+                std::cout << "[FAIL] reference WDL " << static_cast<int>(*wdl)
+                        << " (expected " << static_cast<int>(expected_wdl) << ") in "
+                        << fen << '\n';
+                passed = false;
+            }
+            if (!expected_dtz) {
+                continue;
+            }
+            const std::optional<int> dtz{tablebases.probe_dtz(board)};
+            if (!dtz) {
+                std::cout << "[SKIP] reference " << fen << ": no DTZ table\n";
+            } else if (*dtz != *expected_dtz) {
+                std::cout << "[FAIL] reference DTZ " << *dtz << " (expected "
+                        << *expected_dtz << ") in " << fen << '\n';
+                passed = false;
+            }
+        }
+        std::cout << (passed ? "[ OK ] " : "[FAIL] ") << "reference probes: "
+                << probed << " of " << REFERENCE_PROBES.size() << " positions probed\n";
+        return passed;
+    }
+
+    void print_usage() {
+        std::cout
+                << "Usage: engine_tbcheck [options]\n"
+                << "  --syzygy <paths>   tablebase directories, separated by ':', holding\n"
+                << "                     KQvK, KRvK and KPvK, and KQvKR for the reference\n"
+                << "                     probes; without it the endgames are only solved\n";
+    }
+}
+
+int main(const int argc, char **argv) {
+    std::string paths{};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg == "--syzygy" && i + 1 < argc) {
+            paths = argv[++i];
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (!paths.empty() && !syzygy::ENABLED) {
+        std::cerr << "Built without ENGINE_SYZYGY; tablebases cannot be probed\n";
+        return EXIT_FAILURE;
+    }
+
+    // Pawn endgames promote into the others, which are solved first.
+    std::vector<Endgame> endgames{};
+    endgames.reserve(3);
+    std::vector<const Endgame *> solved{};
+    for (const auto &[name, type]: {
+             std::pair{"KQvK", PieceType::QUEEN}, std::pair{"KRvK", PieceType::ROOK},
+             std::pair{"KPvK", PieceType::PAWN}
+         }) {
+        endgames.push_back(solve(name, type, solved));
+        solved.push_back(&endgames.back());
+        print_solution(endgames.back());
+    }
+    if (paths.empty()) {
+        return EXIT_SUCCESS;
+    }
+
+    const syzygy::Tablebases tablebases{paths};
+    std::cout << "Found " << tablebases.size() << " tablebases, up to "
+            << tablebases.max_pieces() << " pieces\n";
+    bool passed{check_references(tablebases)};
+    for (const Endgame &endgame: endgames) {
+        passed &= check(endgame, solved, tablebases);
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
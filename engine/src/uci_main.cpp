@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "chess/board.h"
+#include "chess/tt.h"
+#include "search/parallel_search.h"
+
+namespace {
+    constexpr auto START_FEN{
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+    };
+
+    constexpr std::size_t DEFAULT_HASH_MB{16};
+    constexpr std::size_t MAX_HASH_MB{65536};
+    constexpr int MAX_THREADS{256};
+
+    // The input thread and the search thread both write to stdout; a line is
+    // written and flushed at once so that they never interleave.
+    std::mutex output_mutex{};
+
+    void send(const std::string &line) {
+        const std::lock_guard lock{output_mutex};
+        std::cout << line << std::endl;
+    }
+
+    // The legal move of the position written in long algebraic notation, or
+    // Move::none(). Compares squares rather than names, so nothing is
+    // allocated.
+    Move parse_move(const Board &board, const std::string_view &text) {
+        if (text.size() < 4 || text.size() > 5) {
+            return Move::none();
+        }
+        auto square = [&](const std::size_t &i) {
+            const int file{text[i] - 'a'};
+            const int rank{text[i + 1] - '1'};
+            return file >= 0 && file < 8 && rank >= 0 && rank < 8
+                       ? rank * 8 + file
+                       : NO_SQUARE;
+        };
+        const int from{square(0)};
+        const int to{square(2)};
+        PieceType promotion{PieceType::EMPTY};
+        if (text.size() == 5) {
+            switch (text[4]) {
+                case 'n':
+                    promotion = PieceType::KNIGHT;
+                    break;
+                case 'b':
+                    promotion = PieceType::BISHOP;
+                    break;
+                case 'r':
+                    promotion = PieceType::ROOK;
+                    break;
+                case 'q':
+                    promotion = PieceType::QUEEN;
+                    break;
+                default:
+                    return Move::none();
+            }
+        }
+
+        MoveList moves;
+        board.generate_moves(moves);
+        for (const Move &move: moves) {
+            const bool promotes{move.flag() == MoveFlag::PROMOTION};
+            if (move.from() == from && move.to() == to &&
+                promotes == (promotion != PieceType::EMPTY) &&
+                (!promotes || move.promotion() == promotion)) {
+                return move;
+            }
+        }
+        return Move::none();
+    }
+
+    // Centipawns, or moves to mate.
+    std::string uci_score(const int &score) {
+        if (score >= VALUE_MATE_IN_MAX_PLY) {
+            return "mate " + std::to_string((VALUE_MATE - score + 1) / 2);
+        }
+        if (score <= -VALUE_MATE_IN_MAX_PLY) {
+            return "mate " + std::to_string(-(VALUE_MATE + score) / 2);
+        }
+        return "cp " + std::to_string(score);
+    }
+
+    // The UCI session. The main thread reads and answers commands, while
+    // searches run on the pool's background thread and report from there,
+    // so no command waits for a search unless the protocol requires it.
+    class Session {
+    public:
+        Session() {
+            search.set_info_callback([](const SearchInfo &info) {
+                std::ostringstream out{};
+                out << "info depth " << info.depth << " seldepth " << info.seldepth
+                        << " score " << uci_score(info.score) << " nodes "
+                        << info.nodes << " nps " << info.nps << " hashfull "
+                        << info.hashfull << " tbhits " << info.tb_hits
+                        << " time " << info.time_ms << " pv";
+                for (const Move &move: info.pv) {
+                    out << ' ' << move.to_string();
+                }
+                send(out.str());
+            });
+        }
+
+        // Handles one command line; returns false on quit.
+        bool handle(const std::string &line) {
+            std::istringstream in{line};
+            std::string command{};
+            in >> command;
+
+            if (command == "uci") {
+                send("id name chess-arena");
+                send("id author the chess-arena authors");
+                send("option name Hash type spin default " +
+                     std::to_string(DEFAULT_HASH_MB) + " min 1 max " +
+                     std::to_string(MAX_HASH_MB));
+                send("option name Threads type spin default 1 min 1 max " +
+                     std::to_string(MAX_THREADS));
+                send("option name Ponder type check default false");
+                send("uciok");
+            } else if (command == "isready") {
+                send("readyok");
+            } else if (command == "setoption") {
+                set_option(in);
+            } else if (command == "ucinewgame") {
+                finish_search();
+                tt.clear();
+                search.clear();
+            } else if (command == "position") {
+                set_position(in);
+            } else if (command == "go") {
+                go(in);
+            } else if (command == "stop") {
+                search.stop();
+            } else if (command == "ponderhit") {
+                search.ponderhit();
+            } else if (command == "quit") {
+                finish_search();
+                return false;
+            } else if (!command.empty()) {
+                send("info string Unknown command " + command);
+            }
+            return true;
+        }
+
+        // Stops a search still running, e.g. at the end of the input.
+        void finish_search() {
+            search.stop();
+            static_cast<void>(search.wait());
+        }
+
+    private:
+        // setoption name <name> value <value>
+        void set_option(std::istringstream &in) {
+            std::string token{}, name{}, value{};
+            in >> token;
+            while (in >> token && token != "value") {
+                name += name.empty() ? token : " " + token;
+            }
+            in >> value;
+
+            // Neither table nor pool may change under a running search.
+            finish_search();
+            if (name == "Hash") {
+                tt.resize(std::clamp<std::size_t>(std::stoul(value), 1, MAX_HASH_MB));
+            } else if (name == "Threads") {
+                search.set_threads(std::clamp(std::stoi(value), 1, MAX_THREADS));
+            } else if (name != "Ponder") {
+                send("info string Unknown option " + name);
+            }
+        }
+
+        // position (startpos | fen <fen>) [moves <move>...]
+        //
+        // GUIs resend the whole game before every search. When the position
+        // is the last one with moves appended, only those are played, on
+        // the board as it is.
+        void set_position(std::istringstream &in) {
+            std::string token{}, base{};
+            in >> token;
+            if (token == "startpos") {
+                base = START_FEN;
+                in >> token;
+            } else if (token == "fen") {
+                while (in >> token && token != "moves") {
+                    base += base.empty() ? token : " " + token;
+                }
+            } else {
+                send("info string Expected startpos or fen");
+                return;
+            }
+
+            std::vector<std::string> moves{};
+            if (token == "moves") {
+                for (std::string move; in >> move;) {
+                    moves.push_back(std::move(move));
+                }
+            }
+
+            const bool extends{
+                base == position_base && moves.size() >= position_moves.size() &&
+                std::equal(position_moves.begin(), position_moves.end(),
+                           moves.begin())
+            };
+            if (!extends) {
+                if (!board.set_fen(base)) {
+                    send("info string Invalid FEN " + base);
+                    board.set_fen(START_FEN);
+                    base = START_FEN;
+                    moves.clear();
+                }
+                position_base = base;
+                position_moves.clear();
+            }
+
+            for (std::size_t i = position_moves.size(); i < moves.size(); ++i) {
+                const Move move{parse_move(board, moves[i])};
+                if (move.is_none()) {
+                    send("info string Illegal move " + moves[i]);
+                    break;
+                }
+                board.make_move(move);
+                position_moves.push_back(moves[i]);
+            }
+        }
+
+        void go(std::istringstream &in) {
+            finish_search();
+
+            SearchLimits limits{};
+            for (std::string token; in >> token;) {
+                auto number = [&] {
+                    std::string value{};
+                    in >> value;
+                    return std::stoll(value);
+                };
+                if (token == "wtime") {
+                    limits.time_ms[color_index(true)] = number();
+                } else if (token == "btime") {
+                    limits.time_ms[color_index(false)] = number();
+                } else if (token == "winc") {
+                    limits.increment_ms[color_index(true)] = number();
+                } else if (token == "binc") {
+                    limits.increment_ms[color_index(false)] = number();
+                } else if (token == "movestogo") {
+                    limits.moves_to_go = static_cast<int>(number());
+                } else if (token == "depth") {
+                    limits.depth = static_cast<int>(number());
+                } else if (token == "nodes") {
+                    limits.nodes = static_cast<uint64_t>(number());
+                } else if (token == "movetime") {
+                    limits.movetime_ms = number();
+                } else if (token == "infinite") {
+                    limits.infinite = true;
+                } else if (token == "ponder") {
+                    limits.ponder = true;
+                }
+            }
+
+            search.start(board, limits, [](const SearchResult &result) {
+                if (result.best_move.is_none()) {
+                    send("bestmove 0000");
+                    return;
+                }
+                std::string line{"bestmove " + result.best_move.to_string()};
+                if (!result.ponder_move.is_none()) {
+                    line += " ponder " + result.ponder_move.to_string();
+                }
+                send(line);
+            });
+        }
+
+        TranspositionTable tt{DEFAULT_HASH_MB};
+        ParallelSearch search{tt};
+        Board board{START_FEN};
+        // The last position command, for appending to it.
+        std::string position_base{START_FEN};
+        std::vector<std::string> position_moves{};
+    };
+}
+
+int main() {
+    // Reading cin would otherwise flush cout, which the search thread writes
+    // to under the output lock.
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
+    Session session{};
+    for (std::string line; std::getline(std::cin, line);) {
+        try {
+            if (!session.handle(line)) {
+                return EXIT_SUCCESS;
+            }
+        } catch (const std::exception &e) {
+            send(std::string{"info string "} + e.what());
+        }
+    }
+    session.finish_search();
+    return EXIT_SUCCESS;
+}
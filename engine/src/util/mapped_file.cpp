@@ -0,0 +1,132 @@
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+MappedFile::MappedFile(const std::string &path, const Access &access) {
+    const std::string error_msg{"Cannot map file " + path};
+#ifdef _WIN32
+    file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              access == Access::SEQUENTIAL
+                                  ? FILE_FLAG_SEQUENTIAL_SCAN
+                                  : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        throw std::invalid_argument(error_msg);
+    }
+    LARGE_INTEGER file_size{};
+    GetFileSizeEx(file_handle, &file_size);
+    length = static_cast<std::size_t>(file_size.QuadPart);
+    if (length > 0) {
+        mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY,
+                                            0, 0, nullptr);
+        void *view{
+            mapping_handle
+                ? MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0)
+                : nullptr
+        };
+        if (!view) {
+            unmap();
+            throw std::invalid_argument(error_msg);
+        }
+        memory = static_cast<const std::byte *>(view);
+    }
+#else
+    const int fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0) {
+        throw std::invalid_argument(error_msg);
+    }
+    struct stat status{};
+    if (fstat(fd, &status) != 0) {
+        ::close(fd);
+        throw std::invalid_argument(error_msg);
+    }
+    length = static_cast<std::size_t>(status.st_size);
+    // An empty file cannot be mapped, but is still a valid (empty) view.
+    if (length > 0) {
+        void *view{mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0)};
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            throw std::invalid_argument(error_msg);
+        }
+        madvise(view, length, access == Access::SEQUENTIAL
+                                  ? MADV_SEQUENTIAL
+                                  : MADV_RANDOM);
+        memory = static_cast<const std::byte *>(view);
+    }
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+#endif
+    open = true;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        unmap();
+        memory = std::exchange(other.memory, nullptr);
+        length = std::exchange(other.length, 0);
+        open = std::exchange(other.open, false);
+#ifdef _WIN32
+        file_handle = std::exchange(other.file_handle, nullptr);
+        mapping_handle = std::exchange(other.mapping_handle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+std::span<const std::byte> MappedFile::bytes() const {
+    return {memory, length};
+}
+
+const std::byte *MappedFile::data() const {
+    return memory;
+}
+
+std::size_t MappedFile::size() const {
+    return length;
+}
+
+bool MappedFile::is_open() const {
+    return open;
+}
+
+void MappedFile::unmap() {
+#ifdef _WIN32
+    if (memory) {
+        UnmapViewOfFile(memory);
+    }
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle) {
+        CloseHandle(file_handle);
+    }
+    file_handle = mapping_handle = nullptr;
+#else
+    if (memory) {
+        munmap(const_cast<std::byte *>(memory), length);
+    }
+#endif
+    memory = nullptr;
+    length = 0;
+    open = false;
+}
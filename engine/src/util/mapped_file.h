@@ -0,0 +1,53 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+// Read-only memory mapping of a whole file. The mapping lives as long as
+// the object; pages are loaded by the kernel on first access.
+class MappedFile {
+public:
+    enum class Access {
+        SEQUENTIAL,
+        RANDOM
+    };
+
+    MappedFile() = default;
+
+    // Throws std::invalid_argument if the file cannot be opened or mapped.
+    explicit MappedFile(const std::string &path,
+                        const Access &access = Access::RANDOM);
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    ~MappedFile();
+
+    [[nodiscard]] std::span<const std::byte> bytes() const;
+
+    [[nodiscard]] const std::byte *data() const;
+
+    [[nodiscard]] std::size_t size() const;
+
+    [[nodiscard]] bool is_open() const;
+
+private:
+    void unmap();
+
+    const std::byte *memory{nullptr};
+    std::size_t length{0};
+    bool open{false};
+#ifdef _WIN32
+    void *file_handle{nullptr};
+    void *mapping_handle{nullptr};
+#endif
+};
+
+#endif //MAPPED_FILE_H
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "stats.h"
+
+namespace stats {
+    namespace {
+        constexpr std::array<std::string_view, NUM_COUNTERS> COUNTER_NAMES{
+            "movegen_calls", "moves_generated", "legality_checks",
+            "attack_queries", "tt_probes", "tt_hits", "tt_collisions",
+            "evaluations", "nodes", "qnodes", "cutoffs", "first_move_cutoffs"
+        };
+
+        constexpr std::array<std::string_view, NUM_TIMERS> TIMER_NAMES{
+            "movegen", "legality", "attacks", "evaluation", "search"
+        };
+
+        double ratio(const uint64_t &part, const uint64_t &whole) {
+            return whole == 0 ? 0.0 : static_cast<double>(part) / whole;
+        }
+
+#ifdef ENGINE_STATS
+        void accumulate(Snapshot &total, const detail::Block &block) {
+            for (int i = 0; i < NUM_COUNTERS; ++i) {
+                total.counters[i] += block.counters[i].load(std::memory_order_relaxed);
+            }
+            for (int i = 0; i < NUM_TIMERS; ++i) {
+                total.nanoseconds[i] += block.nanoseconds[i].load(std::memory_order_relaxed);
+                total.scopes[i] += block.scopes[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        // Blocks of running threads, and the sum of those of finished ones.
+        struct Registry {
+            std::mutex mutex{};
+            std::vector<const detail::Block *> blocks{};
+            Snapshot retired{};
+        };
+
+        // Constructed by the first block, so it outlives every block.
+        Registry &registry() {
+            static Registry instance{};
+            return instance;
+        }
+#endif
+    }
+
+    uint64_t Snapshot::operator[](const Counter &counter) const {
+        return counters[static_cast<int>(counter)];
+    }
+
+    Snapshot Snapshot::operator-(const Snapshot &earlier) const {
+        Snapshot difference{*this};
+        for (int i = 0; i < NUM_COUNTERS; ++i) {
+            difference.counters[i] -= earlier.counters[i];
+        }
+        for (int i = 0; i < NUM_TIMERS; ++i) {
+            difference.nanoseconds[i] -= earlier.nanoseconds[i];
+            difference.scopes[i] -= earlier.scopes[i];
+        }
+        return difference;
+    }
+
+    Snapshot Snapshot::operator+(const Snapshot &other) const {
+        Snapshot sum{*this};
+        for (int i = 0; i < NUM_COUNTERS; ++i) {
+            sum.counters[i] += other.counters[i];
+        }
+        for (int i = 0; i < NUM_TIMERS; ++i) {
+            sum.nanoseconds[i] += other.nanoseconds[i];
+            sum.scopes[i] += other.scopes[i];
+        }
+        return sum;
+    }
+
+    std::string_view name(const Counter &counter) {
+        return COUNTER_NAMES[static_cast<int>(counter)];
+    }
+
+    std::string_view name(const Timer &timer) {
+        return TIMER_NAMES[static_cast<int>(timer)];
+    }
+
+    Snapshot snapshot() {
+        Snapshot total{};
+#ifdef ENGINE_STATS
+        Registry &r{registry()};
+        std::lock_guard lock{r.mutex};
+        total = r.retired;
+        for (const detail::Block *block: r.blocks) {
+            accumulate(total, *block);
+        }
+#endif
+        return total;
+    }
+
+    Snapshot thread_snapshot() {
+        Snapshot total{};
+#ifdef ENGINE_STATS
+        accumulate(total, detail::local());
+#endif
+        return total;
+    }
+
+    std::string to_json(const Snapshot &snapshot) {
+        std::ostringstream out{};
+        out << std::fixed << std::setprecision(3);
+        out << "{\"enabled\": " << (ENABLED ? "true" : "false")
+                << ", \"counters\": {";
+        for (int i = 0; i < NUM_COUNTERS; ++i) {
+            out << (i > 0 ? ", " : "") << '"' << COUNTER_NAMES[i] << "\": "
+                    << snapshot.counters[i];
+        }
+        out << "}, \"timers\": {";
+        for (int i = 0; i < NUM_TIMERS; ++i) {
+            out << (i > 0 ? ", " : "") << '"' << TIMER_NAMES[i]
+                    << "\": {\"scopes\": " << snapshot.scopes[i] << ", \"ms\": "
+                    << static_cast<double>(snapshot.nanoseconds[i]) / 1e6 << '}';
+        }
+
+        out << std::setprecision(4) << "}, \"rates\": {"
+                << "\"tt_hit_rate\": "
+                << ratio(snapshot[Counter::TT_HITS], snapshot[Counter::TT_PROBES])
+                << ", \"first_move_cutoff_rate\": "
+                << ratio(snapshot[Counter::FIRST_MOVE_CUTOFFS], snapshot[Counter::CUTOFFS])
+                << ", \"qnode_share\": "
+                << ratio(snapshot[Counter::QNODES], snapshot[Counter::NODES])
+                << ", \"moves_per_movegen\": "
+                << ratio(snapshot[Counter::MOVES_GENERATED], snapshot[Counter::MOVEGEN_CALLS])
+                << "}}";
+        return out.str();
+    }
+
+#ifdef ENGINE_STATS
+    namespace detail {
+        Block::Block() {
+            Registry &r{registry()};
+            std::lock_guard lock{r.mutex};
+            r.blocks.push_back(this);
+        }
+
+        Block::~Block() {
+            Registry &r{registry()};
+            std::lock_guard lock{r.mutex};
+            accumulate(r.retired, *this);
+            std::erase(r.blocks, this);
+        }
+    }
+#endif
+}
@@ -0,0 +1,160 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Counters and scoped timers on the engine's hot paths, to see where the
+// time goes without an external profiler. They are compiled in with the
+// ENGINE_STATS option; otherwise the STATS_ macros expand to nothing and
+// every snapshot is zero.
+//
+// Each thread counts into a block of its own, so counting never contends
+// with other threads. Snapshots sum the blocks of running threads and what
+// finished threads left behind. Timers are inclusive: movegen time includes
+// the attack queries made while generating.
+namespace stats {
+    enum class Counter : uint8_t {
+        MOVEGEN_CALLS,
+        MOVES_GENERATED,
+        LEGALITY_CHECKS,
+        ATTACK_QUERIES,
+        TT_PROBES,
+        TT_HITS,
+        // Stores that evict an entry of another position from the current
+        // search.
+        TT_COLLISIONS,
+        EVALUATIONS,
+        // Every node, including quiescence nodes.
+        NODES,
+        QNODES,
+        // Beta cutoffs in the main search's move loop, and those made by
+        // the first move searched.
+        CUTOFFS,
+        FIRST_MOVE_CUTOFFS
+    };
+
+    constexpr int NUM_COUNTERS{12};
+
+    enum class Timer : uint8_t {
+        MOVEGEN,
+        LEGALITY,
+        ATTACKS,
+        EVALUATION,
+        SEARCH
+    };
+
+    constexpr int NUM_TIMERS{5};
+
+#ifdef ENGINE_STATS
+    constexpr bool ENABLED{true};
+#else
+    constexpr bool ENABLED{false};
+#endif
+
+    struct Snapshot {
+        std::array<uint64_t, NUM_COUNTERS> counters{};
+        // Time spent in each timer's scopes, and how many there were.
+        std::array<uint64_t, NUM_TIMERS> nanoseconds{};
+        std::array<uint64_t, NUM_TIMERS> scopes{};
+
+        [[nodiscard]] uint64_t operator[](const Counter &counter) const;
+
+        // What was counted between two snapshots.
+        Snapshot operator-(const Snapshot &earlier) const;
+
+        // What was counted in either of two snapshots, such as those of
+        // different threads.
+        Snapshot operator+(const Snapshot &other) const;
+    };
+
+    [[nodiscard]] std::string_view name(const Counter &counter);
+
+    [[nodiscard]] std::string_view name(const Timer &timer);
+
+    // Totals over every thread.
+    [[nodiscard]] Snapshot snapshot();
+
+    // Totals of the calling thread only.
+    [[nodiscard]] Snapshot thread_snapshot();
+
+    // A JSON object with every counter, every timer and derived rates such
+    // as the TT hit rate and the first-move cutoff rate.
+    [[nodiscard]] std::string to_json(const Snapshot &snapshot);
+
+#ifdef ENGINE_STATS
+    namespace detail {
+        struct alignas(64) Block {
+            Block();
+
+            ~Block();
+
+            Block(const Block &) = delete;
+
+            Block &operator=(const Block &) = delete;
+
+            std::array<std::atomic<uint64_t>, NUM_COUNTERS> counters{};
+            std::array<std::atomic<uint64_t>, NUM_TIMERS> nanoseconds{};
+            std::array<std::atomic<uint64_t>, NUM_TIMERS> scopes{};
+        };
+
+        // The calling thread's block, registered on first use.
+        inline Block &local() {
+            thread_local Block block{};
+            return block;
+        }
+
+        // Only the owning thread writes, so this needs no atomic add.
+        inline void add(std::atomic<uint64_t> &value, const uint64_t &amount) {
+            value.store(value.load(std::memory_order_relaxed) + amount,
+                        std::memory_order_relaxed);
+        }
+    }
+
+    inline void count(const Counter &counter, const uint64_t &amount = 1) {
+        detail::add(detail::local().counters[static_cast<int>(counter)],
+                    amount);
+    }
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const Timer &timer)
+            : timer{timer}, start{std::chrono::steady_clock::now()} {}
+
+        ~ScopedTimer() {
+            const auto elapsed{std::chrono::steady_clock::now() - start};
+            detail::Block &block{detail::local()};
+            detail::add(block.nanoseconds[static_cast<int>(timer)],
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            elapsed).count());
+            detail::add(block.scopes[static_cast<int>(timer)], 1);
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        Timer timer;
+        std::chrono::steady_clock::time_point start;
+    };
+#endif
+}
+
+#ifdef ENGINE_STATS
+#define STATS_COUNT(counter) ::stats::count(::stats::Counter::counter)
+#define STATS_ADD(counter, amount) \
+    ::stats::count(::stats::Counter::counter, amount)
+#define STATS_TIME(timer) \
+    const ::stats::ScopedTimer stats_timer_##timer{::stats::Timer::timer}
+#else
+#define STATS_COUNT(counter) static_cast<void>(0)
+#define STATS_ADD(counter, amount) static_cast<void>(0)
+#define STATS_TIME(timer) static_cast<void>(0)
+#endif
+
+#endif //STATS_H